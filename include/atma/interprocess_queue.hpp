@@ -0,0 +1,345 @@
+#pragma once
+
+#include <atma/assert.hpp>
+#include <atma/lockfree_queue.hpp>
+#include <atma/platform/interprocess.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+import atma.types;
+
+namespace atma
+{
+	//
+	// interprocess_queue_t
+	// ----------------------
+	//  a lockfree_queue_t that lives in a named shared-memory region, so that what's
+	//  committed in one process can be consumed, in place, in another.
+	//
+	//  processes attach by opening the queue by name, and detach by destroying it.
+	//  each records the allocations and reads it's in the middle of, so attaching
+	//  (or calling recover) can find processes that died whilst attached, and
+	//  recover whatever they were in the middle of, while everyone else carries on:
+	//
+	//   - allocations consumed but never finalized are finalized
+	//   - allocations reserved but never committed are committed as padding. one
+	//     whose writer was still waiting on readers to make room is committed by
+	//     the first recover after they have
+	//
+	//  if none of the others are left, the queue is checked over as a whole, and if
+	//  a writer died before it could even mark its reservation, everything from
+	//  there on is given back, losing whatever was committed after it
+	//
+	//  a process can have at most claims_per_kind (8) allocations, and as many
+	//  reads, in flight at once. a thread wanting another waits until one of the
+	//  same kind is committed or finalized. writers waiting on readers to make
+	//  room don't hold up readers, but a thread that's in the middle of a read
+	//  mustn't wait on an allocation that only that read will make room for
+	//
+	//  queues are fixed-size, as growing would mean new regions that every process
+	//  would have to find. a region outlives its processes until it's removed
+	//
+	struct interprocess_queue_t : lockfree_queue_t
+	{
+		static constexpr uint32 max_attachments = 64;
+
+		// opens the queue called name, creating it with room for size bytes if it
+		// doesn't exist. returns null if the region can't be opened, isn't a queue,
+		// or already has max_attachments attached
+		static auto open(char const* name, uint32 size) -> std::unique_ptr<interprocess_queue_t>;
+
+		// see platform::remove_shared_mapping
+		static auto remove(char const* name) -> void;
+
+		interprocess_queue_t(interprocess_queue_t const&) = delete;
+		~interprocess_queue_t();
+
+		// number of attachments, including ours. attachments of processes that
+		// died are counted until what they were in the middle of is recovered
+		auto attachments() const -> uint32;
+
+		// recovers what processes that died whilst attached were in the middle of.
+		// attaching does this too, but a reader that finds the queue stuck behind
+		// an allocation that never gets committed can call it
+		auto recover() -> void;
+
+		// blocks are process-local, so can't be handed to another process
+		template <typename F>
+		auto with_large_allocation(size_t, F&&) -> bool = delete;
+
+	private:
+		struct segment_t;
+
+		interprocess_queue_t(char const* name, platform::shared_mapping_t&&, uint32 slot);
+
+		auto segment() const -> segment_t*;
+
+		// the queue's housekeeping is cache-line aligned
+		static constexpr size_t queue_offset();
+
+		static auto segment_init(segment_t*, size_t mapping_size) -> void;
+
+		// with the attach-lock held. alone is whether every other attachment is dead
+		auto recover_dead(bool alone) -> void;
+		static auto segment_lock(segment_t*, uint32 pid) -> void;
+		static auto segment_unlock(segment_t*, uint32 pid) -> void;
+
+	private:
+		platform::shared_mapping_t mapping_;
+		platform::interprocess_wakeups_t wakeups_;
+		uint32 slot_ = 0;
+	};
+
+
+	// segment_t
+	//
+	//  - the front of the region. the in-place queue follows it
+	//
+	struct interprocess_queue_t::segment_t
+	{
+		static constexpr uint32 magic_value = 0x716d7461; // "atmq"
+		static constexpr uint32 version_value = 4;
+		static constexpr uint32 initialize_timeout_ms = 1000;
+
+		uint32 magic;
+		uint32 version;
+
+		// the process initializing the segment, and whether it's done so. whoever
+		// created the region initializes it, unless it dies trying
+		std::atomic<uint32> initializer;
+		std::atomic<uint32> ready;
+
+		// process holding the attach-lock, if any
+		std::atomic<uint32> attach_lock;
+
+		uint32 buffer_size;
+		waiting_t waiting;
+
+		// process-ids of every attachment, zero for free slots
+		std::atomic<uint32> attachments[max_attachments];
+
+		// what each attachment is in the middle of
+		claim_t claims[max_attachments][claims_per_process];
+	};
+
+	constexpr size_t interprocess_queue_t::queue_offset()
+	{
+		return 64 * ((sizeof(segment_t) + 63) / 64);
+	}
+
+
+
+
+	inline auto interprocess_queue_t::open(char const* name, uint32 size) -> std::unique_ptr<interprocess_queue_t>
+	{
+		size = aml::alignby(size, 4);
+
+		auto mapping = platform::open_shared_mapping(name, queue_offset() + inplace_size(size));
+		if (!mapping || mapping.size() <= queue_offset() + inplace_size(0))
+			return nullptr;
+
+		auto seg = reinterpret_cast<segment_t*>(mapping.data());
+		auto const pid = platform::current_process_id();
+
+		// 1) initialize the segment, or wait for whoever is
+		auto const deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds{segment_t::initialize_timeout_ms};
+		while (!seg->ready.load(std::memory_order_acquire))
+		{
+			uint32 initializer = seg->initializer.load();
+			bool const stale = std::chrono::steady_clock::now() > deadline;
+
+			if ((mapping.created() && initializer == 0) || (stale && (initializer == 0 || !platform::process_alive(initializer))))
+			{
+				if (seg->initializer.compare_exchange_strong(initializer, pid))
+				{
+					segment_init(seg, mapping.size());
+					seg->ready.store(1, std::memory_order_release);
+					break;
+				}
+			}
+			else if (stale)
+			{
+				return nullptr;
+			}
+
+			std::this_thread::sleep_for(std::chrono::milliseconds{1});
+		}
+
+		if (seg->magic != segment_t::magic_value || seg->version != segment_t::version_value)
+			return nullptr;
+
+		// 2) attach. nobody else may attach (and so start using the queue) until
+		//    we've recovered it, if we're the only one here. the dead that were in
+		//    the middle of nothing can give up their slots straight away
+		segment_lock(seg, pid);
+
+		for (uint32 i = 0; i != max_attachments; ++i)
+		{
+			uint32 p = seg->attachments[i].load();
+			bool const idle = std::ranges::all_of(seg->claims[i], [](claim_t const& x) { return x.kind.load() == 0; });
+			if (p != 0 && idle && !platform::process_alive(p))
+				seg->attachments[i].compare_exchange_strong(p, 0);
+		}
+
+		uint32 slot = max_attachments;
+		uint32 others = 0;
+		for (uint32 i = 0; i != max_attachments; ++i)
+		{
+			uint32 p = 0;
+			if (slot == max_attachments && seg->attachments[i].compare_exchange_strong(p, pid))
+				slot = i;
+			else if (p != 0 && platform::process_alive(p))
+				++others;
+		}
+
+		std::unique_ptr<interprocess_queue_t> result;
+		if (slot != max_attachments)
+		{
+			result.reset(new interprocess_queue_t{name, std::move(mapping), slot});
+
+			// 3) crash-recovery check
+			if (others == 0)
+				result->impl_recover();
+
+			result->recover_dead(others == 0);
+		}
+
+		segment_unlock(seg, pid);
+
+		return result;
+	}
+
+	inline auto interprocess_queue_t::remove(char const* name) -> void
+	{
+		platform::remove_shared_mapping(name);
+	}
+
+	inline interprocess_queue_t::interprocess_queue_t(char const* name, platform::shared_mapping_t&& mapping, uint32 slot)
+		: lockfree_queue_t{mapping.data() + queue_offset(), &reinterpret_cast<segment_t*>(mapping.data())->waiting, &wakeups_, reinterpret_cast<segment_t*>(mapping.data())->claims[slot]}
+		, mapping_{std::move(mapping)}
+		, wakeups_{name}
+		, slot_{slot}
+	{}
+
+	inline interprocess_queue_t::~interprocess_queue_t()
+	{
+		// detach. the queue doesn't free in-place buffers, so the mapping can go first
+		uint32 pid = platform::current_process_id();
+		for (auto& x : segment()->claims[slot_])
+			impl_unclaim(&x);
+		segment()->attachments[slot_].compare_exchange_strong(pid, 0);
+	}
+
+	inline auto interprocess_queue_t::attachments() const -> uint32
+	{
+		uint32 r = 0;
+		for (auto const& x : segment()->attachments)
+			r += x.load() != 0;
+		return r;
+	}
+
+	inline auto interprocess_queue_t::recover() -> void
+	{
+		auto const pid = platform::current_process_id();
+		segment_lock(segment(), pid);
+		recover_dead(false);
+		segment_unlock(segment(), pid);
+	}
+
+	inline auto interprocess_queue_t::recover_dead(bool alone) -> void
+	{
+		auto seg = segment();
+
+		uint32 pids[max_attachments];
+		bool alive[max_attachments];
+		std::vector<claim_t const*> live, dead;
+		for (uint32 i = 0; i != max_attachments; ++i)
+		{
+			pids[i] = seg->attachments[i].load();
+			alive[i] = pids[i] == 0 || platform::process_alive(pids[i]);
+
+			if (pids[i] != 0)
+			{
+				for (auto const& x : seg->claims[i])
+					(alive[i] ? live : dead).push_back(&x);
+			}
+		}
+
+		for (uint32 i = 0; i != max_attachments; ++i)
+		{
+			if (alive[i])
+				continue;
+
+			// the queue's been checked over as a whole, so there's nothing to recover.
+			// otherwise, a slot is only given up once everything in it is recovered
+			bool recovered = true;
+			for (auto& x : seg->claims[i])
+			{
+				if (alone)
+					impl_unclaim(&x);
+				else if (!impl_recover_claim(x, live, dead))
+					recovered = false;
+			}
+
+			if (recovered)
+				seg->attachments[i].compare_exchange_strong(pids[i], 0);
+		}
+	}
+
+	inline auto interprocess_queue_t::segment() const -> segment_t*
+	{
+		return reinterpret_cast<segment_t*>(mapping_.data());
+	}
+
+	inline auto interprocess_queue_t::segment_init(segment_t* seg, size_t mapping_size) -> void
+	{
+		// a region may be bigger than asked for (rounded to pages), so use all of it
+		auto buffer_size = (uint32)std::min<size_t>(mapping_size - queue_offset() - inplace_size(0), 0xfffffffc) & ~3u;
+
+		seg->magic = segment_t::magic_value;
+		seg->version = segment_t::version_value;
+		seg->attach_lock.store(0);
+		seg->buffer_size = buffer_size;
+		seg->waiting.sleepers.store(0);
+		seg->waiting.wakeups.store(0);
+		seg->waiting.notifies.store(0);
+		for (auto& x : seg->attachments)
+			x.store(0);
+		for (auto& xs : seg->claims)
+			for (auto& x : xs)
+				x.span.store(0), x.kind.store(0);
+
+		inplace_init((byte*)seg + queue_offset(), buffer_size);
+	}
+
+	inline auto interprocess_queue_t::segment_lock(segment_t* seg, uint32 pid) -> void
+	{
+		for (uint32 holder = 0; !seg->attach_lock.compare_exchange_weak(holder, pid); )
+		{
+			// a process that died attaching never lets go
+			if (holder != 0 && !platform::process_alive(holder))
+			{
+				if (seg->attach_lock.compare_exchange_strong(holder, pid))
+					break;
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+
+			holder = 0;
+		}
+	}
+
+	inline auto interprocess_queue_t::segment_unlock(segment_t* seg, uint32 pid) -> void
+	{
+		bool r = seg->attach_lock.compare_exchange_strong(pid, 0);
+		(void)r;
+		ATMA_ASSERT(r);
+	}
+}
@@ -4,15 +4,31 @@
 #include <atma/atomic.hpp>
 #include <atma/config/platform.hpp>
 #include <atma/math/functions.hpp>
+#include <atma/platform/wait.hpp>
+#include <atma/shared_memory.hpp>
 
 #include <chrono>
 #include <thread>
 #include <algorithm>
+#include <array>
 #include <atomic>
+#include <bit>
+#include <memory>
+#include <optional>
+#include <span>
+#include <type_traits>
 
 import atma.types;
 import atma.memory;
 
+
+// counters for working out why a queue stalls, read through stats(). they cost
+// nothing unless enabled, not even space. the queue's layout differs with them,
+// so they must be enabled (or not) for every translation unit
+#if !defined(ATMA_LOCKFREE_QUEUE_STATS)
+#  define ATMA_LOCKFREE_QUEUE_STATS false
+#endif
+
 namespace atma
 {
 	
@@ -22,15 +38,52 @@ namespace atma
 	{
 		struct allocation_t;
 		struct decoder_t;
+		struct batch_t;
+		struct stats_t;
+		struct lanes_t { uint32 count; };
+
+		// what allocation_t::encode_memory writes
+		static constexpr uint32 memory_handle_size = (uint32)sizeof(shared_memory_t::released_t);
 
 		base_lockfree_queue_t();
 		base_lockfree_queue_t(void*, uint32);
 		base_lockfree_queue_t(uint32);
 
+		// growable queue: starts at size bytes, and links in larger buffers (up to
+		// max_size bytes) when full, rather than making writers wait for readers.
+		// an allocation that wouldn't fit even in a max_size buffer comes back empty
+		base_lockfree_queue_t(uint32 size, uint32 max_size);
+
+		// sharded queue: a buffer of lane_size bytes per lane. a producer thread always
+		// allocates from the same lane, and consumers go round the lanes in turn, so
+		// each thread's allocations are consumed in order, but not in order with others
+		base_lockfree_queue_t(uint32 lane_size, lanes_t);
+
+		base_lockfree_queue_t(base_lockfree_queue_t const&) = delete;
+		~base_lockfree_queue_t();
+
 		auto commit(allocation_t&) -> void;
 		auto consume() -> decoder_t;
 		auto finalize(decoder_t&) -> void;
 
+		// consumes, waiting up to timeout for something to arrive. spins briefly, then
+		// parks the thread until a writer commits. a reader beaten to an allocation goes
+		// back to waiting. returns nothing if it times out, or is woken by notify_all
+		auto consume_wait(std::chrono::nanoseconds timeout) -> decoder_t;
+
+		// wakes all threads parked in consume_wait
+		auto notify_all() -> void;
+
+		// consumes up to max_count allocations, stopping early once another would take the
+		// batch over max_bytes (a batch always holds at least one). the whole batch is
+		// claimed, and later cleared, with a handful of atomic operations
+		auto consume_batch(uint32 max_count, uint32 max_bytes = 0xffffffff) -> batch_t;
+		auto finalize_batch(batch_t&) -> void;
+
+		// a snapshot, safe to take from any thread. only bytes_in_flight is
+		// counted without ATMA_LOCKFREE_QUEUE_STATS
+		auto stats() -> stats_t;
+
 	protected:
 		struct headerer_t;
 		struct housekeeping_t;
@@ -44,9 +97,10 @@ namespace atma
 		// HEADER
 		//
 		//  2 bits: alloc-state {empty, flag_commit, full, mid_read}
-		//  2 bits: alloc-type {invalid, normal, jump, pad}
+		//  3 bits: alloc-type {invalid, normal, jump, pad, large}
 		//  2 bits: alignment (exponent for 4*2^x, giving us 4, 8, 16, or 32 bytes alignment)
-		// 28 bits: size (allowing up to 64mb allocations)
+		// 25 bits: size (allowing up to 32mb allocations. larger bodies go out-of-line,
+		//          see lockfree_queue_t::with_large_allocation)
 		//
 		// state:
 		//  - explicit in alloc-state, except for an empty state with the alloc-type
@@ -55,6 +109,15 @@ namespace atma
 		//  - empty +  pad  =>  ready for commit
 		//  - empty + jump  =>  ready for finalize
 		//
+		// jump:
+		//  - a full jump is the last allocation in a buffer of a growable queue. its
+		//    body is the pointer to, and size of, the next buffer. writers keep room
+		//    for one after every allocation, so a full buffer can always jump
+		//
+		// large:
+		//  - a normal allocation, as far as the user is concerned, whose body is the
+		//    handle of a block holding the message. see allocation_t::encode_memory
+		//
 		enum class allocstate_t : uint32
 		{
 			empty,
@@ -69,6 +132,7 @@ namespace atma
 			normal,
 			jump,
 			pad,
+			large,
 		};
 
 		enum class allocerr_t : uint32
@@ -90,12 +154,16 @@ namespace atma
 		static constexpr uint32 header_size = 4;
 		static constexpr uint32 header_state_bitsize = 2;
 		static constexpr uint32 header_state_bitshift = 30;
-		static constexpr uint32 header_type_bitsize = 2;
-		static constexpr uint32 header_type_bitshift = 28;
+		static constexpr uint32 header_type_bitsize = 3;
+		static constexpr uint32 header_type_bitshift = 27;
 		static constexpr uint32 header_alignment_bitsize = 2;
-		static constexpr uint32 header_alignment_bitshift = 26;
-		static constexpr uint32 header_size_bitsize = 26;
+		static constexpr uint32 header_alignment_bitshift = 25;
+		static constexpr uint32 header_size_bitsize = 25;
 		static constexpr uint32 jump_command_body_size = sizeof(void*) + sizeof(uint32);
+		static constexpr uint32 jump_command_size = header_size + jump_command_body_size;
+
+		// histogram of allocation sizes: a bucket for zero, then one per power of two
+		static constexpr uint32 size_buckets = header_size_bitsize + 1;
 
 		static constexpr uint32 header_state_bitmask = aml::pow2(header_state_bitsize) - 1;
 		static constexpr uint32 header_type_bitmask = aml::pow2(header_type_bitsize) - 1;
@@ -107,19 +175,101 @@ namespace atma
 
 		std::chrono::nanoseconds const starve_timeout{5000};
 
+		// how many times consume_wait tries to consume before parking
+		static constexpr uint32 consume_wait_spins = 64;
+
+		// wakes every reader parked in consume_wait
+		auto impl_wake() -> void;
+
 		auto impl_read_queue_write_info() -> std::tuple<byte*, uint32, uint32>;
 		auto impl_read_queue_read_info() -> std::tuple<byte*, uint32, uint32>;
 		auto impl_make_allocation(byte* wb, uint32 wbs, uint32 wp, alloctype_t, uint32 alignment, uint32 size) -> allocation_t;
-		auto impl_encode_jump(uint32 available, byte* wb, uint32 wbs, uint32 wp) -> void;
+		auto impl_make_allocation() -> allocation_t;
+
+		auto impl_consume(byte* rb) -> decoder_t;
+		auto impl_consume_batch(byte* rb, uint32 max_count, uint32 max_bytes) -> batch_t;
+
+		// the lane the calling thread allocates from
+		auto impl_producer_lane() const -> byte*;
+
+	protected:
+		// readers parked in consume_wait, and the address they're parked on. writers
+		// only touch wakeups if there's a sleeper, which means the queue was empty.
+		// notifies counts calls to notify_all, which send readers home empty-handed
+		struct waiting_t
+		{
+			std::atomic<uint32> sleepers{0};
+			std::atomic<uint32> wakeups{0};
+			std::atomic<uint32> notifies{0};
+		};
+
+		// what a process is in the middle of, in an in-place queue shared between
+		// processes. before moving the write- or read-pointer, a thread records
+		// where it's moving it from and to, and keeps the claim until it commits or
+		// finalizes. span is [begin, end) in cursors, packed as end << 32 | begin,
+		// and is empty while the claim isn't for anything yet. once the pointer is
+		// moved the claim is held, and no other held claim can have the same span
+		enum class claimkind_t : uint32
+		{
+			none,
+			write,
+			read,
+		};
+
+		static constexpr uint32 claim_held_bit = 0x100;
+
+		struct claim_t
+		{
+			std::atomic<uint32> kind{0};
+			std::atomic<uint64> span{0};
+		};
+
+		static_assert(std::atomic<uint64>::is_always_lock_free, "claims are shared between processes");
+
+		// a process has at most half this many allocations in flight at once, and
+		// half this many reads. any more wait for one of their own kind to finish.
+		// writers keep their claim while they wait for readers to make room, so the
+		// halves are kept apart, or blocked writers could keep readers from claiming
+		static constexpr uint32 claims_per_process = 16;
+		static constexpr uint32 claims_per_kind = claims_per_process / 2;
+
+		// in-place queue: the housekeeping lives at the front of the memory given,
+		// followed by the buffer. nothing in there is a pointer, so it works the same
+		// from wherever it's mapped, and is never freed by the queue. readers parked
+		// on it are woken through wakeups, which must outlive the queue, as must the
+		// claims_per_process claims this process records its work in
+		base_lockfree_queue_t(void* mem, waiting_t*, platform::interprocess_wakeups_t const* wakeups, claim_t* claims);
+
+		static auto inplace_size(uint32 buffer_size) -> uint32;
+		static auto inplace_init(void* mem, uint32 buffer_size) -> void;
+
+		// brings an in-place queue back to a consistent state after its other users
+		// have died. must only be called when nobody else is using the queue
+		auto impl_recover() -> void;
+
+		// recovers what a process that died was in the middle of, according to one
+		// of its claims, while others carry on using the queue. live are the claims
+		// of every process still attached, and dead those of every process that
+		// isn't. returns false if the claim can't be recovered yet (say, if a live
+		// process may have beaten it, or readers have yet to make room for it)
+		auto impl_recover_claim(claim_t& claim, std::span<claim_t const* const> live, std::span<claim_t const* const> dead) -> bool;
 
 	private:
 		base_lockfree_queue_t(void*, uint32, bool);
 
+		// a buffer is prefixed with the offset of its housekeeping
+		using housekeeping_offset_t = std::ptrdiff_t;
+
 		static auto buf_init(void*, uint32, bool) -> void*;
 		static auto buf_housekeeping(void*) -> housekeeping_t*;
+		static auto buf_free(housekeeping_t*) -> void;
+		static auto buf_reset(housekeeping_t*) -> void;
 
 		static auto available_space(uint32 wp, uint32 ep, uint32 bufsize, bool contiguous) -> uint32;
 
+		// small, stable, per-thread number
+		static auto thread_ordinal() -> uint32;
+
 	protected:
 		struct header_t
 		{
@@ -143,14 +293,26 @@ namespace atma
 
 		using cursor_t = uint32;
 
-		auto impl_allocate_default(housekeeping_t*, cursor_t const& w, cursor_t const& e, uint32 size, uint32 alignment, bool ct) -> allocinfo_t;
+		// claims are only kept by in-place queues shared between processes, and
+		// are otherwise null. a claim is let go of by where it begins
+		auto impl_claim(claimkind_t) -> claim_t*;
+		auto impl_claim_span(claim_t*, cursor_t begin, cursor_t end) -> void;
+		auto impl_claim_hold(claim_t*) -> void;
+		auto impl_unclaim(claim_t*) -> void;
+		auto impl_unclaim(claimkind_t, housekeeping_t*, uint32 begin_position) -> void;
+
+		auto impl_allocate_default(housekeeping_t*, cursor_t const& w, cursor_t const& e, uint32 size, uint32 alignment, bool ct, uint32 reserve = 0) -> allocinfo_t;
 		auto impl_allocate_pad(housekeeping_t*, cursor_t const& w, cursor_t const& e) -> allocinfo_t;
-		auto impl_allocate(housekeeping_t*, cursor_t const& w, cursor_t const& e, uint32 size, uint32 alignment, bool ct) -> allocinfo_t;
+		auto impl_allocate(housekeeping_t*, cursor_t const& w, cursor_t const& e, uint32 size, uint32 alignment, bool ct, uint32 reserve = 0) -> allocinfo_t;
 
-		struct alignas(16) housekeeping_t
+		auto impl_zero_body(housekeeping_t*, uint32 op, uint32 size) -> void;
+		auto impl_advance_empty(housekeeping_t*) -> void;
+
+		// cache-line aligned, so that lanes don't contend with each other
+		struct alignas(64) housekeeping_t
 		{
 			housekeeping_t(byte* buffer, uint32 buffer_size, bool requires_delete)
-				: buffer_{buffer}
+				: buffer_{(intptr_t)buffer - (intptr_t)this}
 				, buffer_size_{buffer_size}
 				, requires_delete_{requires_delete}
 				, w{}, f{}, r{}, e{buffer_size}
@@ -160,13 +322,25 @@ namespace atma
 			cursor_t f; // full
 			cursor_t r; // read
 			cursor_t e; // empty
+
+			// growable queues only
+			//
+			// once closed, no more allocations are made from this buffer, as a jump
+			// to the next buffer is (or is about to be) its last allocation. the
+			// buffer is freed once both writing_ and reading_ have moved past it, and
+			// everyone who acquired it has released it. see impl_retire
+			uint32 closed = 0;
+			std::atomic<int64> writers{0};
+			std::atomic<int64> readers{0};
+			housekeeping_t* next = nullptr;
 		
-			auto buffer() const -> byte* { return buffer_; }
+			auto buffer() const -> byte* { return (byte*)((intptr_t)this + buffer_); }
 			auto buffer_size() const -> uint32 { return buffer_size_; }
 			auto requires_delete() const -> bool { return requires_delete_; }
 
 		private:
-			byte* buffer_ = nullptr;
+			// relative to us, so that in-place queues can be mapped anywhere
+			int64 buffer_ = 0;
 			uint32 buffer_size_ = 0;
 			bool requires_delete_ = false;
 		};
@@ -180,7 +354,7 @@ namespace atma
 				, uses()
 			{}
 
-			auto housekeeping() -> housekeeping_t* { return *((housekeeping_t**)pointer - 1); }
+			auto housekeeping() const -> housekeeping_t* { return buf_housekeeping(pointer); }
 
 			union
 			{
@@ -193,7 +367,51 @@ namespace atma
 			};
 		};
 
+		// growable queues count their uses of each buffer
+		auto impl_acquire(buffer_t&) -> buffer_t;
+		auto impl_retire(buffer_t&, byte* next, uint64 uses) -> buffer_t;
+		auto impl_adjust_writers(housekeeping_t*, int64) -> void;
+		auto impl_adjust_readers(housekeeping_t*, int64) -> void;
+		auto impl_grow(buffer_t const&, uint32 size, uint32 alignment, bool contiguous) -> void;
+
+		// the most room an allocation can take in a growable queue's buffer: its
+		// header, padding up to alignment (or, if contiguous, to the end of the
+		// buffer first), and the reserve after it for a jump
+		static auto impl_growable_footprint(uint32 size, uint32 alignment, bool contiguous) -> uint64;
+
 		buffer_t writing_, reading_;
+
+		// largest buffer a growable queue may grow to, zero for fixed-size queues
+		uint32 growth_limit_ = 0;
+
+		// sharded queues only. the first lane is also writing_/reading_
+		std::unique_ptr<byte*[]> lanes_;
+		uint32 lane_count_ = 0;
+		std::atomic<uint32> read_lane_{0};
+
+#if ATMA_LOCKFREE_QUEUE_STATS
+		struct counters_t
+		{
+			std::atomic<uint64> cas_retries{0};
+			std::atomic<uint64> starve_timeouts{0};
+			std::atomic<uint64> pads{0};
+			std::atomic<uint64> jumps{0};
+			std::atomic<uint64> high_water_bytes{0};
+			std::atomic<uint64> sizes[size_buckets]{};
+		};
+
+		counters_t counters_;
+#endif
+
+		// in-place queues keep their waiting state alongside their buffer
+		waiting_t local_waiting_;
+		waiting_t* waiting_ = &local_waiting_;
+		platform::interprocess_wakeups_t const* interprocess_wakeups_ = nullptr;
+		claim_t* claims_ = nullptr;
+		bool inplace_ = false;
+
+		// whether there may be large allocations that still hold their block
+		std::atomic<bool> carries_large_{false};
 	};
 
 
@@ -251,10 +469,16 @@ namespace atma
 		auto encode_data(unique_memory_t const&) -> void;
 		template <typename T> auto encode_pointer(T*) -> void;
 
+		// hands the block over to whoever consumes this allocation, leaving mem empty,
+		// and makes this a large allocation. only the block's handle is written, which
+		// takes memory_handle_size bytes, and is all this allocation may hold
+		auto encode_memory(shared_memory_t&& mem) -> void;
+
 		// forward-construct. requires contiguous memory.
 		template <typename T> auto encode_struct(T&&) -> bool;
 
 	private:
+		allocation_t();
 		allocation_t(byte* buf, uint32 wp, allocstate_t, alloctype_t, uint32 alignment, uint32 size);
 
 		friend struct base_lockfree_queue_t;
@@ -277,6 +501,12 @@ namespace atma
 		template <typename T> auto decode_pointer(T*&) -> void;
 		auto decode_data() -> unique_memory_t;
 
+		// whether this is a large allocation, holding nothing but a block's handle
+		auto is_large() const -> bool { return type() == alloctype_t::large; }
+
+		// takes the block handed over by encode_memory. large allocations only
+		auto decode_memory() -> shared_memory_t;
+
 		template <typename T> auto decode_struct(T&) -> void;
 
 		auto local_copy(unique_memory_t& mem) -> void
@@ -295,6 +525,90 @@ namespace atma
 	};
 
 
+	// batch_t
+	struct base_lockfree_queue_t::batch_t
+	{
+		struct iterator;
+
+		batch_t(batch_t const&) = delete;
+		batch_t(batch_t&&);
+		~batch_t();
+
+		operator bool() const { return count_ != 0; }
+
+		auto size() const -> uint32 { return count_; }
+		auto begin() const -> iterator;
+		auto end() const -> iterator;
+
+	private:
+		batch_t() = default;
+		batch_t(byte* buf, cursor_t begin, cursor_t end, uint32 count, byte* next)
+			: buf_{buf}, begin_{begin}, end_{end}, count_{count}, next_{next}
+		{}
+
+	private:
+		byte* buf_ = nullptr;
+		// range of cursors, which may contain pads, and end with a jump
+		cursor_t begin_ = 0, end_ = 0;
+		uint32 count_ = 0;
+		// the buffer we're jumping to, if any
+		byte* next_ = nullptr;
+
+		friend struct base_lockfree_queue_t;
+	};
+
+	// batch_t::iterator
+	//
+	//  - yields a decoder for each allocation in the batch. the decoders
+	//    are finalized with the batch, not individually
+	//
+	struct base_lockfree_queue_t::batch_t::iterator
+	{
+		iterator(iterator&&) = default;
+		~iterator();
+
+		auto operator*() -> decoder_t& { return *decoder_; }
+		auto operator++() -> iterator&;
+		auto operator==(iterator const& rhs) const -> bool { return c_ == rhs.c_; }
+
+	private:
+		iterator(byte* buf, cursor_t c, cursor_t end);
+
+		auto skip_() -> void;
+
+	private:
+		byte* buf_ = nullptr;
+		cursor_t c_ = 0, end_ = 0;
+		std::optional<decoder_t> decoder_;
+
+		friend struct batch_t;
+	};
+
+
+	// stats_t
+	struct base_lockfree_queue_t::stats_t
+	{
+		// allocations that lost the compare-and-swap of the write-cursor, and went again
+		uint64 cas_retries = 0;
+
+		// allocations that waited longer than starve_timeout for readers to make room
+		uint64 starve_timeouts = 0;
+
+		// padding written to keep contiguous allocations from wrapping, and jumps to
+		// larger buffers (growable queues only)
+		uint64 pads = 0;
+		uint64 jumps = 0;
+
+		// allocated (or waiting to be), but not yet finalized, and the most there's been
+		// in any one buffer. growable queues only count their read & write buffers
+		uint64 bytes_in_flight = 0;
+		uint64 high_water_bytes = 0;
+
+		// bucket i counts allocations of [2^(i-1), 2^i) bytes, and bucket zero those of zero
+		std::array<uint64, size_buckets> sizes{};
+	};
+
+
 
 
 	inline base_lockfree_queue_t::base_lockfree_queue_t()
@@ -308,9 +622,38 @@ namespace atma
 		: base_lockfree_queue_t{new byte[sz]{}, sz, true}
 	{}
 
+	inline base_lockfree_queue_t::base_lockfree_queue_t(uint32 size, uint32 max_size)
+		: base_lockfree_queue_t{size}
+	{
+		ATMA_ASSERT(size <= max_size);
+		ATMA_ASSERT(writing_.housekeeping()->buffer_size() >= jump_command_size);
+		ATMA_ASSERT(writing_.housekeeping()->buffer_size() % 4 == 0);
+
+		// buffers stay a multiple of four bytes, so headers are never split
+		growth_limit_ = (max_size - (uint32)sizeof(housekeeping_offset_t)) & ~3u;
+
+		// the reader holds one use on behalf of all writers, which they give
+		// back once they've all moved on from the buffer
+		writing_.uses = 1;
+		reading_.uses = 2;
+	}
+
+	inline base_lockfree_queue_t::base_lockfree_queue_t(uint32 lane_size, lanes_t lanes)
+		: base_lockfree_queue_t{lane_size}
+	{
+		ATMA_ASSERT(lanes.count > 0);
+
+		lanes_.reset(new byte*[lanes.count]);
+		lanes_[0] = writing_.pointer;
+		for (uint32 i = 1; i != lanes.count; ++i)
+			lanes_[i] = (byte*)buf_init(new byte[lane_size]{}, lane_size, true);
+
+		lane_count_ = lanes.count;
+	}
+
 	inline base_lockfree_queue_t::base_lockfree_queue_t(void* buf, uint32 size, bool requires_delete)
 	{
-		ATMA_ASSERT(size > sizeof(housekeeping_t*));
+		ATMA_ASSERT(size > sizeof(housekeeping_offset_t));
 
 		auto nbuf = buf_init(buf, size, requires_delete);
 
@@ -318,19 +661,105 @@ namespace atma
 		reading_.pointer = (byte*)nbuf;
 	}
 
+	inline base_lockfree_queue_t::base_lockfree_queue_t(void* mem, waiting_t* waiting, platform::interprocess_wakeups_t const* wakeups, claim_t* claims)
+		: waiting_{waiting}
+		, interprocess_wakeups_{wakeups}
+		, claims_{claims}
+		, inplace_{true}
+	{
+		auto nbuf = (byte*)mem + sizeof(housekeeping_t) + sizeof(housekeeping_offset_t);
+
+		writing_.pointer = nbuf;
+		reading_.pointer = nbuf;
+	}
+
+	inline base_lockfree_queue_t::~base_lockfree_queue_t()
+	{
+		if (reading_.pointer == nullptr || inplace_)
+			return;
+
+		// large allocations nobody consumed still hold a reference to their block
+		if (carries_large_.load())
+		{
+			while (auto D = consume())
+			{
+				if (D.is_large())
+					D.decode_memory();
+				finalize(D);
+			}
+		}
+
+		for (uint32 i = 1; i < lane_count_; ++i)
+			buf_free(buf_housekeeping(lanes_[i]));
+
+		// buffers we've jumped past have been freed by now. free the rest of
+		// the chain, up to and including the one we're writing to
+		for (auto hk = buf_housekeeping(reading_.pointer); hk != nullptr; )
+		{
+			auto next = hk->next;
+			buf_free(hk);
+			hk = next;
+		}
+	}
+
 	inline auto base_lockfree_queue_t::buf_init(void* buf, uint32 size, bool requires_delete) -> void*
 	{
-		size -= sizeof(housekeeping_t*);
-		auto addr = (byte*)((housekeeping_t**)buf + 1);
-		*reinterpret_cast<housekeeping_t**>(buf) = atma::aligned_allocator_t<housekeeping_t>().allocate(1); //new housekeeping_t{addr, size, requires_delete};
-		new (*reinterpret_cast<housekeeping_t**>(buf)) housekeeping_t{addr, size, requires_delete};
+		size -= sizeof(housekeeping_offset_t);
+		auto addr = (byte*)buf + sizeof(housekeeping_offset_t);
+		auto hk = atma::aligned_allocator_t<housekeeping_t>().allocate(1);
+		new (hk) housekeeping_t{addr, size, requires_delete};
+		*reinterpret_cast<housekeeping_offset_t*>(buf) = (intptr_t)addr - (intptr_t)hk;
 
 		return addr;
 	}
 
 	inline auto base_lockfree_queue_t::buf_housekeeping(void* buf) -> housekeeping_t*
 	{
-		return *((housekeeping_t**)buf - 1);
+		return (housekeeping_t*)((intptr_t)buf - *((housekeeping_offset_t*)buf - 1));
+	}
+
+	inline auto base_lockfree_queue_t::buf_free(housekeeping_t* hk) -> void
+	{
+		if (hk->requires_delete())
+			delete[] (hk->buffer() - sizeof(housekeeping_offset_t));
+
+		hk->~housekeeping_t();
+		atma::aligned_allocator_t<housekeeping_t>().deallocate(hk, 1);
+	}
+
+	inline auto base_lockfree_queue_t::buf_reset(housekeeping_t* hk) -> void
+	{
+		memset(hk->buffer(), 0, hk->buffer_size());
+		hk->w = hk->f = hk->r = 0;
+		hk->e = hk->buffer_size();
+		std::atomic_thread_fence(std::memory_order_release);
+	}
+
+	inline auto base_lockfree_queue_t::inplace_size(uint32 buffer_size) -> uint32
+	{
+		return (uint32)(sizeof(housekeeping_t) + sizeof(housekeeping_offset_t)) + buffer_size;
+	}
+
+	inline auto base_lockfree_queue_t::inplace_init(void* mem, uint32 buffer_size) -> void
+	{
+		ATMA_ASSERT((uintptr_t)mem % alignof(housekeeping_t) == 0);
+		ATMA_ASSERT(buffer_size > 0 && buffer_size % 4 == 0);
+
+		auto hk = new (mem) housekeeping_t{(byte*)mem + sizeof(housekeeping_t) + sizeof(housekeeping_offset_t), buffer_size, false};
+		*reinterpret_cast<housekeeping_offset_t*>(hk->buffer() - sizeof(housekeeping_offset_t)) = sizeof(housekeeping_t) + sizeof(housekeeping_offset_t);
+		memset(hk->buffer(), 0, buffer_size);
+	}
+
+	inline auto base_lockfree_queue_t::thread_ordinal() -> uint32
+	{
+		static std::atomic<uint32> next{0};
+		thread_local uint32 const ordinal = next.fetch_add(1);
+		return ordinal;
+	}
+
+	inline auto base_lockfree_queue_t::impl_producer_lane() const -> byte*
+	{
+		return lanes_[thread_ordinal() % lane_count_];
 	}
 
 	inline auto base_lockfree_queue_t::available_space(uint32 wp, uint32 ep, uint32 bufsize, bool contiguous) -> uint32
@@ -345,26 +774,40 @@ namespace atma
 
 	inline auto base_lockfree_queue_t::consume() -> decoder_t
 	{
-		// 1) load read-buffer, and increment use-count
-		buffer_t buf;
-#if 1 // I think we can get away with just the atomic-load of the buffer?
-		atma::atomic_load_128(&buf, &reading_);
-#else
-		for (;;)
+		// sharded queues start with the lane after the last one consumed from, so
+		// that a busy lane can't starve the others
+		if (lane_count_)
 		{
-			if (buf.uses == invalid_use_count)
-				return decoder_t{};
-
-			auto nbuf = buf;
-			++nbuf.uses;
+			uint32 start = read_lane_.load(std::memory_order_relaxed);
+			for (uint32 i = 0; i != lane_count_; ++i)
+			{
+				uint32 lane = (start + i) % lane_count_;
+				if (auto D = impl_consume(lanes_[lane]))
+				{
+					read_lane_.store(lane + 1, std::memory_order_relaxed);
+					return D;
+				}
+			}
 
-			if (atma::atomic_compare_exchange(&reading_, buf, nbuf, &buf))
-				break;
+			return decoder_t{};
 		}
-#endif
 
-		byte* rb = buf.pointer;
-		
+		// 1) load read-buffer, and increment use-count
+		//
+		//  - fixed-size queues only ever have the one buffer, so we can get away
+		//    with just the atomic-load of the buffer
+		//
+		buffer_t buf;
+		if (growth_limit_)
+			buf = impl_acquire(reading_);
+		else
+			atma::atomic_load_128(&buf, &reading_);
+
+		return impl_consume(buf.pointer);
+	}
+
+	inline auto base_lockfree_queue_t::impl_consume(byte* rb) -> decoder_t
+	{
 		// 2) load housekeeping & queue-state
 		housekeeping_t* hk = buf_housekeeping(rb);
 
@@ -376,6 +819,7 @@ namespace atma
 		// we will discard this if rp has moved (and ac has updated)
 		cursor_t r = atma::atomic_load(&hk->r);
 		cursor_t e = atma::atomic_load(&hk->e);
+		claim_t* claim = impl_claim(claimkind_t::read);
 
 		for (;;)
 		{
@@ -390,12 +834,20 @@ namespace atma
 			header_t h = atma::atomic_load(hp);
 			std::atomic_thread_fence(std::memory_order_seq_cst);
 			if (h.state != allocstate_t::full)
+			{
+				impl_unclaim(claim);
+				if (growth_limit_)
+					impl_adjust_readers(hk, -1);
 				return decoder_t{};
+			}
 
 			// update read-pointer
 			cursor_t nr = (r + header_size + h.size);
+			impl_claim_span(claim, r, nr);
 			if (atma::atomic_compare_exchange(&hk->r, r, nr, &r))
 			{
+				impl_claim_hold(claim);
+
 				// update allocation to "mid-read"
 				auto nh = h;
 				nh.state = allocstate_t::mid_read;
@@ -413,32 +865,25 @@ namespace atma
 		{
 			case alloctype_t::invalid:
 			case alloctype_t::normal:
+			case alloctype_t::large:
 				break;
 			
 			// jump to the encoded, larger, read-buffer
+			//
+			//  - we're the only reader to see this jump, and everything before it
+			//    has been consumed. other readers may still be mid-read in the old
+			//    buffer, so we retire it rather than free it
+			//
 			case alloctype_t::jump:
 			{
-#if 0
-				uint64 ptr;
-				uint32 size;
-				D.decode_uint64(ptr);
-				D.decode_uint32(size);
+				byte* nb = nullptr;
+				D.decode_pointer(nb);
 				finalize(D);
-				
-				// we must wait until *no* read threads are mid-read before
-				// switching the read-buffer out from under them
-				auto oldbuf = rb;
-				while (!atma::atomic_compare_exchange(&read_info_,
-					atma::atomic128_t{(uint64)read_buf_, read_buf_size_ & 0x0fffffff, read_position_},
-					atma::atomic128_t{ptr, size, 0}))
-					;
-
-				if (owner_)
-					delete[] oldbuf;
-				owner_ = true;
+
+				auto old = impl_retire(reading_, nb, 2);
+				ATMA_ASSERT(old.pointer == rb);
+				impl_adjust_readers(hk, (int64)old.uses - 1);
 				return consume();
-#endif
-				break;
 			}
 
 			case alloctype_t::pad:
@@ -459,15 +904,7 @@ namespace atma
 		ATMA_ASSERT((uint64)hp % 4 == 0);
 
 		// 2) zero-out memory (very required), except header
-		//  - use acquire/release so that all memsets get visible
-		auto size_wrap   = std::max((D.op_ + header_size + D.raw_size()) - (int64)hk->buffer_size(), 0ll);
-		auto size_middle = std::max(D.raw_size() - size_wrap, 0ll);
-		ATMA_ASSERT(D.op_ + size_middle <= hk->buffer_size());
-
-		std::atomic_thread_fence(std::memory_order_acquire);
-		memset(D.buf_ + (D.op_ + header_size) % hk->buffer_size(), 0, size_middle);
-		memset(D.buf_, 0, size_wrap);
-		std::atomic_thread_fence(std::memory_order_release);
+		impl_zero_body(hk, D.op_, D.raw_size());
 
 		// atomically set the header to "ready to clear", which is encoded as an "empty jump"
 		header_t h = atma::atomic_load(hp);
@@ -481,6 +918,190 @@ namespace atma
 		//ATMA_ASSERT(oh.state == allocstate_t::mid_read);
 
 		// 3) move empty-position along
+		impl_advance_empty(hk);
+		impl_unclaim(claimkind_t::read, hk, D.op_);
+
+		D.type_ = 0;
+
+		// 4) the decoder's use of the buffer ends here
+		if (growth_limit_)
+			impl_adjust_readers(hk, -1);
+	}
+
+	inline auto base_lockfree_queue_t::consume_batch(uint32 max_count, uint32 max_bytes) -> batch_t
+	{
+		ATMA_ASSERT(max_count > 0);
+
+		// sharded queues batch from one lane at a time, going round as consume does
+		if (lane_count_)
+		{
+			uint32 start = read_lane_.load(std::memory_order_relaxed);
+			for (uint32 i = 0; i != lane_count_; ++i)
+			{
+				uint32 lane = (start + i) % lane_count_;
+				if (auto B = impl_consume_batch(lanes_[lane], max_count, max_bytes))
+				{
+					read_lane_.store(lane + 1, std::memory_order_relaxed);
+					return B;
+				}
+			}
+
+			return batch_t{};
+		}
+
+		// 1) load read-buffer, and increment use-count, as with consume
+		buffer_t buf;
+		if (growth_limit_)
+			buf = impl_acquire(reading_);
+		else
+			atma::atomic_load_128(&buf, &reading_);
+
+		return impl_consume_batch(buf.pointer, max_count, max_bytes);
+	}
+
+	inline auto base_lockfree_queue_t::impl_consume_batch(byte* rb, uint32 max_count, uint32 max_bytes) -> batch_t
+	{
+		housekeeping_t* hk = buf_housekeeping(rb);
+		uint32 const bs = hk->buffer_size();
+
+		// 2) walk forwards over full allocations, then claim them all by moving the
+		//    read-pointer over them in one go
+		//
+		// NOTE: as with consume, the headers we walk over may be mental if other read-threads
+		// move rp under us. we discard everything if the compare-exchange fails
+		cursor_t r = atma::atomic_load(&hk->r);
+		cursor_t nr, jr;
+		uint32 count, bytes;
+		claim_t* claim = impl_claim(claimkind_t::read);
+
+		for (;;)
+		{
+			ATMA_ASSERT(r % 4 == 0);
+
+			nr = r;
+			jr = r;
+			count = 0;
+			bytes = 0;
+
+			// the batch is cleared as one big allocation, so it must fit in a header
+			while (nr - r < bs)
+			{
+				header_t h = atma::atomic_load(reinterpret_cast<uint32*>(rb + nr % bs));
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				if (h.state != allocstate_t::full || header_size_bitmask < nr + h.size - r)
+					break;
+
+				if (h.type == alloctype_t::normal || h.type == alloctype_t::large)
+				{
+					if (count == max_count || (count != 0 && max_bytes < (uint64)bytes + h.size))
+						break;
+
+					++count;
+					bytes += h.size;
+				}
+
+				jr = nr;
+				nr += header_size + h.size;
+
+				// nothing follows a jump in this buffer
+				if (h.type == alloctype_t::jump)
+					break;
+			}
+
+			if (nr == r)
+			{
+				impl_unclaim(claim);
+				if (growth_limit_)
+					impl_adjust_readers(hk, -1);
+				return batch_t{};
+			}
+
+			impl_claim_span(claim, r, nr);
+			if (atma::atomic_compare_exchange(&hk->r, r, nr, &r))
+			{
+				impl_claim_hold(claim);
+				break;
+			}
+		}
+
+		// 3) we now have exclusive access to our range of memory. decode
+		//    where we're jumping to, if we are
+		byte* next = nullptr;
+		decoder_t J{rb, jr % bs};
+		if (J.type() == alloctype_t::jump)
+			J.decode_pointer(next);
+		J.type_ = 0;
+
+		batch_t B{rb, r, nr, count, next};
+
+		// a batch of nothing but pads (and a jump) gets dealt with right here
+		if (count == 0)
+		{
+			finalize_batch(B);
+			return consume_batch(max_count, max_bytes);
+		}
+
+		return B;
+	}
+
+	inline auto base_lockfree_queue_t::finalize_batch(batch_t& B) -> void
+	{
+		if (B.begin_ == B.end_)
+			return;
+
+		auto hk = buf_housekeeping(B.buf_);
+		auto op = B.begin_ % hk->buffer_size();
+		auto hp = (uint32*)(B.buf_ + op);
+		uint32 size = B.end_ - B.begin_ - header_size;
+
+		// 1) zero-out everything after the first header, including all other headers,
+		//    so that the whole batch looks like one allocation
+		impl_zero_body(hk, op, size);
+
+		// 2) set that allocation to "ready to clear"
+		header_t h = atma::atomic_load(hp);
+		ATMA_ASSERT(h.state == allocstate_t::full);
+		h.state = allocstate_t::empty;
+		h.type = alloctype_t::jump;
+		h.size = size;
+		atma::atomic_exchange(hp, h.u32);
+
+		// 3) move empty-position along
+		impl_advance_empty(hk);
+		impl_unclaim(claimkind_t::read, hk, op);
+
+		B.end_ = B.begin_;
+		B.count_ = 0;
+
+		// 4) the batch's use of the buffer ends here, and if we consumed a jump,
+		//    we retire the old buffer as consume does
+		if (growth_limit_)
+			impl_adjust_readers(hk, -1);
+
+		if (B.next_)
+		{
+			auto old = impl_retire(reading_, B.next_, 2);
+			ATMA_ASSERT(old.pointer == B.buf_);
+			impl_adjust_readers(hk, (int64)old.uses - 1);
+			B.next_ = nullptr;
+		}
+	}
+
+	inline auto base_lockfree_queue_t::impl_zero_body(housekeeping_t* hk, uint32 op, uint32 size) -> void
+	{
+		// use acquire/release so that all memsets get visible
+		auto size_wrap   = std::max((op + header_size + size) - (int64)hk->buffer_size(), (int64)0);
+		auto size_middle = std::max(size - size_wrap, (int64)0);
+		ATMA_ASSERT(op + size_middle <= hk->buffer_size());
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		memset(hk->buffer() + (op + header_size) % hk->buffer_size(), 0, size_middle);
+		memset(hk->buffer(), 0, size_wrap);
+		std::atomic_thread_fence(std::memory_order_release);
+	}
+
+	inline auto base_lockfree_queue_t::impl_advance_empty(housekeeping_t* hk) -> void
+	{
 		uint32 ep = atma::atomic_load(&hk->e);
 		for (uint32 epm = ep % hk->buffer_size();; epm = ep % hk->buffer_size())
 		{
@@ -519,16 +1140,230 @@ namespace atma
 					}
 				}
 			}
-			else
+			else
+			{
+				break;
+			}
+		}
+	}
+
+	inline auto base_lockfree_queue_t::impl_recover() -> void
+	{
+		ATMA_ASSERT(inplace_);
+
+		auto hk = buf_housekeeping(reading_.pointer);
+		auto const bs = hk->buffer_size();
+		auto const header_at = [&](cursor_t c) { return reinterpret_cast<uint32*>(hk->buffer() + c % bs); };
+
+		cursor_t w = atma::atomic_load(&hk->w);
+		cursor_t r = atma::atomic_load(&hk->r);
+		cursor_t e = atma::atomic_load(&hk->e);
+
+		// cursors that don't make sense can't be reasoned about, so the queue's contents
+		// are lost. with everyone else gone, this is the only way to get it going again.
+		// expected is: e - bs <= r <= w, with w running past e only for writers waiting
+		if (w % 4 != 0 || r % 4 != 0 || e % 4 != 0 || bs < r - (e - bs) || 0x80000000u <= w - r)
+		{
+			buf_reset(hk);
+			return;
+		}
+
+		// 1) finalize allocations that were consumed by readers that died before finalizing
+		//
+		//  - a zero header means a reader died moving ep past it. it had already zeroed
+		//    the body, so the allocation runs up to the next (non-zero) header
+		//
+		for (cursor_t c = e - bs; c != r; )
+		{
+			header_t h = atma::atomic_load(header_at(c));
+			if (h.u32 == 0)
+			{
+				cursor_t n = c + header_size;
+				while (n != r && atma::atomic_load(header_at(n)) == 0)
+					n += 4;
+
+				h.state = allocstate_t::empty;
+				h.type = alloctype_t::jump;
+				h.size = n - c - header_size;
+			}
+			else if (h.state == allocstate_t::full || h.state == allocstate_t::mid_read)
+			{
+				impl_zero_body(hk, c % bs, h.size);
+				h.state = allocstate_t::empty;
+				h.type = alloctype_t::jump;
+			}
+			else if (h.state != allocstate_t::empty || h.type != alloctype_t::jump)
+			{
+				buf_reset(hk);
+				return;
+			}
+
+			if (r - c < header_size + h.size)
+			{
+				buf_reset(hk);
+				return;
+			}
+
+			atma::atomic_exchange(header_at(c), h.u32);
+			c += header_size + h.size;
+		}
+
+		impl_advance_empty(hk);
+		e = atma::atomic_load(&hk->e);
+
+		// 2) commit allocations reserved by writers that died before committing, as pads
+		//
+		//  - a zero header means a writer died before it could write its header. we
+		//    can't know how big it was, so we give back everything from there on
+		//
+		for (cursor_t c = r; c != w; )
+		{
+			header_t h = c == e ? header_t{} : atma::atomic_load(header_at(c));
+			if (h.u32 == 0)
+			{
+				// anything up to ep may have been written to
+				for (cursor_t z = c; z != w && z != e; z += 4)
+					atma::atomic_exchange(header_at(z), 0u);
+
+				atma::atomic_exchange(&hk->w, c);
+				break;
+			}
+			else if (h.state == allocstate_t::empty && h.type == alloctype_t::pad)
+			{
+				h.state = allocstate_t::full;
+				atma::atomic_exchange(header_at(c), h.u32);
+			}
+			else if (h.state != allocstate_t::full || e - c < header_size + h.size)
+			{
+				buf_reset(hk);
+				return;
+			}
+
+			c += header_size + h.size;
+		}
+
+		waiting_->sleepers.store(0);
+	}
+
+	inline auto base_lockfree_queue_t::impl_recover_claim(claim_t& claim, std::span<claim_t const* const> live, std::span<claim_t const* const> dead) -> bool
+	{
+		ATMA_ASSERT(inplace_);
+
+		auto hk = buf_housekeeping(reading_.pointer);
+		auto const bs = hk->buffer_size();
+		auto const hp = [&](cursor_t c) { return reinterpret_cast<uint32*>(hk->buffer() + c % bs); };
+
+		// cursors wrap, so are compared by their distance apart
+		auto const before = [](cursor_t a, cursor_t b) { return (int32)(a - b) < 0; };
+
+		uint32 const raw_kind = claim.kind.load();
+		auto const kind = (claimkind_t)(raw_kind & ~claim_held_bit);
+		bool const held = (raw_kind & claim_held_bit) != 0;
+		uint64 const span = claim.span.load();
+		auto const begin = (cursor_t)span;
+		auto const end = (cursor_t)(span >> 32);
+
+		auto const done = [&] {
+			claim.span.store(0);
+			claim.kind.store((uint32)claimkind_t::none);
+			return true;
+		};
+
+		auto const claims_begin = [&](claim_t const* x, bool only_held) {
+			uint32 k = x->kind.load();
+			return x != &claim
+				&& (claimkind_t)(k & ~claim_held_bit) == kind
+				&& (!only_held || (k & claim_held_bit) != 0)
+				&& (cursor_t)x->span.load() == begin;
+		};
+
+		// a live process with a claim beginning where this one does either got
+		// there first, or is about to find out it didn't
+		auto const live_claims_begin = [&] {
+			return std::ranges::any_of(live, [&](claim_t const* x) { return claims_begin(x, false); });
+		};
+
+		// a claim that was never held lost the race to whoever holds the same
+		// beginning. it's only ours if we died between winning and holding
+		auto const dead_holds_begin = [&] {
+			return !held && std::ranges::any_of(dead, [&](claim_t const* x) { return claims_begin(x, true); });
+		};
+
+		if (kind == claimkind_t::none || begin == end || dead_holds_begin())
+			return done();
+
+		// the pointer the claim was for is loaded before anyone else's claims are
+		// looked at. whoever moved it past begin claimed begin before doing so
+		if (kind == claimkind_t::write)
+		{
+			// never reserved (it lost the race), or already consumed
+			cursor_t w = atma::atomic_load(&hk->w);
+			cursor_t r = atma::atomic_load(&hk->r);
+			if (before(w, end) || before(begin, r))
+				return done();
+
+			if (live_claims_begin())
+				return false;
+
+			header_t h = atma::atomic_load(hp(begin));
+
+			// reserved and marked, but never committed. commit it as padding
+			if (h.state == allocstate_t::empty && h.type == alloctype_t::pad && begin + header_size + h.size == end)
+			{
+				header_t nh = h;
+				nh.state = allocstate_t::full;
+				atma::atomic_compare_exchange(hp(begin), h.u32, nh.u32);
+				return done();
+			}
+			// reserved, but the writer was still waiting on readers to make room. once
+			// they have, we can mark it on its behalf
+			else if (h.u32 == 0)
 			{
-				break;
+				if (before(atma::atomic_load(&hk->e), end))
+					return false;
+
+				header_t nh;
+				nh.state = allocstate_t::full;
+				nh.type = alloctype_t::pad;
+				nh.size = end - begin - header_size;
+				atma::atomic_compare_exchange(hp(begin), 0u, nh.u32);
+				return done();
 			}
+
+			// committed, or not the dead writer's
+			return done();
 		}
+		else
+		{
+			// never consumed (it lost the race), or consumed and since cleared
+			cursor_t r = atma::atomic_load(&hk->r);
+			cursor_t e = atma::atomic_load(&hk->e);
+			if (before(r, end) || before(begin, e - bs))
+				return done();
+
+			if (live_claims_begin())
+				return false;
+
+			// finalize it as finalize or finalize_batch would, as one allocation
+			header_t h = atma::atomic_load(hp(begin));
+			if (h.state == allocstate_t::full || h.state == allocstate_t::mid_read)
+			{
+				uint32 const size = end - begin - header_size;
+				impl_zero_body(hk, begin % bs, size);
+
+				header_t nh = h;
+				nh.state = allocstate_t::empty;
+				nh.type = alloctype_t::jump;
+				nh.size = size;
+				if (atma::atomic_compare_exchange(hp(begin), h.u32, nh.u32))
+					impl_advance_empty(hk);
+			}
 
-		D.type_ = 0;
+			return done();
+		}
 	}
 
-	inline auto base_lockfree_queue_t::impl_allocate_default(housekeeping_t* hk, cursor_t const& w, cursor_t const& e, uint32 size, uint32 alignment, bool ct) -> allocinfo_t
+	inline auto base_lockfree_queue_t::impl_allocate_default(housekeeping_t* hk, cursor_t const& w, cursor_t const& e, uint32 size, uint32 alignment, bool ct, uint32 reserve) -> allocinfo_t
 	{
 		ATMA_ASSERT(alignment > 0);
 		ATMA_ASSERT(w % 4 == 0);
@@ -539,7 +1374,7 @@ namespace atma
 		size += aml::alignby(w + header_size, alignment) - w - header_size;
 		size  = aml::alignby(size, 4);
 
-		return impl_allocate(hk, w, e, size, alignment, ct);
+		return impl_allocate(hk, w, e, size, alignment, ct, reserve);
 	}
 
 	inline auto base_lockfree_queue_t::impl_allocate_pad(housekeeping_t* hk, cursor_t const& w, cursor_t const& e) -> allocinfo_t
@@ -555,7 +1390,7 @@ namespace atma
 		return impl_allocate(hk, w, e, space, 1, true);
 	}
 
-	inline auto base_lockfree_queue_t::impl_allocate(housekeeping_t* hk, cursor_t const& w, cursor_t const& e, uint32 size, uint32 alignment, bool ct) -> allocinfo_t
+	inline auto base_lockfree_queue_t::impl_allocate(housekeeping_t* hk, cursor_t const& w, cursor_t const& e, uint32 size, uint32 alignment, bool ct, uint32 reserve) -> allocinfo_t
 	{
 		ATMA_ASSERT(alignment > 0);
 		ATMA_ASSERT(w % 4 == 0);
@@ -570,14 +1405,18 @@ namespace atma
 		uint32 np;
 		uint32 ps = 0;
 
-		// contiguous allocation requires compare-and-swap
-		if (ct)
+		// contiguous allocation requires compare-and-swap. so does keeping space in
+		// reserve, as we must know where we'll end up before moving there, and so
+		// does claiming where we're moving to
+		claim_t* claim = impl_claim(claimkind_t::write);
+
+		if (ct || reserve || claim)
 		{
 			op = atma::atomic_load(&hk->w);
 
 			for (uint32 npm = (op + sz) % bs;; npm = (op + sz) % bs)
 			{
-				if (npm != 0 && npm < header_size + size)
+				if (ct && npm != 0 && npm < header_size + size)
 				{
 					ps = sz - npm;
 					np = op + ps + sz;
@@ -587,10 +1426,26 @@ namespace atma
 					np = op + sz;
 				}
 
+				// fail instead of waiting for readers, if there's no room left over for
+				// the reserve, or if the buffer is closed. closed must be loaded after op,
+				// so that any allocation landing after a jump sees it
+				if (reserve && (atma::atomic_load(&hk->closed) || atma::atomic_load(&hk->e) < np + reserve))
+				{
+					impl_unclaim(claim);
+					return {0, allocerr_t::invalid, 0};
+				}
+
+				impl_claim_span(claim, op, np);
 				if (atma::atomic_compare_exchange(&hk->w, op, np, &op))
+				{
+					impl_claim_hold(claim);
 					break;
-				else
-					ps = 0;
+				}
+
+				ps = 0;
+#if ATMA_LOCKFREE_QUEUE_STATS
+				counters_.cas_retries.fetch_add(1, std::memory_order_relaxed);
+#endif
 			}
 		}
 		// non-contiguous allocation is fine-and-dandy with an add
@@ -623,19 +1478,53 @@ namespace atma
 			padh.type = alloctype_t::pad;
 			padh.size = ps - header_size;
 			header_t padv = atma::atomic_exchange(hp, padh);
+#if ATMA_LOCKFREE_QUEUE_STATS
+			counters_.pads.fetch_add(1, std::memory_order_relaxed);
+#endif
 
 			op += ps;
 			p = op % hk->buffer_size();
 			hp = (uint32*)(hk->buffer() + p);
 			h = atma::atomic_load(hp);
+
+			// the padding's committed, so it's no longer ours to recover
+			impl_claim_span(claim, op, np);
+		}
+
+#if ATMA_LOCKFREE_QUEUE_STATS
+		if (ep < np)
+		{
+			auto const starve_start = std::chrono::steady_clock::now();
+			bool starved = false;
+
+			while (ep < np)
+			{
+				ep = atma::atomic_load(&hk->e);
+
+				if (!starved && starve_timeout < std::chrono::steady_clock::now() - starve_start)
+				{
+					starved = true;
+					counters_.starve_timeouts.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
 		}
 
+		// bytes in flight, as of the last time we looked at ep
+		uint64 in_flight = np - (ep - bs);
+		uint64 hw = counters_.high_water_bytes.load(std::memory_order_relaxed);
+		while (hw < in_flight && !counters_.high_water_bytes.compare_exchange_weak(hw, in_flight, std::memory_order_relaxed))
+			;
+#else
 		while (ep < np)
 			ep = atma::atomic_load(&hk->e);
+#endif
 
+		// the size isn't needed until commit, but lets impl_recover step over
+		// reservations abandoned by a writer that died
 		auto nh = h;
 		nh.state = allocstate_t::empty;
 		nh.type  = alloctype_t::pad;
+		nh.size  = size;
 		header_t v = atma::atomic_exchange(hp, nh.u32);
 		ATMA_ASSERT(v.state == allocstate_t::empty);
 
@@ -658,6 +1547,171 @@ namespace atma
 		h.state = allocstate_t::full;
 		header_t v = atma::atomic_exchange(ah, h.u32);
 		ATMA_ASSERT(v.state == allocstate_t::empty && v.type == alloctype_t::pad);
+		impl_unclaim(claimkind_t::write, buf_housekeeping(a.buf_), a.op_);
+
+		// the exchange above is a full barrier, so either a sleeper sees our allocation
+		// when it checks the queue before parking, or we see the sleeper here
+		if (waiting_->sleepers.load() != 0)
+			impl_wake();
+	}
+
+	inline auto base_lockfree_queue_t::consume_wait(std::chrono::nanoseconds timeout) -> decoder_t
+	{
+		auto const deadline = std::chrono::steady_clock::now() + timeout;
+
+		// any notify_all from here on sends us home, even one that comes while we spin
+		uint32 const notifies = waiting_->notifies.load();
+
+		// a busy queue won't keep us waiting long
+		for (uint32 i = 0; i != consume_wait_spins; ++i)
+		{
+			if (auto D = consume())
+				return D;
+		}
+
+		for (;;)
+		{
+			// announce ourselves before checking the queue one last time, so a writer
+			// committing after our check is guaranteed to wake us
+			waiting_->sleepers.fetch_add(1);
+			uint32 key = waiting_->wakeups.load();
+
+			// notify_all counts itself before waking anyone, so one that's already been
+			// is seen here, and one that hasn't will change key and not let us park
+			auto D = consume();
+			auto now = std::chrono::steady_clock::now();
+			if (D || deadline <= now || waiting_->notifies.load() != notifies)
+			{
+				waiting_->sleepers.fetch_sub(1);
+				return D;
+			}
+
+			platform::wait_on_address(waiting_->wakeups, key, deadline - now, interprocess_wakeups_);
+			waiting_->sleepers.fetch_sub(1);
+
+			// woken by notify_all. anything else is a writer (which another reader may
+			// have beaten us to), a timeout, or spurious, which the loop sorts out
+			if (waiting_->notifies.load() != notifies)
+				return consume();
+		}
+	}
+
+	inline auto base_lockfree_queue_t::notify_all() -> void
+	{
+		waiting_->notifies.fetch_add(1);
+		impl_wake();
+	}
+
+	inline auto base_lockfree_queue_t::impl_wake() -> void
+	{
+		waiting_->wakeups.fetch_add(1);
+		platform::wake_by_address_all(waiting_->wakeups, interprocess_wakeups_, waiting_->sleepers.load());
+	}
+
+	inline auto base_lockfree_queue_t::impl_claim(claimkind_t kind) -> claim_t*
+	{
+		if (claims_ == nullptr)
+			return nullptr;
+
+		// writers claim from the front half, and readers the back
+		claim_t* const claims = claims_ + (kind == claimkind_t::write ? 0 : claims_per_kind);
+
+		// start somewhere different on every thread, so they don't fight
+		for (uint32 i = thread_ordinal();; ++i)
+		{
+			auto& x = claims[i % claims_per_kind];
+
+			uint32 none = (uint32)claimkind_t::none;
+			if (x.kind.compare_exchange_strong(none, (uint32)kind))
+				return &x;
+
+			if (i % claims_per_kind == claims_per_kind - 1)
+				std::this_thread::yield();
+		}
+	}
+
+	inline auto base_lockfree_queue_t::impl_claim_span(claim_t* claim, cursor_t begin, cursor_t end) -> void
+	{
+		if (claim)
+			claim->span.store((uint64)end << 32 | begin);
+	}
+
+	inline auto base_lockfree_queue_t::impl_claim_hold(claim_t* claim) -> void
+	{
+		if (claim)
+			claim->kind.fetch_or(claim_held_bit);
+	}
+
+	inline auto base_lockfree_queue_t::impl_unclaim(claim_t* claim) -> void
+	{
+		if (claim == nullptr)
+			return;
+
+		// emptied first, so that whoever claims it next starts out empty
+		claim->span.store(0);
+		claim->kind.store((uint32)claimkind_t::none);
+	}
+
+	inline auto base_lockfree_queue_t::impl_unclaim(claimkind_t kind, housekeeping_t* hk, uint32 begin_position) -> void
+	{
+		if (claims_ == nullptr)
+			return;
+
+		for (uint32 i = 0; i != claims_per_process; ++i)
+		{
+			auto& x = claims_[i];
+			if (x.kind.load() == ((uint32)kind | claim_held_bit) && (uint32)x.span.load() % hk->buffer_size() == begin_position)
+				return impl_unclaim(&x);
+		}
+
+		ATMA_ASSERT(false, "no claim for allocation");
+	}
+
+	inline auto base_lockfree_queue_t::stats() -> stats_t
+	{
+		stats_t r;
+
+		// ep is loaded first, so that we can only overestimate
+		auto in_flight = [](housekeeping_t* hk) -> uint64 {
+			cursor_t e = atma::atomic_load(&hk->e);
+			cursor_t w = atma::atomic_load(&hk->w);
+			return w - (e - hk->buffer_size());
+		};
+
+		if (lane_count_)
+		{
+			for (uint32 i = 0; i != lane_count_; ++i)
+				r.bytes_in_flight += in_flight(buf_housekeeping(lanes_[i]));
+		}
+		// the buffers between the read & write buffers may be freed under us
+		else if (growth_limit_)
+		{
+			auto rbuf = impl_acquire(reading_);
+			auto wbuf = impl_acquire(writing_);
+
+			r.bytes_in_flight += in_flight(rbuf.housekeeping());
+			if (wbuf.pointer != rbuf.pointer)
+				r.bytes_in_flight += in_flight(wbuf.housekeeping());
+
+			impl_adjust_writers(wbuf.housekeeping(), -1);
+			impl_adjust_readers(rbuf.housekeeping(), -1);
+		}
+		else if (reading_.pointer)
+		{
+			r.bytes_in_flight = in_flight(buf_housekeeping(reading_.pointer));
+		}
+
+#if ATMA_LOCKFREE_QUEUE_STATS
+		r.cas_retries = counters_.cas_retries.load(std::memory_order_relaxed);
+		r.starve_timeouts = counters_.starve_timeouts.load(std::memory_order_relaxed);
+		r.pads = counters_.pads.load(std::memory_order_relaxed);
+		r.jumps = counters_.jumps.load(std::memory_order_relaxed);
+		r.high_water_bytes = counters_.high_water_bytes.load(std::memory_order_relaxed);
+		for (uint32 i = 0; i != size_buckets; ++i)
+			r.sizes[i] = counters_.sizes[i].load(std::memory_order_relaxed);
+#endif
+
+		return r;
 	}
 
 
@@ -666,51 +1720,99 @@ namespace atma
 		return allocation_t{wb, wp, allocstate_t::flag_commit, type, alignment, size};
 	}
 
-	inline auto base_lockfree_queue_t::impl_encode_jump(uint32 available, byte* wb, uint32 wbs, uint32 wp) -> void
+	inline auto base_lockfree_queue_t::impl_make_allocation() -> allocation_t
 	{
-		//static_assert(sizeof(uint64) >= sizeof(void*), "pointers too large! where are you?");
-		//housekeeping_t* hk;
-		//hkn.bu
-		//auto yay = new char[hk->buffer_size() * 2];
-		//auto hk = new (yay) housekeeping_t{yay + sizeof(housekeeping_t*), hk->buffer_size() * 2, true)};
-		//hk->
-		
+		return allocation_t{};
+	}
 
-#if 0
-		if (jump_command_body_size <= available)
+	inline auto base_lockfree_queue_t::impl_acquire(buffer_t& link) -> buffer_t
+	{
+		buffer_t buf;
+		atma::atomic_load_128(&buf, &link);
+
+		for (;;)
 		{
-			// current write-info
-			atma::atomic128_t q_write_info;
-			q_write_info.ui64[0] = (uint64)wb;
-			q_write_info.ui32[2] = wbs;
-			q_write_info.ui32[3] = wp;
+			auto nbuf = buf;
+			++nbuf.uses;
+
+			if (atma::atomic_compare_exchange(&link.atomic, buf.atomic, nbuf.atomic, &buf.atomic))
+				return nbuf;
+		}
+	}
+
+	inline auto base_lockfree_queue_t::impl_retire(buffer_t& link, byte* next, uint64 uses) -> buffer_t
+	{
+		// move the link to the next buffer, and return what it held. the caller must fold the
+		// returned use-count (less the link's own use) into the old buffer's count. until then,
+		// the old buffer's count only holds releases, is never positive, and so can't hit zero
+		buffer_t buf, nbuf;
+		atma::atomic_load_128(&buf, &link);
+		nbuf.pointer = next;
+		nbuf.uses = uses;
+
+		while (!atma::atomic_compare_exchange(&link.atomic, buf.atomic, nbuf.atomic, &buf.atomic))
+			;
+
+		return buf;
+	}
 
+	inline auto base_lockfree_queue_t::impl_adjust_writers(housekeeping_t* hk, int64 x) -> void
+	{
+		// the last writer out gives back the use the readers were holding on our behalf
+		if (hk->writers.fetch_add(x) + x == 0)
+			impl_adjust_readers(hk, -1);
+	}
 
+	inline auto base_lockfree_queue_t::impl_adjust_readers(housekeeping_t* hk, int64 x) -> void
+	{
+		if (hk->readers.fetch_add(x) + x == 0)
+			buf_free(hk);
+	}
 
-			// new-write-info
-			atma::atomic128_t nwi;
-			auto const nwbs = wbs * 2;
-			nwi.ui64[0] = (uint64)new byte[nwbs]();
-			nwi.ui32[2] = nwbs;
-			nwi.ui32[3] = 0;
+	inline auto base_lockfree_queue_t::impl_growable_footprint(uint32 size, uint32 alignment, bool contiguous) -> uint64
+	{
+		// allocations start 4-byte aligned, so pad by at most alignment - 4
+		uint64 const allocation = header_size + (alignment - 4) + aml::alignby((uint64)size, 4);
 
-			// atomically change the write-info. this means no other thread is now writing
-			// into the old write-buffer after us
-			if (atma::atomic_compare_exchange(&write_info_, q_write_info, nwi))
-			{
-				// no other thread can touch the old write-buffer/write-position, so no
-				// need to perform atomic operations anymore
-				auto A = allocation_t{wb, wbs, wp, alloctype_t::jump, 0, jump_command_body_size};
-				A.encode_uint64(nwi.ui64[0]);
-				A.encode_uint32(nwbs);
-				commit(A);
-			}
-			else
-			{
-				delete[] (byte*)nwi.ui64[0];
-			}
-		}
+		// a contiguous allocation that would wrap pads out the rest of the
+		// buffer, which is less than the allocation itself
+		return (contiguous ? allocation * 2 : allocation) + jump_command_size;
+	}
+
+	inline auto base_lockfree_queue_t::impl_grow(buffer_t const& writebuf, uint32 size, uint32 alignment, bool contiguous) -> void
+	{
+		auto hk = writebuf.housekeeping();
+
+		// double in size, or grow enough to fit the allocation (and the reserve after it)
+		uint64 required = impl_growable_footprint(size, alignment, contiguous);
+		uint64 nbs = std::min<uint64>(std::max<uint64>(hk->buffer_size() * 2ull, required), growth_limit_);
+		if (nbs <= hk->buffer_size())
+			return;
+
+		// only one writer gets to close the buffer. everyone else waits for them
+		if (!atma::atomic_compare_exchange(&hk->closed, 0u, 1u))
+			return;
+
+		// every allocation before ours left room for this
+		auto ji = impl_allocate_default(hk, atma::atomic_load(&hk->w), atma::atomic_load(&hk->e), jump_command_body_size, 4, false);
+		ATMA_ASSERT(ji);
+
+		auto nb = (byte*)buf_init(new byte[nbs + sizeof(housekeeping_offset_t)]{}, (uint32)nbs + sizeof(housekeeping_offset_t), true);
+		hk->next = buf_housekeeping(nb);
+
+		// readers may follow the jump from here on
+		auto A = impl_make_allocation(writebuf.pointer, hk->buffer_size(), ji.p, alloctype_t::jump, 4, ji.sz);
+		A.encode_pointer(nb);
+		A.encode_uint32((uint32)nbs);
+		commit(A);
+#if ATMA_LOCKFREE_QUEUE_STATS
+		counters_.jumps.fetch_add(1, std::memory_order_relaxed);
 #endif
+
+		// and writers may allocate from the new buffer
+		auto old = impl_retire(writing_, nb, 1);
+		ATMA_ASSERT(old.pointer == writebuf.pointer);
+		impl_adjust_writers(hk, (int64)old.uses - 1);
 	}
 
 
@@ -735,6 +1837,10 @@ namespace atma
 	}
 
 	// allocation_t
+	inline base_lockfree_queue_t::allocation_t::allocation_t()
+		: headerer_t(nullptr, 0, 0, 0)
+	{}
+
 	inline base_lockfree_queue_t::allocation_t::allocation_t(byte* buf, uint32 wp, allocstate_t state, alloctype_t type, uint32 alignment, uint32 size)
 		: headerer_t{buf, wp, wp, (uint32)state, (uint32)type, alignment, size}
 	{
@@ -817,6 +1923,21 @@ namespace atma
 			encode_byte(b);
 	}
 
+	inline auto base_lockfree_queue_t::allocation_t::encode_memory(shared_memory_t&& mem) -> void
+	{
+		ATMA_ASSERT(raw_size() == memory_handle_size);
+		ATMA_ASSERT(p_ == (aml::alignby(op_ + header_size, alignment()) % buffer_size()), "large allocations hold only the handle");
+
+		// the reference mem held is now the queue's, until decode_memory takes it.
+		// the handle is written byte-wise, as we may wrap
+		static_assert(std::is_trivially_copyable_v<shared_memory_t::released_t>);
+		auto const handle = mem.release();
+
+		type_ = (uint32)alloctype_t::large;
+		for (uint32 i = 0; i != sizeof(handle); ++i)
+			encode_byte(reinterpret_cast<byte const*>(&handle)[i]);
+	}
+
 	// decoder_t
 	inline base_lockfree_queue_t::decoder_t::decoder_t()
 		: headerer_t(nullptr, 0, 0, 0)
@@ -915,6 +2036,80 @@ namespace atma
 			decode_byte(reinterpret_cast<byte*>(&x)[i]);
 	}
 
+	inline auto base_lockfree_queue_t::decoder_t::decode_memory() -> shared_memory_t
+	{
+		ATMA_ASSERT(is_large());
+
+		shared_memory_t::released_t handle;
+		decode_struct(handle);
+		return shared_memory_t::adopt(handle);
+	}
+
+
+
+
+
+	// batch_t
+	inline base_lockfree_queue_t::batch_t::batch_t(batch_t&& rhs)
+		: buf_{rhs.buf_}, begin_{rhs.begin_}, end_{rhs.end_}, count_{rhs.count_}, next_{rhs.next_}
+	{
+		rhs.end_ = rhs.begin_;
+		rhs.count_ = 0;
+		rhs.next_ = nullptr;
+	}
+
+	inline base_lockfree_queue_t::batch_t::~batch_t()
+	{
+		ATMA_ASSERT(begin_ == end_, "batch not finalized before destructing");
+	}
+
+	inline auto base_lockfree_queue_t::batch_t::begin() const -> iterator
+	{
+		return iterator{buf_, begin_, end_};
+	}
+
+	inline auto base_lockfree_queue_t::batch_t::end() const -> iterator
+	{
+		return iterator{buf_, end_, end_};
+	}
+
+	// batch_t::iterator
+	inline base_lockfree_queue_t::batch_t::iterator::iterator(byte* buf, cursor_t c, cursor_t end)
+		: buf_{buf}, c_{c}, end_{end}
+	{
+		skip_();
+	}
+
+	inline base_lockfree_queue_t::batch_t::iterator::~iterator()
+	{
+		if (decoder_)
+			decoder_->type_ = 0;
+	}
+
+	inline auto base_lockfree_queue_t::batch_t::iterator::operator++() -> iterator&
+	{
+		c_ += header_size + decoder_->raw_size();
+		skip_();
+		return *this;
+	}
+
+	inline auto base_lockfree_queue_t::batch_t::iterator::skip_() -> void
+	{
+		if (decoder_)
+			decoder_->type_ = 0;
+
+		// step over pads and jumps, which never make it to the user
+		for (; c_ != end_; c_ += header_size + decoder_->raw_size())
+		{
+			decoder_.emplace(decoder_t{buf_, c_ % buf_housekeeping(buf_)->buffer_size()});
+			if (decoder_->type() == alloctype_t::normal || decoder_->is_large())
+				return;
+
+			decoder_->type_ = 0;
+		}
+
+		decoder_.reset();
+	}
 
 
 
@@ -934,16 +2129,36 @@ namespace atma
 			: base_lockfree_queue_t{size}
 		{}
 
+		lockfree_queue_ii_t(uint32 size, uint32 max_size)
+			: base_lockfree_queue_t{size, max_size}
+		{}
+
+		lockfree_queue_ii_t(uint32 lane_size, lanes_t lanes)
+			: base_lockfree_queue_t{lane_size, lanes}
+		{}
+
 		auto allocate(uint32 size, uint32 alignment = 4, bool contiguous = false) -> allocation_t
 		{
 			alignment = std::max(alignment, 4u);
 
+#if ATMA_LOCKFREE_QUEUE_STATS
+			counters_.sizes[std::min<uint32>(std::bit_width(size), size_buckets - 1)].fetch_add(1, std::memory_order_relaxed);
+#endif
+
 			ATMA_ASSERT(alignment == 4 || alignment == 8 || alignment == 16 || alignment == 32);
 
+			if (growth_limit_)
+				return allocate_growable(size, alignment, contiguous);
+
 			std::chrono::nanoseconds starvation{};
 
+			// lanes never move, so sharded queues needn't touch writing_ at all
 			buffer_t writebuf;
-			atma::atomic_load_128(&writebuf, &writing_);
+			if (lane_count_)
+				writebuf.pointer = impl_producer_lane();
+			else
+				atma::atomic_load_128(&writebuf, &writing_);
+
 			auto whk = writebuf.housekeeping();
 			
 			ATMA_ASSERT(size <= whk->buffer_size(), "queue can not allocate that much");
@@ -973,6 +2188,39 @@ namespace atma
 
 			return impl_make_allocation(writebuf.pointer, whk->buffer_size(), ai.p, alloctype_t::normal, alignment, ai.sz);
 		}
+
+	protected:
+		lockfree_queue_ii_t(void* mem, waiting_t* waiting, platform::interprocess_wakeups_t const* wakeups, claim_t* claims)
+			: base_lockfree_queue_t{mem, waiting, wakeups, claims}
+		{}
+
+	private:
+		auto allocate_growable(uint32 size, uint32 alignment, bool contiguous) -> allocation_t
+		{
+			// we'd otherwise wait forever for room that can never be made
+			if (impl_growable_footprint(size, alignment, contiguous) > growth_limit_)
+				return impl_make_allocation();
+
+			for (;;)
+			{
+				buffer_t writebuf = impl_acquire(writing_);
+				auto whk = writebuf.housekeeping();
+
+				auto w = atma::atomic_load(&whk->w);
+				auto e = atma::atomic_load(&whk->e);
+
+				auto ai = impl_allocate_default(whk, w, e, size, alignment, contiguous, jump_command_size);
+				if (!ai)
+					impl_grow(writebuf, size, alignment, contiguous);
+
+				// we can let go of the buffer before committing. readers can't move past
+				// our allocation until then, so can't reach the jump that retires it
+				impl_adjust_writers(whk, -1);
+
+				if (ai)
+					return impl_make_allocation(writebuf.pointer, whk->buffer_size(), ai.p, alloctype_t::normal, alignment, ai.sz);
+			}
+		}
 	};
 
 #if 0
@@ -1072,20 +2320,31 @@ namespace atma
 			: super_type{buf, size}
 		{}
 
+		lockfree_queue_t(uint32 size, uint32 max_size)
+			: super_type{size, max_size}
+		{}
+
+		lockfree_queue_t(uint32 lane_size, lanes_t lanes)
+			: super_type{lane_size, lanes}
+		{}
+
+		// returns false, without calling f, if the allocation can never be made
 		template <typename F>
-		auto with_allocation(uint32 size, uint32 alignment, bool contiguous, F&& f) -> void
+		auto with_allocation(uint32 size, uint32 alignment, bool contiguous, F&& f) -> bool
 		{
 			auto A = this->allocate(size, alignment, contiguous);
+			if (!A)
+				return false;
+
 			f(A);
 			this->commit(A);
+			return true;
 		}
 
 		template <typename F>
-		auto with_allocation(uint32 size, F&& f) -> void
+		auto with_allocation(uint32 size, F&& f) -> bool
 		{
-			auto A = this->allocate(size);
-			f(A);
-			this->commit(A);
+			return with_allocation(size, 4, false, std::forward<F>(f));
 		}
 
 		template <typename F>
@@ -1100,6 +2359,70 @@ namespace atma
 
 			return false;
 		}
+
+		template <typename F>
+		auto with_consumption_wait(std::chrono::nanoseconds timeout, F&& f) -> bool
+		{
+			if (auto D = this->consume_wait(timeout))
+			{
+				f(D);
+				this->finalize(D);
+				return true;
+			}
+
+			return false;
+		}
+
+		// large messages
+		//
+		//  - for bodies too large for the queue, or too large to copy through it. f(mem)
+		//    fills in a block of size bytes, which goes to the consumer as-is: the queue
+		//    only carries its handle, in an allocation of memory_handle_size bytes.
+		//    consumers take the block with decoder_t::decode_memory
+		//
+		//  - consumers tell large messages apart with decoder_t::is_large. blocks of
+		//    messages never consumed are released when the queue is destroyed
+		//
+		//  - blocks are process-local, so large messages can't go through an
+		//    interprocess_queue_t
+		//
+		//  - returns false, releasing the block, if the handle can never be allocated
+		//
+		template <typename F>
+		auto with_large_allocation(size_t size, F&& f) -> bool
+		{
+			shared_memory_t mem{size};
+			f(mem);
+
+			this->carries_large_.store(true, std::memory_order_relaxed);
+
+			auto A = this->allocate(memory_handle_size);
+			if (!A)
+				return false;
+
+			A.encode_memory(std::move(mem));
+			this->commit(A);
+			return true;
+		}
+
+		// returns how many allocations were consumed
+		template <typename F>
+		auto with_batch_consumption(uint32 max_count, uint32 max_bytes, F&& f) -> uint32
+		{
+			auto B = this->consume_batch(max_count, max_bytes);
+			auto r = B.size();
+
+			for (auto& D : B)
+				f(D);
+
+			this->finalize_batch(B);
+			return r;
+		}
+
+	protected:
+		lockfree_queue_t(void* mem, waiting_t* waiting, platform::interprocess_wakeups_t const* wakeups, claim_t* claims)
+			: super_type{mem, waiting, wakeups, claims}
+		{}
 	};
 
 }
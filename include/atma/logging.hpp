@@ -95,6 +95,7 @@ namespace atma
 		~logging_runtime_t()
 		{
 			running_ = false;
+			log_queue_.notify_all();
 			distribution_thread_.join();
 		}
 
@@ -165,7 +166,7 @@ namespace atma
 
 			while (running_)
 			{
-				log_queue_.with_consumption([&](auto& D)
+				log_queue_.with_consumption_wait(std::chrono::milliseconds{100}, [&](auto& D)
 				{
 					command_t id;
 					D.decode_uint32((uint32&)id);
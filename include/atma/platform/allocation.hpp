@@ -2,6 +2,9 @@
 
 #include <atma/config/platform.hpp>
 
+#include <algorithm>
+#include <cstdlib>
+
 import atma.types;
 
 namespace atma { namespace platform {
@@ -17,7 +20,9 @@ namespace atma { namespace platform {
 #ifdef ATMA_PLATFORM_WINDOWS
 		return _aligned_malloc(size, align);
 #else
-		return nullptr;
+		// posix_memalign wants at least pointer alignment
+		void* r = nullptr;
+		return posix_memalign(&r, std::max(align, sizeof(void*)), size) == 0 ? r : nullptr;
 #endif
 	}
 
@@ -26,6 +31,8 @@ namespace atma { namespace platform {
 	{
 #ifdef ATMA_PLATFORM_WINDOWS
 		_aligned_free(ptr);
+#else
+		free(ptr);
 #endif
 	}
 
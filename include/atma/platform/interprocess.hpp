@@ -0,0 +1,206 @@
+#pragma once
+
+#include <atma/config/platform.hpp>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <utility>
+
+#if !defined(ATMA_PLATFORM_WINDOWS)
+#  include <cerrno>
+#  include <fcntl.h>
+#  include <signal.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+import atma.types;
+
+namespace atma { namespace platform {
+
+	inline auto current_process_id() -> uint32
+	{
+#if defined(ATMA_PLATFORM_WINDOWS)
+		return (uint32)GetCurrentProcessId();
+#else
+		return (uint32)getpid();
+#endif
+	}
+
+	// whether there's (still) a process with the given id. process-ids get reused,
+	// so this can say a process is alive when it died long ago, but never the reverse
+	inline auto process_alive(uint32 pid) -> bool
+	{
+#if defined(ATMA_PLATFORM_WINDOWS)
+		HANDLE h = OpenProcess(SYNCHRONIZE, FALSE, (DWORD)pid);
+		if (h == nullptr)
+			return GetLastError() == ERROR_ACCESS_DENIED;
+
+		bool r = WaitForSingleObject(h, 0) == WAIT_TIMEOUT;
+		CloseHandle(h);
+		return r;
+#else
+		return kill((pid_t)pid, 0) == 0 || errno == EPERM;
+#endif
+	}
+
+
+	//
+	// shared_mapping_t
+	// ------------------
+	//  a named region of memory, mapped into every process that opens it by name.
+	//  the first process to open it creates it (zeroed), everyone else sees that
+	//  same memory, although not necessarily at the same address
+	//
+	struct shared_mapping_t
+	{
+		shared_mapping_t() = default;
+		shared_mapping_t(shared_mapping_t const&) = delete;
+		shared_mapping_t(shared_mapping_t&&);
+		~shared_mapping_t();
+
+		auto operator = (shared_mapping_t&&) -> shared_mapping_t&;
+
+		operator bool() const { return data_ != nullptr; }
+
+		auto data() const -> byte* { return data_; }
+		auto size() const -> size_t { return size_; }
+
+		// whether we created the region, rather than opening an existing one
+		auto created() const -> bool { return created_; }
+
+	private:
+		byte* data_ = nullptr;
+		size_t size_ = 0;
+		bool created_ = false;
+
+#if defined(ATMA_PLATFORM_WINDOWS)
+		// the region lives for as long as anyone has it open
+		HANDLE handle_ = nullptr;
+#endif
+
+		friend auto open_shared_mapping(char const*, size_t) -> shared_mapping_t;
+	};
+
+	// opens the region called name, creating it with size bytes if it doesn't exist.
+	// an existing region keeps the size it was created with
+	auto open_shared_mapping(char const* name, size_t size) -> shared_mapping_t;
+
+	// removes the name, so that the next open creates a new region. processes that
+	// have the region open keep it. a no-op on windows, where the region disappears
+	// once everyone has closed it
+	auto remove_shared_mapping(char const* name) -> void;
+
+
+
+
+	inline shared_mapping_t::shared_mapping_t(shared_mapping_t&& rhs)
+	{
+		*this = std::move(rhs);
+	}
+
+	inline shared_mapping_t::~shared_mapping_t()
+	{
+#if defined(ATMA_PLATFORM_WINDOWS)
+		if (data_)
+			UnmapViewOfFile(data_);
+		if (handle_)
+			CloseHandle(handle_);
+#else
+		if (data_)
+			munmap(data_, size_);
+#endif
+	}
+
+	inline auto shared_mapping_t::operator = (shared_mapping_t&& rhs) -> shared_mapping_t&
+	{
+		std::swap(data_, rhs.data_);
+		std::swap(size_, rhs.size_);
+		std::swap(created_, rhs.created_);
+#if defined(ATMA_PLATFORM_WINDOWS)
+		std::swap(handle_, rhs.handle_);
+#endif
+		return *this;
+	}
+
+	inline auto open_shared_mapping(char const* name, size_t size) -> shared_mapping_t
+	{
+		shared_mapping_t r;
+
+#if defined(ATMA_PLATFORM_WINDOWS)
+		auto h = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, (DWORD)((uint64)size >> 32), (DWORD)size, name);
+		if (h == nullptr)
+			return r;
+
+		r.created_ = GetLastError() != ERROR_ALREADY_EXISTS;
+		r.handle_ = h;
+
+		r.data_ = (byte*)MapViewOfFile(h, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+		if (r.data_ == nullptr)
+			return r;
+
+		MEMORY_BASIC_INFORMATION mbi;
+		VirtualQuery(r.data_, &mbi, sizeof(mbi));
+		r.size_ = mbi.RegionSize;
+#else
+		// posix wants names to start with a slash
+		std::string posix_name = name[0] == '/' ? name : std::string{"/"} + name;
+
+		int fd = shm_open(posix_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+		if (fd != -1)
+		{
+			r.created_ = true;
+			if (ftruncate(fd, (off_t)size) == -1)
+			{
+				close(fd);
+				shm_unlink(posix_name.c_str());
+				return r;
+			}
+		}
+		else if (errno == EEXIST)
+		{
+			fd = shm_open(posix_name.c_str(), O_RDWR, 0600);
+			if (fd == -1)
+				return r;
+
+			// the creator may not have gotten around to sizing the region yet
+			struct stat st{};
+			for (uint32 i = 0; fstat(fd, &st) == 0 && st.st_size == 0 && i != 1000; ++i)
+				std::this_thread::sleep_for(std::chrono::milliseconds{1});
+
+			size = (size_t)st.st_size;
+		}
+
+		if (fd == -1 || size == 0)
+		{
+			if (fd != -1)
+				close(fd);
+			return r;
+		}
+
+		void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd);
+
+		if (data == MAP_FAILED)
+			return r;
+
+		r.data_ = (byte*)data;
+		r.size_ = size;
+#endif
+
+		return r;
+	}
+
+	inline auto remove_shared_mapping(char const* name) -> void
+	{
+#if defined(ATMA_PLATFORM_WINDOWS)
+		(void)name;
+#else
+		std::string posix_name = name[0] == '/' ? name : std::string{"/"} + name;
+		shm_unlink(posix_name.c_str());
+#endif
+	}
+
+} }
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <atma/config/platform.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#if defined(ATMA_PLATFORM_WINDOWS)
+#  pragma comment(lib, "Synchronization.lib")
+#elif defined(__linux__)
+#  include <linux/futex.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#  include <ctime>
+#elif defined(__APPLE__)
+// the ulock calls aren't in any header, but are what libc++ builds std::atomic::wait on
+extern "C" int __ulock_wait(uint32_t operation, void* addr, uint64_t value, uint32_t timeout_us);
+extern "C" int __ulock_wake(uint32_t operation, void* addr, uint64_t wake_value);
+#endif
+
+import atma.types;
+
+namespace atma { namespace platform {
+
+	//
+	// interprocess_wakeups_t
+	// ------------------------
+	//  what a process needs to wait on an address in memory shared with other
+	//  processes. linux and macos wait on shared addresses directly, so there's
+	//  nothing to it. windows can't, so it's a semaphore that every process opens
+	//  by the same name, released once for every waiter
+	//
+	struct interprocess_wakeups_t
+	{
+		explicit interprocess_wakeups_t(char const* name);
+		interprocess_wakeups_t(interprocess_wakeups_t const&) = delete;
+		~interprocess_wakeups_t();
+
+	private:
+#if defined(ATMA_PLATFORM_WINDOWS)
+		HANDLE semaphore_ = nullptr;
+#endif
+
+		friend auto wait_on_address(std::atomic<uint32>&, uint32, std::chrono::nanoseconds, interprocess_wakeups_t const*) -> void;
+		friend auto wake_by_address_all(std::atomic<uint32>&, interprocess_wakeups_t const*, uint32) -> void;
+	};
+
+	//
+	// wait_on_address
+	// -----------------
+	//  parks the calling thread while addr holds expected, for at most timeout. unlike
+	//  std::atomic::wait this is bounded, but it can also return spuriously, so callers
+	//  must re-check whatever it is they're waiting on
+	//
+	//  interprocess waits are on an address in memory shared with other processes,
+	//  which other processes may wake
+	//
+	auto wait_on_address(std::atomic<uint32>& addr, uint32 expected, std::chrono::nanoseconds timeout, interprocess_wakeups_t const* interprocess = nullptr) -> void;
+
+	// wakes every thread parked on addr. interprocess waiters on windows are woken
+	// by releasing them one at a time, so say how many there might be
+	auto wake_by_address_all(std::atomic<uint32>& addr, interprocess_wakeups_t const* interprocess = nullptr, uint32 waiters = 1) -> void;
+
+
+
+
+	inline interprocess_wakeups_t::interprocess_wakeups_t(char const* name)
+	{
+#if defined(ATMA_PLATFORM_WINDOWS)
+		// named objects share a namespace, so mustn't clash with the shared-memory region
+		auto semaphore_name = std::string{name} + ".wakeups";
+		semaphore_ = CreateSemaphoreA(nullptr, 0, LONG_MAX, semaphore_name.c_str());
+#else
+		(void)name;
+#endif
+	}
+
+	inline interprocess_wakeups_t::~interprocess_wakeups_t()
+	{
+#if defined(ATMA_PLATFORM_WINDOWS)
+		if (semaphore_)
+			CloseHandle(semaphore_);
+#endif
+	}
+
+#if !defined(ATMA_PLATFORM_WINDOWS) && !defined(__linux__) && !defined(__APPLE__)
+	// with no way to wait on an address, threads park on a condition-variable picked
+	// by address instead. that only works within a process
+	struct parking_lot_t
+	{
+		static constexpr size_t bucket_count = 64;
+
+		struct bucket_t
+		{
+			std::mutex mutex;
+			std::condition_variable cv;
+		};
+
+		static auto bucket(void const* addr) -> bucket_t&
+		{
+			static bucket_t buckets[bucket_count];
+			return buckets[(reinterpret_cast<uintptr_t>(addr) >> 4) % bucket_count];
+		}
+	};
+#endif
+
+	inline auto wait_on_address(std::atomic<uint32>& addr, uint32 expected, std::chrono::nanoseconds timeout, interprocess_wakeups_t const* interprocess) -> void
+	{
+		if (timeout <= std::chrono::nanoseconds::zero())
+			return;
+
+#if defined(ATMA_PLATFORM_WINDOWS)
+		auto ms = (DWORD)std::min<int64>(std::chrono::ceil<std::chrono::milliseconds>(timeout).count(), INFINITE - 1);
+
+		// a wakeup released between our check and the wait is kept by the semaphore
+		if (interprocess)
+		{
+			if (addr.load() == expected)
+				WaitForSingleObject(interprocess->semaphore_, ms);
+			return;
+		}
+
+		WaitOnAddress(&addr, &expected, sizeof(uint32), ms);
+#elif defined(__linux__)
+		auto s = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+		timespec ts{(time_t)s.count(), (long)(timeout - s).count()};
+		syscall(SYS_futex, reinterpret_cast<uint32*>(&addr), interprocess ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE, expected, &ts, nullptr, 0);
+#elif defined(__APPLE__)
+		// UL_COMPARE_AND_WAIT(_SHARED). a timeout of zero is forever
+		uint32_t const operation = interprocess ? 3 : 1;
+		auto us = std::chrono::ceil<std::chrono::microseconds>(timeout).count();
+		__ulock_wait(operation, &addr, expected, (uint32_t)std::clamp<int64>(us, 1, UINT32_MAX));
+#else
+		if (interprocess)
+		{
+			// nothing to park on, so nap in short slices instead
+			if (addr.load() == expected)
+				std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(timeout, std::chrono::microseconds{100}));
+			return;
+		}
+
+		auto& bucket = parking_lot_t::bucket(&addr);
+		std::unique_lock<std::mutex> lock{bucket.mutex};
+		if (addr.load() == expected)
+			bucket.cv.wait_for(lock, timeout);
+#endif
+	}
+
+	inline auto wake_by_address_all(std::atomic<uint32>& addr, interprocess_wakeups_t const* interprocess, uint32 waiters) -> void
+	{
+#if defined(ATMA_PLATFORM_WINDOWS)
+		if (!interprocess)
+			WakeByAddressAll(&addr);
+		else if (waiters != 0)
+			ReleaseSemaphore(interprocess->semaphore_, (LONG)std::min<uint32>(waiters, LONG_MAX), nullptr);
+#elif defined(__linux__)
+		(void)waiters;
+		syscall(SYS_futex, reinterpret_cast<uint32*>(&addr), interprocess ? FUTEX_WAKE : FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#elif defined(__APPLE__)
+		// UL_COMPARE_AND_WAIT(_SHARED) | ULF_WAKE_ALL
+		(void)waiters;
+		uint32_t const operation = (interprocess ? 3 : 1) | 0x100;
+		__ulock_wake(operation, &addr, 0);
+#else
+		(void)waiters;
+		if (interprocess)
+			return;
+
+		// taking the lock means a waiter is either yet to check addr, or already waiting
+		auto& bucket = parking_lot_t::bucket(&addr);
+		{
+			std::lock_guard<std::mutex> lock{bucket.mutex};
+		}
+		bucket.cv.notify_all();
+#endif
+	}
+
+} }
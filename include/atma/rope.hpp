@@ -4,8 +4,10 @@
 #include <atma/ranges/core.hpp>
 #include <atma/algorithm.hpp>
 #include <atma/utf/utf8_string.hpp>
+#include <atma/bytestream.hpp>
 
 #include <optional>
+#include <limits>
 #include <array>
 #include <functional>
 #include <utility>
@@ -15,9 +17,33 @@
 #include <ranges>
 #include <variant>
 #include <ranges>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <bit>
+#include <algorithm>
+#include <string_view>
+#include <unordered_set>
+#include <exception>
 
 #define ATMA_ROPE_DEBUG_BUFFER 1
 
+// simd kernels for leaf text-metrics are x64-only, selected at runtime
+#if defined(_M_X64) || defined(__x86_64__)
+#	define ATMA_ROPE_SIMD_X64 1
+#	include <immintrin.h>
+#	if defined(_MSC_VER)
+#		include <intrin.h>
+#		define ATMA_ROPE_SIMD_TARGET(...)
+#	else
+#		define ATMA_ROPE_SIMD_TARGET(...) __attribute__((target(__VA_ARGS__)))
+#	endif
+#else
+#	define ATMA_ROPE_SIMD_X64 0
+#endif
+
 //export module atma.rope;
 
 import atma.bind;
@@ -86,6 +112,8 @@ namespace atma::_rope_
 
 	template <typename> struct node_internal_t;
 	template <typename> struct node_leaf_t;
+	template <typename> struct node_buffer_leaf_t;
+	template <typename> struct node_mapped_leaf_t;
 	template <typename> struct node_t;
 
 	template <typename RT> using node_ptr = intrusive_ptr<node_t<RT>>;
@@ -118,6 +146,8 @@ namespace atma::_rope_
 
 	template <typename> struct build_rope_t_;
 
+	template <typename RT> auto destroy_node_(node_t<RT> const*) -> void;
+
 
 
 
@@ -131,13 +161,467 @@ namespace atma::_rope_
 	}
 }
 
+namespace atma
+{
+	// all node-pointers release their nodes through the node allocator
+	template <typename RT>
+	struct ref_counted_traits<_rope_::node_t<RT>>
+	{
+		static auto add_ref(ref_counted const* t) -> void
+		{
+			if (t)
+			{
+				++t->ref_count_;
+			}
+		}
+
+		static auto rm_ref(_rope_::node_t<RT> const* t) -> void
+		{
+			if (t && --static_cast<ref_counted const*>(t)->ref_count_ == 0)
+			{
+				_rope_::destroy_node_<RT>(t);
+			}
+		}
+
+		// a node with a use-count of one is only reachable through one tree
+		static auto use_count(ref_counted const* t) -> uint32_t
+		{
+			return t->ref_count_.load();
+		}
+	};
+
+	template <typename RT>
+	struct ref_counted_traits<_rope_::node_internal_t<RT>>
+		: ref_counted_traits<_rope_::node_t<RT>>
+	{};
+
+	template <typename RT>
+	struct ref_counted_traits<_rope_::node_leaf_t<RT>>
+		: ref_counted_traits<_rope_::node_t<RT>>
+	{};
+
+	template <typename RT>
+	struct ref_counted_traits<_rope_::node_buffer_leaf_t<RT>>
+		: ref_counted_traits<_rope_::node_t<RT>>
+	{};
+
+	template <typename RT>
+	struct ref_counted_traits<_rope_::node_mapped_leaf_t<RT>>
+		: ref_counted_traits<_rope_::node_t<RT>>
+	{};
+}
+
+
+//
+// slab_pool_t
+// -------------
+//  a fixed-size-block pool. blocks are carved out of large slabs, and
+//  freed blocks are threaded onto a free-list to be handed out again.
+//
+//  each thread keeps a small cache of free blocks in front of the shared
+//  free-list, and only takes the pool's lock to move a batch of blocks
+//  between the two. so threads building or reducing ropes in parallel
+//  don't serialize on every node. a thread's cache is flushed back to
+//  the pool when the thread exits
+//
+//  slabs are never returned upstream: a slab can only be given back once
+//  every one of its blocks is free, and blocks of a slab end up scattered
+//  across the free-lists of every thread. so a pool only ever grows to the
+//  high-water mark of its live blocks (plus what's sitting in caches)
+//
+//  pools are trivially destructible so that ropes with static storage
+//  duration can safely release their nodes during program shutdown
+//
+namespace atma::_rope_
+{
+	struct slab_pool_stats_t
+	{
+		// blocks handed out / returned by the pool
+		size_t allocations = 0;
+		size_t deallocations = 0;
+
+		// allocations made upstream, one per slab
+		size_t slab_allocations = 0;
+
+		auto live_blocks() const -> size_t { return allocations - deallocations; }
+
+		auto operator + (slab_pool_stats_t const& rhs) const -> slab_pool_stats_t
+		{
+			return {
+				allocations + rhs.allocations,
+				deallocations + rhs.deallocations,
+				slab_allocations + rhs.slab_allocations};
+		}
+	};
+
+	template <size_t BlockSize, size_t BlockAlignment>
+	struct slab_pool_t
+	{
+		static auto instance() -> slab_pool_t&
+		{
+			static slab_pool_t pool;
+			return pool;
+		}
+
+		auto allocate() -> void*
+		{
+			auto& cache = thread_cache_();
+
+			if (cache.free_list == nullptr)
+				refill_(cache);
+
+			block_t* result = cache.free_list;
+			cache.free_list = result->next;
+			--cache.size;
+
+			if (cache.retired)
+				flush_(cache, cache.size);
+
+			allocations_.fetch_add(1, std::memory_order_relaxed);
+			return result->storage;
+		}
+
+		auto deallocate(void* ptr) -> void
+		{
+			auto* block = reinterpret_cast<block_t*>(ptr);
+			auto& cache = thread_cache_();
+
+			block->next = cache.free_list;
+			cache.free_list = block;
+			++cache.size;
+
+			deallocations_.fetch_add(1, std::memory_order_relaxed);
+
+			// a thread that's exiting (or has) can't cache anything
+			if (cache.size == cache_capacity || cache.retired)
+				flush_(cache, cache.retired ? cache.size : cache_batch_size);
+		}
+
+		auto stats() -> slab_pool_stats_t
+		{
+			lock_();
+			size_t slab_allocations = slab_allocations_;
+			unlock_();
+
+			return {
+				allocations_.load(std::memory_order_relaxed),
+				deallocations_.load(std::memory_order_relaxed),
+				slab_allocations};
+		}
+
+	private:
+		union block_t
+		{
+			block_t* next;
+			alignas(BlockAlignment) std::byte storage[BlockSize];
+		};
+
+		// roughly 64kb per slab, but at least a handful of blocks
+		static constexpr size_t blocks_per_slab = std::max<size_t>(8, (64 * 1024) / sizeof(block_t));
+
+		// blocks a thread may cache, and how many move to or from the pool at once
+		static constexpr size_t cache_capacity = 64;
+		static constexpr size_t cache_batch_size = cache_capacity / 2;
+
+		struct slab_t
+		{
+			slab_t* next;
+			block_t blocks[blocks_per_slab];
+		};
+
+		// trivially destructible, so it's still usable after retire_cache_t has
+		// run, by nodes released later on in the thread's exit
+		struct thread_cache_t
+		{
+			block_t* free_list = nullptr;
+			size_t size = 0;
+			bool registered = false;
+			bool retired = false;
+		};
+
+		struct retire_cache_t
+		{
+			~retire_cache_t()
+			{
+				auto& cache = cache_storage_;
+				cache.retired = true;
+				instance().flush_(cache, cache.size);
+			}
+		};
+
+		inline static thread_local thread_cache_t cache_storage_;
+
+		static auto thread_cache_() -> thread_cache_t&
+		{
+			auto& cache = cache_storage_;
+			if (!cache.registered)
+			{
+				// constructs it, so that it's destructed on thread exit
+				static thread_local retire_cache_t retire_cache;
+				(void)retire_cache;
+				cache.registered = true;
+			}
+
+			return cache;
+		}
+
+		auto refill_(thread_cache_t& cache) -> void
+		{
+			lock_();
+
+			for (size_t i = 0; i != cache_batch_size; ++i)
+			{
+				if (free_list_ == nullptr)
+					allocate_slab_();
+
+				block_t* block = free_list_;
+				free_list_ = block->next;
+
+				block->next = cache.free_list;
+				cache.free_list = block;
+			}
+
+			unlock_();
+
+			cache.size += cache_batch_size;
+		}
+
+		auto flush_(thread_cache_t& cache, size_t count) -> void
+		{
+			if (count == 0)
+				return;
+
+			// the first count blocks of the cache go back, as a chain
+			block_t* first = cache.free_list;
+			block_t* last = first;
+			for (size_t i = 1; i != count; ++i)
+				last = last->next;
+
+			cache.free_list = last->next;
+			cache.size -= count;
+
+			lock_();
+			last->next = free_list_;
+			free_list_ = first;
+			unlock_();
+		}
+
+		auto allocate_slab_() -> void
+		{
+			auto* slab = new slab_t;
+			slab->next = slabs_;
+			slabs_ = slab;
+			++slab_allocations_;
+
+			for (size_t i = blocks_per_slab; i-- != 0; )
+			{
+				slab->blocks[i].next = free_list_;
+				free_list_ = &slab->blocks[i];
+			}
+		}
+
+		auto lock_() -> void
+		{
+			while (lock_flag_.test_and_set(std::memory_order_acquire))
+			{
+				// unlock_ only notifies if it sees us waiting, so we must be
+				// counted before we check the flag again in wait
+				waiters_.fetch_add(1);
+				lock_flag_.wait(true);
+				waiters_.fetch_sub(1);
+			}
+		}
+
+		auto unlock_() -> void
+		{
+			lock_flag_.clear();
+			if (waiters_.load() != 0)
+				lock_flag_.notify_one();
+		}
+
+	private:
+		std::atomic_flag lock_flag_;
+		std::atomic<uint32_t> waiters_{0};
+		block_t* free_list_ = nullptr;
+		slab_t* slabs_ = nullptr;
+		size_t slab_allocations_ = 0;
+
+		// counted outside of the lock, as allocations mostly don't take it
+		std::atomic<size_t> allocations_{0};
+		std::atomic<size_t> deallocations_{0};
+	};
+}
+
+
+//
+// rope_pool_allocator_t
+// -----------------------
+//  the default node allocator. allocator_traits rebinds it to each node
+//  type, and each node type is then served from a slab pool shared by
+//  every type of the same size-class
+//
+namespace atma
+{
+	template <typename T>
+	struct rope_pool_allocator_t
+	{
+		using value_type = T;
+
+		static constexpr size_t size_class = _rope_::ceil_div<size_t>(sizeof(T), 16) * 16;
+		static constexpr size_t alignment = std::max(alignof(T), alignof(void*));
+
+		using pool_type = _rope_::slab_pool_t<size_class, alignment>;
+
+		rope_pool_allocator_t() noexcept = default;
+
+		template <typename U>
+		rope_pool_allocator_t(rope_pool_allocator_t<U> const&) noexcept
+		{}
+
+		auto allocate(size_t n) -> T*
+		{
+			if (n != 1)
+				return std::allocator<T>{}.allocate(n);
+
+			return reinterpret_cast<T*>(pool_type::instance().allocate());
+		}
+
+		auto deallocate(T* ptr, size_t n) -> void
+		{
+			if (n != 1)
+				return std::allocator<T>{}.deallocate(ptr, n);
+
+			pool_type::instance().deallocate(ptr);
+		}
+
+		static auto stats() -> _rope_::slab_pool_stats_t
+		{
+			return pool_type::instance().stats();
+		}
+	};
+
+	template <typename T, typename U>
+	inline bool operator == (rope_pool_allocator_t<T> const&, rope_pool_allocator_t<U> const&)
+	{
+		return true;
+	}
+}
+
+
+//
+// summaries
+//
+namespace atma
+{
+	// rope_summary_concept
+	// ----------------------
+	//  an additional summary of text, aggregated through the tree alongside
+	//  bytes, characters and line-breaks. a default-constructed summary is
+	//  the summary of no text, from_str summarises some whole characters,
+	//  + summarises one text followed by another, and - takes the summary
+	//  of a text's end back off, so that (a + b) - b is a. summaries are
+	//  cached in the nodes as they're asked for, so must be trivially copyable
+	//
+	template <typename T>
+	concept rope_summary_concept = std::default_initializable<T> && std::is_trivially_copyable_v<T> &&
+		requires(T const& x, char const* str, size_t size)
+		{
+			{ T::from_str(str, size) } -> std::same_as<T>;
+			{ x + x } -> std::same_as<T>;
+			{ x - x } -> std::same_as<T>;
+		};
+
+	// nothing more than the built-in metrics
+	struct rope_no_summary_t
+	{
+		static auto from_str(char const*, size_t) -> rope_no_summary_t { return {}; }
+	};
+
+	inline auto operator + (rope_no_summary_t, rope_no_summary_t) -> rope_no_summary_t { return {}; }
+	inline auto operator - (rope_no_summary_t, rope_no_summary_t) -> rope_no_summary_t { return {}; }
+
+	// utf-16 code-units, which is how language-servers address text
+	struct rope_utf16_summary_t
+	{
+		size_t code_units = 0;
+
+		static auto from_str(char const* str, size_t size) -> rope_utf16_summary_t
+		{
+			// one unit per character, and another for the surrogate-pair
+			// of anything beyond the basic multilingual plane (4-byte utf8)
+			size_t result = 0;
+			for (size_t i = 0; i != size; ++i)
+			{
+				auto const x = uint8_t(str[i]);
+				result += (x & 0xc0) != 0x80;
+				result += x >= 0xf0;
+			}
+
+			return {result};
+		}
+	};
+
+	inline auto operator + (rope_utf16_summary_t const& lhs, rope_utf16_summary_t const& rhs) -> rope_utf16_summary_t
+	{
+		return {lhs.code_units + rhs.code_units};
+	}
+
+	inline auto operator - (rope_utf16_summary_t const& lhs, rope_utf16_summary_t const& rhs) -> rope_utf16_summary_t
+	{
+		return {lhs.code_units - rhs.code_units};
+	}
+}
+
+
+//
+// mapped text
+//
+namespace atma
+{
+	// rope_mapped_text_t
+	// --------------------
+	//  read-only text that lives somewhere other than a rope's own buffers,
+	//  most likely a memory-mapped file. ropes built from it view ranges of
+	//  it directly, and keep it alive for as long as any of them do. the
+	//  text must not change underneath them
+	//
+	struct rope_mapped_text_t
+	{
+		rope_mapped_text_t(char const* data, size_t size)
+			: data_{data}, size_{size}
+		{}
+
+		virtual ~rope_mapped_text_t() = default;
+
+		// not copyable
+		rope_mapped_text_t(rope_mapped_text_t const&) = delete;
+		rope_mapped_text_t& operator = (rope_mapped_text_t const&) = delete;
+
+		auto data() const -> char const* { return data_; }
+		auto size() const -> size_t { return size_; }
+
+		// counted here rather than by atma::ref_counted, so that the last
+		// reference deletes through our virtual destructor
+		auto ref_counted_add_ref() const -> void { ++ref_count_; }
+		auto ref_counted_rm_ref() const -> uint32_t { return --ref_count_; }
+
+	private:
+		char const* data_ = nullptr;
+		size_t size_ = 0;
+
+		mutable std::atomic<uint32_t> ref_count_{0};
+	};
+
+	using rope_mapped_text_ptr = intrusive_ptr<rope_mapped_text_t>;
+}
+
 
 //
 // traits
 //
 namespace atma
 {
-	template <size_t BranchingFactor, size_t BufferSize, bool Debug = false>
+	template <size_t BranchingFactor, size_t BufferSize, bool Debug = false, typename Allocator = rope_pool_allocator_t<std::byte>, typename Summary = rope_no_summary_t>
 	struct rope_basic_traits
 	{
 		// how many children an internal node has
@@ -152,11 +636,26 @@ namespace atma
 		constexpr static size_t buf_edit_split_size = (buf_size / 2) - (buf_size / 32);
 		constexpr static size_t buf_edit_split_drift_size = (buf_size / 32);
 
+		// mapped leaves are never edited in place, so don't need to fit in a
+		// buffer. they're cut from the mapped text this big, and only cut down
+		// to buffer-sized pieces around wherever the text is edited
+		constexpr static size_t mapped_leaf_size = buf_size * 128;
+
 		constexpr static bool const debug_internal_validation = Debug;
+
+		// allocator for leaf & internal nodes, rebound to each node type. it
+		// is default-constructed wherever it's used, so must be stateless
+		// (or, like std::pmr::polymorphic_allocator, default to something sane)
+		using allocator_type = Allocator;
+
+		// an additional summary aggregated through the tree
+		static_assert(rope_summary_concept<Summary>);
+		using summary_type = Summary;
 	};
 
 	using rope_default_traits = rope_basic_traits<4, 512>;
 	using rope_test_traits = rope_basic_traits<4, 9, true>;
+	using rope_utf16_traits = rope_basic_traits<4, 512, false, rope_pool_allocator_t<std::byte>, rope_utf16_summary_t>;
 }
 
 namespace atma::_rope_
@@ -173,6 +672,22 @@ namespace atma::_rope_
 
 	template <typename RT>
 	inline constexpr bool debug_internal_validation_v = debug_internal_validation_t<RT>::value;
+
+
+	template <typename RT, typename = std::void_t<>>
+	struct node_allocator_t
+	{
+		using type = rope_pool_allocator_t<std::byte>;
+	};
+
+	template <typename RT>
+	struct node_allocator_t<RT, std::void_t<typename RT::allocator_type>>
+	{
+		using type = typename RT::allocator_type;
+	};
+
+	template <typename RT, typename Node>
+	using node_allocator_for_t = typename std::allocator_traits<typename node_allocator_t<RT>::type>::template rebind_alloc<Node>;
 }
 
 
@@ -225,6 +740,23 @@ namespace atma::_rope_
 			append(std::data(memory), std::size(memory));
 		}
 
+		// insert/erase are only for buffers that nothing else is viewing
+		void insert(size_t idx, char const* data, size_t size)
+		{
+			ATMA_ASSERT(idx <= size_);
+			ATMA_ASSERT(size_ + size <= Extent);
+			memmove(chars_ + idx + size, chars_ + idx, size_ - idx);
+			memcpy(chars_ + idx, data, size);
+			size_ += size;
+		}
+
+		void erase(size_t idx, size_t size)
+		{
+			ATMA_ASSERT(idx + size <= size_);
+			memmove(chars_ + idx, chars_ + idx + size, size_ - idx - size);
+			size_ -= size;
+		}
+
 		char operator[](size_t idx) const { return chars_[idx]; }
 
 	private:
@@ -239,6 +771,17 @@ namespace atma::_rope_
 //
 namespace atma::_rope_
 {
+	// leaf_text_info_t is the compact form of our metrics, which is
+	// what we calculate when we scan the text of one leaf. a buffer can
+	// never hold more than buf_size bytes, so 16 bits is plenty. longer
+	// text (that of a mapped leaf, say) is scanned in runs that fit it
+	//
+	// text_info_t is the aggregated form, which is what we store for
+	// every subtree (and thus for the root). these are summed up the
+	// tree, so they need to be able to address a whole document. we're
+	// using 32 bits per counter, which gives us documents of up to 4GB,
+	// and keeps tree_t at 32 bytes (two to a cache-line).
+	//
 	// dropped indicates how many characters at the front of the
 	// buffer we're ignoring
 	//
@@ -248,6 +791,20 @@ namespace atma::_rope_
 	// character at the end of the previous chunk, and "drop" one character
 	// from this chunk.
 	struct text_info_t
+	{
+		uint32_t bytes = 0;
+		uint32_t characters = 0;
+		uint32_t dropped_bytes = 0;
+		uint32_t dropped_characters = 0;
+		uint32_t line_breaks = 0;
+
+		auto all_bytes() const { return dropped_bytes + bytes; }
+		auto all_characters() const { return dropped_characters + characters; }
+
+		static text_info_t from_str(char const* str, size_t sz);
+	};
+
+	struct leaf_text_info_t
 	{
 		uint16_t bytes = 0;
 		uint16_t characters = 0;
@@ -256,12 +813,17 @@ namespace atma::_rope_
 		uint16_t line_breaks = 0;
 		uint16_t _pad_ = 0;
 
-		auto all_bytes() const { return dropped_bytes + bytes; }
-		auto all_characters() const { return dropped_characters + characters; }
+		// widening is always safe
+		operator text_info_t() const
+		{
+			return text_info_t{bytes, characters, dropped_bytes, dropped_characters, line_breaks};
+		}
 
-		static text_info_t from_str(char const* str, size_t sz);
+		static leaf_text_info_t from_str(char const* str, size_t sz);
 	};
 
+	static_assert(sizeof(leaf_text_info_t) == 12, "leaf_text_info_t should stay compact");
+
 	inline auto operator == (text_info_t const& lhs, text_info_t const& rhs) -> bool
 	{
 		return lhs.bytes == rhs.bytes
@@ -274,21 +836,21 @@ namespace atma::_rope_
 	inline auto operator + (text_info_t const& lhs, text_info_t const& rhs) -> text_info_t
 	{
 		return text_info_t{
-			(uint16_t)(lhs.bytes + rhs.bytes),
-			(uint16_t)(lhs.characters + rhs.characters),
-			(uint16_t)(lhs.dropped_bytes + rhs.dropped_characters),
-			(uint16_t)(lhs.dropped_characters + rhs.dropped_characters),
-			(uint16_t)(lhs.line_breaks + rhs.line_breaks)};
+			lhs.bytes + rhs.bytes,
+			lhs.characters + rhs.characters,
+			lhs.dropped_bytes + rhs.dropped_bytes,
+			lhs.dropped_characters + rhs.dropped_characters,
+			lhs.line_breaks + rhs.line_breaks};
 	}
 
 	inline auto operator - (text_info_t const& lhs, text_info_t const& rhs) -> text_info_t
 	{
 		return text_info_t{
-			(uint16_t)(lhs.bytes - rhs.bytes),
-			(uint16_t)(lhs.characters - rhs.characters),
-			(uint16_t)(lhs.dropped_bytes - rhs.dropped_characters),
-			(uint16_t)(lhs.dropped_characters - rhs.dropped_characters),
-			(uint16_t)(lhs.line_breaks - rhs.line_breaks)};
+			lhs.bytes - rhs.bytes,
+			lhs.characters - rhs.characters,
+			lhs.dropped_bytes - rhs.dropped_bytes,
+			lhs.dropped_characters - rhs.dropped_characters,
+			lhs.line_breaks - rhs.line_breaks};
 	}
 }
 
@@ -321,6 +883,10 @@ namespace atma::_rope_
 
 		auto is_saturated() const;
 
+		// whether another child fits, as viewed by info. the node itself may
+		// be full of children appended through other trees
+		auto has_space_for_another_child() const -> bool;
+
 		auto children() const;
 		auto backing_children() const;
 
@@ -458,22 +1024,102 @@ namespace atma::_rope_
 	{
 		branch,
 		leaf,
+		mapped_leaf,
 	};
 
-
-	template <typename RT>
-	struct node_t : atma::ref_counted_of<node_t<RT>>
+	// node_view_cache_t
+	// -------------------
+	//  something computed from a few views of a node, as a node shared
+	//  between ropes is often viewed differently by each. each view to be
+	//  computed claims an entry, and once they're all claimed other views
+	//  are recomputed each time they're asked for. a claimed entry doesn't
+	//  change (barring an in-place edit, which needs the node to be uniquely
+	//  owned), so readers on any thread need only acquire its key
+	//
+	template <typename T>
+	struct node_view_cache_t
 	{
-		node_t(node_type_t, uint32_t height);
+		static constexpr uint64_t unclaimed = 0;
+		static constexpr uint64_t claiming = ~uint64_t();
+		static constexpr size_t views = 4;
 
-		constexpr bool is_branch() const;
-		constexpr bool is_leaf() const;
+		auto get(uint64_t view) const -> std::optional<T>
+		{
+			for (auto const& x : entries_)
+			{
+				if (x.key.load(std::memory_order_acquire) == view)
+					return x.value;
+			}
 
-		auto as_branch() -> node_internal_t<RT>&;
-		auto as_leaf() -> node_leaf_t<RT>&;
+			return std::nullopt;
+		}
 
-		auto as_branch() const -> node_internal_t<RT> const&;
-		auto as_leaf() const -> node_leaf_t<RT> const&;
+		auto set(uint64_t view, T const& value) const -> void
+		{
+			ATMA_ASSERT(view != unclaimed && view != claiming);
+
+			for (auto& x : entries_)
+			{
+				uint64_t expected = unclaimed;
+				if (x.key.compare_exchange_strong(expected, claiming, std::memory_order_acquire))
+				{
+					x.value = value;
+					x.key.store(view, std::memory_order_release);
+					return;
+				}
+				else if (expected == view)
+				{
+					return;
+				}
+			}
+		}
+
+		// only for nodes that nothing else can be reading
+		auto reset() -> void
+		{
+			for (auto& x : entries_)
+				x.key.store(unclaimed, std::memory_order_relaxed);
+		}
+
+	private:
+		struct entry_t
+		{
+			std::atomic<uint64_t> key{unclaimed};
+			T value{};
+		};
+
+		mutable std::array<entry_t, views> entries_;
+	};
+
+	// ropes without a summary don't pay for caching one
+	template <>
+	struct node_view_cache_t<rope_no_summary_t>
+	{
+		auto get(uint64_t) const -> std::optional<rope_no_summary_t> { return rope_no_summary_t{}; }
+		auto set(uint64_t, rope_no_summary_t) const -> void {}
+		auto reset() -> void {}
+	};
+
+	using node_hash_cache_t = node_view_cache_t<uint64_t>;
+
+	template <typename RT>
+	using node_summary_cache_t = node_view_cache_t<typename RT::summary_type>;
+
+
+	template <typename RT>
+	struct node_t : atma::ref_counted_of<node_t<RT>>
+	{
+		node_t(node_type_t, uint32_t height);
+
+		constexpr bool is_branch() const;
+		constexpr bool is_leaf() const;
+		constexpr bool is_mapped_leaf() const;
+
+		auto as_branch() -> node_internal_t<RT>&;
+		auto as_leaf() -> node_leaf_t<RT>&;
+
+		auto as_branch() const -> node_internal_t<RT> const&;
+		auto as_leaf() const -> node_leaf_t<RT> const&;
 
 		auto height() const -> uint32_t;
 
@@ -544,11 +1190,19 @@ namespace atma::_rope_
 			return size_ < RT::branching_factor;
 		}
 
+		// keyed by the child-count of the view
+		node_hash_cache_t hash_cache;
+		node_summary_cache_t<RT> summary_cache;
+
 	private:
 		uint32_t size_ = 0;
 		std::array<tree_t<RT>, RT::branching_factor> children_;
 	};
 
+	// the widened text_info_t (5 x uint32) plus child-count and node-pointer
+	// pack exactly into 32 bytes. descending the tree touches every child's
+	// info, so keeping children two-to-a-cache-line matters
+	static_assert(sizeof(tree_t<rope_default_traits>) == 32, "tree_t should be 32 bytes big");
 }
 
 
@@ -557,18 +1211,51 @@ namespace atma::_rope_
 //
 namespace atma::_rope_
 {
+	// what's common to both kinds of leaf. trees view some byte-range of
+	// a leaf's text, which is either owned by the leaf or mapped
 	template <typename RT>
 	struct node_leaf_t : node_t<RT>
 	{
-		template <typename... Args>
-		node_leaf_t(Args&&...);
-
 		using buf_t = charbuf_t<RT::buf_size>;
 
+		auto text() const -> src_buf_t;
+
+		// only leaves that own their text have a buffer
+		auto buffer() -> buf_t&;
+		auto buffer() const -> buf_t const&;
+
+		// keyed by the byte-range of the view
+		node_hash_cache_t hash_cache;
+		node_summary_cache_t<RT> summary_cache;
+
+	protected:
+		explicit node_leaf_t(node_type_t);
+	};
+
+	template <typename RT>
+	struct node_buffer_leaf_t : node_leaf_t<RT>
+	{
+		template <typename... Args>
+		node_buffer_leaf_t(Args&&...);
+
 		// this buffer can only ever be appended to. nodes store how many
 		// characters/bytes they address inside this buffer, so we can append
 		// more data to this buffer and maintain an immutable data-structure
-		buf_t buf;
+		typename node_leaf_t<RT>::buf_t buf;
+	};
+
+	// a read-only range of someone else's text, usually a memory-mapped file.
+	// it's never written to, so editing a mapped leaf copies the edited text
+	// into a new buffer-leaf. it's a fraction of the size of a buffer-leaf,
+	// and can view up to mapped_leaf_size bytes
+	template <typename RT>
+	struct node_mapped_leaf_t : node_leaf_t<RT>
+	{
+		node_mapped_leaf_t(rope_mapped_text_ptr const& source, size_t offset, size_t size);
+
+		rope_mapped_text_ptr source;
+		char const* data = nullptr;
+		uint32_t size = 0;
 	};
 }
 
@@ -579,16 +1266,86 @@ namespace atma::_rope_
 //
 namespace atma::_rope_
 {
+	template <typename RT, typename Node, typename... Args>
+	inline auto allocate_node_(Args&&... args) -> Node*
+	{
+		using allocator_t = node_allocator_for_t<RT, Node>;
+		using allocator_traits_t = std::allocator_traits<allocator_t>;
+
+		allocator_t allocator;
+		Node* result = allocator_traits_t::allocate(allocator, 1);
+		allocator_traits_t::construct(allocator, result, std::forward<Args>(args)...);
+		return result;
+	}
+
+	template <typename RT, typename Node>
+	inline auto deallocate_node_(Node* node) -> void
+	{
+		using allocator_t = node_allocator_for_t<RT, Node>;
+		using allocator_traits_t = std::allocator_traits<allocator_t>;
+
+		allocator_t allocator;
+		allocator_traits_t::destroy(allocator, node);
+		allocator_traits_t::deallocate(allocator, node, 1);
+	}
+
+	// node_t has no virtual destructor, so we must destroy as the concrete type
+	template <typename RT>
+	inline auto destroy_node_(node_t<RT> const* node) -> void
+	{
+		auto* x = const_cast<node_t<RT>*>(node);
+
+		if (x->is_mapped_leaf())
+			deallocate_node_<RT>(static_cast<node_mapped_leaf_t<RT>*>(&x->as_leaf()));
+		else if (x->is_leaf())
+			deallocate_node_<RT>(static_cast<node_buffer_leaf_t<RT>*>(&x->as_leaf()));
+		else
+			deallocate_node_<RT>(&x->as_branch());
+	}
+
 	template <typename RT, typename... Args>
 	inline node_ptr<RT> make_internal_ptr(Args&&... args)
 	{
-		return node_internal_ptr<RT>::make(std::forward<Args>(args)...);
+		return node_ptr<RT>{allocate_node_<RT, node_internal_t<RT>>(std::forward<Args>(args)...)};
 	}
 
 	template <typename RT, typename... Args>
 	inline node_ptr<RT> make_leaf_ptr(Args&&... args)
 	{
-		return node_leaf_ptr<RT>::make(std::forward<Args>(args)...);
+		return node_ptr<RT>{allocate_node_<RT, node_buffer_leaf_t<RT>>(std::forward<Args>(args)...)};
+	}
+
+	template <typename RT>
+	inline node_ptr<RT> make_mapped_leaf_ptr(rope_mapped_text_ptr const& source, size_t offset, size_t size)
+	{
+		return node_ptr<RT>{allocate_node_<RT, node_mapped_leaf_t<RT>>(source, offset, size)};
+	}
+}
+
+namespace atma::_rope_
+{
+	// sums the statistics of the pools serving RT's nodes, counting each
+	// distinct pool once
+	template <typename RT>
+	inline auto node_pool_stats() -> slab_pool_stats_t
+	{
+		using leaf_allocator_t = node_allocator_for_t<RT, node_buffer_leaf_t<RT>>;
+		using mapped_allocator_t = node_allocator_for_t<RT, node_mapped_leaf_t<RT>>;
+		using internal_allocator_t = node_allocator_for_t<RT, node_internal_t<RT>>;
+
+		using leaf_pool_t = typename leaf_allocator_t::pool_type;
+		using mapped_pool_t = typename mapped_allocator_t::pool_type;
+		using internal_pool_t = typename internal_allocator_t::pool_type;
+
+		slab_pool_stats_t result = leaf_allocator_t::stats();
+
+		if constexpr (!std::is_same_v<mapped_pool_t, leaf_pool_t>)
+			result = result + mapped_allocator_t::stats();
+
+		if constexpr (!std::is_same_v<internal_pool_t, leaf_pool_t> && !std::is_same_v<internal_pool_t, mapped_pool_t>)
+			result = result + internal_allocator_t::stats();
+
+		return result;
 	}
 }
 
@@ -604,41 +1361,247 @@ namespace atma::_rope_
 //---------------------------------------------------------------------
 namespace atma
 {
+	template <typename RT> struct basic_rope_line_range_t;
+	template <typename RT> struct basic_rope_match_range_t;
+	template <typename RT> struct basic_rope_cursor_t;
+
+	// rope_edit_t
+	// -------------
+	//  replaces erase_characters characters at char_idx with text. the text
+	//  is only viewed, so must outlive whatever it's passed to
+	//
+	struct rope_edit_t
+	{
+		size_t char_idx = 0;
+		size_t erase_characters = 0;
+		std::string_view text;
+	};
+
+	// rope_stream_format_t
+	// ----------------------
+	//  how a rope is written to (and read from) a bytestream:
+	//
+	//   text: just the text, front to back, as it'd be in a file
+	//
+	//   tree: the tree's shape, each leaf's text-info, and the text. reading
+	//         it back rebuilds the same tree without counting any text, but
+	//         it can only be read by ropes of the same buf_size and
+	//         branching_factor. it's in native byte-order
+	//
+	enum class rope_stream_format_t
+	{
+		text,
+		tree,
+	};
+
+	// rope_stream_checks_t
+	// ----------------------
+	//  how closely a tree-format stream is checked as it's read:
+	//
+	//   structure: the tree's shape, that leaves are whole characters and
+	//              don't split a crlf, and that the recorded text-info is
+	//              plausible and sums up the tree. no text is counted
+	//
+	//   text: as structure, and every leaf's text is counted to check it
+	//         against its recorded text-info
+	//
+	enum class rope_stream_checks_t
+	{
+		structure,
+		text,
+	};
+
+	// rope_stats_t
+	// --------------
+	//  the shape of a rope's tree, as that rope sees it. leaves and internal
+	//  nodes are counted once for each time they're reached, and nodes that
+	//  are also referenced by anything else (another rope, say) are shared
+	//
+	struct rope_stats_t
+	{
+		static constexpr size_t fill_buckets = 8;
+
+		size_t height = 0;
+		size_t bytes = 0;
+
+		size_t leaf_count = 0;
+		size_t internal_count = 0;
+		size_t shared_count = 0;
+
+		// summed over every internal node
+		size_t child_count = 0;
+
+		// a full leaf (what the rope is built with) and a full internal node
+		size_t leaf_capacity = 0;
+		size_t branching_factor = 0;
+
+		// leaves by how full they are, in eighths of leaf_capacity. the last
+		// bucket also holds leaves that edits have filled past capacity
+		std::array<size_t, fill_buckets> leaf_fill_histogram{};
+
+		auto node_count() const -> size_t { return leaf_count + internal_count; }
+
+		auto leaf_fill_ratio() const -> double
+		{
+			return leaf_count ? double(bytes) / double(leaf_count * leaf_capacity) : 0.0;
+		}
+
+		auto internal_fill_ratio() const -> double
+		{
+			return internal_count ? double(child_count) / double(internal_count * branching_factor) : 0.0;
+		}
+
+		auto shared_node_ratio() const -> double
+		{
+			return node_count() ? double(shared_count) / double(node_count()) : 0.0;
+		}
+	};
+
 	template <typename RopeTraits>
 	struct basic_rope_t
 	{
 		basic_rope_t();
 		basic_rope_t(char const*, size_t);
 
+		// bulk-builds the rope, optionally across several threads. the
+		// source only needs to live for the duration of construction
+		explicit basic_rope_t(src_bounded_memxfer_t<char const>, size_t thread_count = 1);
+
+		// views the mapped text rather than copying it, so a rope of a huge
+		// file costs only its nodes, each viewing mapped_leaf_size bytes.
+		// the text is counted up front, across several threads if asked.
+		// anything edited is copied into buffers of the rope's own, and the
+		// rest stays mapped
+		explicit basic_rope_t(rope_mapped_text_ptr const&, size_t thread_count = 1);
+
 		auto push_back(char const*, size_t) -> void;
 		auto insert(size_t char_idx, char const* str, size_t sz) -> void;
 
 		auto erase(size_t char_idx, size_t size_in_chars) -> void;
 
+		// makes all the edits at once, as though simultaneously: each edit's
+		// char_idx is into the text as it was beforehand. edits mustn't overlap,
+		// and edits at the same char_idx are made in the order given. the tree
+		// is walked once, and each node that's touched is rebuilt once
+		auto apply_edits(std::span<rope_edit_t const>) -> void;
+
 		auto split(size_t char_idx) const -> std::tuple<basic_rope_t<RopeTraits>, basic_rope_t<RopeTraits>>;
 
+		// appends the other rope, sharing all of its nodes
+		auto append(basic_rope_t<RopeTraits> const&) -> void;
+
 		template <typename F>
 		auto for_all_text(F&& f) const;
 
+		// the text is split at node boundaries into tasks of many leaves, which
+		// are run on the work-provider's threads (and this one). f is invoked
+		// concurrently, but each task visits its leaves in order. returns once
+		// every task is done. work-providers are anything that can enqueue a
+		// function, like atma::thread_pool_t or any thread_work_provider_t
+		template <typename WorkProvider, typename F>
+		auto parallel_for_all_text(WorkProvider&, F&& f) const -> void;
+
+		// each task folds reduce(acc, map(std::string_view)) over its leaves,
+		// starting from identity, and the tasks' results are then folded in
+		// order. reduce must be associative, and identity its identity
+		template <typename WorkProvider, typename T, typename Map, typename Reduce>
+		auto parallel_reduce(WorkProvider&, T identity, Map&& map, Reduce&& reduce) const -> T;
+
 		decltype(auto) root() const { return (root_); }
 
 		// size in characters
 		auto size() const -> size_t { return root_.info().characters; }
-		auto size_bytes() const -> size_t { return root_.info().bytes - root_.info().dropped_bytes; }
+		auto size_bytes() const -> size_t { return root_.info().bytes; }
+
+		// lines are delimited by line-breaks, with a CRLF pair counting as
+		// one line-break. there is always one more line than line-breaks
+		auto line_count() const -> size_t { return root_.info().line_breaks + 1; }
+
+		auto char_idx_of_line(size_t line_idx) const -> size_t;
+		auto line_of_char_idx(size_t char_idx) const -> size_t;
+
+		// iterates the lines [first_line, last_line)
+		auto lines(size_t first_line, size_t last_line) const -> basic_rope_line_range_t<RopeTraits>;
+
+		static constexpr size_t npos = ~size_t();
+
+		// returns the char-idx of the first occurrence of str starting at or
+		// after char_idx, or npos. occurrences may span any number of leaves
+		auto find(std::string_view str, size_t char_idx = 0) const -> size_t;
+
+		// returns the char-idx of the last occurrence of str starting at or
+		// before char_idx, or npos
+		auto rfind(std::string_view str, size_t char_idx = npos) const -> size_t;
+
+		// iterates every non-overlapping occurrence of str, front to back. str
+		// must outlive the range. an empty str has no occurrences
+		auto find_all(std::string_view str) const -> basic_rope_match_range_t<RopeTraits>;
+
+		// a bidirectional cursor positioned at char_idx
+		auto cursor(size_t char_idx = 0) const -> basic_rope_cursor_t<RopeTraits>;
+
+		// a hash of the text, independent of how the rope is structured. it's
+		// cached in the rope's nodes, so ropes that share nodes share the work.
+		// once both ropes are hashed, comparing them is constant-time
+		auto hash() const -> uint64_t;
+
+		using summary_type = typename RopeTraits::summary_type;
+
+		// the traits' summary of all the text, or of the text before char_idx.
+		// like hashes, summaries are cached in the rope's nodes
+		auto summary() const -> summary_type;
+		auto summary_before(size_t char_idx) const -> summary_type;
+
+		// the char-idx of the character that value falls within, where metric
+		// maps the summary of the text before a character to something that
+		// never decreases along the text. past the end is size(). for example,
+		// utf-16 offsets are char_idx_of_metric(&rope_utf16_summary_t::code_units, offset)
+		template <typename Metric>
+		auto char_idx_of_metric(Metric&&, size_t value) const -> size_t;
+
+		// the shape of the tree, for spotting fragmentation
+		auto stats() const -> rope_stats_t;
+
+		// re-packs runs of under-filled leaves into as few leaves as possible,
+		// starting at the leaf containing char_idx, until about byte_budget bytes
+		// of text have been looked at, then merges the under-filled internal
+		// nodes above that text. returns the char-idx to carry on from,
+		// which is size() once the end is reached, so that a rope can be tidied
+		// a little at a time whenever there's idle time
+		auto rebalance(size_t byte_budget, size_t char_idx = 0) -> size_t;
+
+		// writes each leaf's text straight to the stream. on error, stops at
+		// the first write that fails
+		auto write_to(output_bytestream_t&, rope_stream_format_t = rope_stream_format_t::text) const -> write_result_t;
+
+		// replaces our text with what's read from the stream until it's
+		// exhausted. text is read in fixed-size chunks, and leaves are built
+		// from each chunk as it arrives. if reading fails, or the tree is
+		// malformed, we're left as we were and the status is error. a tree is
+		// checked as closely as checks asks (see rope_stream_checks_t)
+		auto read_from(input_bytestream_t&, rope_stream_format_t = rope_stream_format_t::text, rope_stream_checks_t = rope_stream_checks_t::structure) -> read_result_t;
 
-		
 
 
 	private:
-		basic_rope_t(_rope_::tree_t<RopeTraits> const&);
+		basic_rope_t(_rope_::tree_t<RopeTraits> const&, bool has_mapped_leaves);
 
 	private:
 		_rope_::tree_t<RopeTraits> root_;
 
+		// set once any of our leaves view mapped text, and only then do we
+		// isolate (see isolate_for_edit_) the leaves an edit touches. it's
+		// never cleared, as edits only ever copy mapped text out
+		bool has_mapped_leaves_ = false;
+
 		friend struct _rope_::build_rope_t_<RopeTraits>;
 	};
 
 
+	// concatenation
+	template <typename RT>
+	auto operator + (basic_rope_t<RT> const&, basic_rope_t<RT> const&) -> basic_rope_t<RT>;
+
 	// comparison operators
 	template <typename RT>
 	auto operator == (basic_rope_t<RT> const&, basic_rope_t<RT> const&) -> bool;
@@ -651,6 +1614,26 @@ namespace atma
 	auto operator == (basic_rope_t<RT> const&, Range const& rhs) -> bool;
 }
 
+namespace atma
+{
+	// a range of characters of one rope that was replaced by a range of
+	// characters of another. either range may be empty
+	struct rope_change_t
+	{
+		size_t lhs_char_idx = 0;
+		size_t lhs_characters = 0;
+		size_t rhs_char_idx = 0;
+		size_t rhs_characters = 0;
+	};
+
+	// the changes that turn lhs into rhs, front to back. subtrees the ropes
+	// share are skipped, as are any equal subtrees that both ropes have
+	// already hashed, so diffing a rope against an edited copy of itself
+	// costs in proportion to the edits
+	template <typename RT>
+	auto diff(basic_rope_t<RT> const& lhs, basic_rope_t<RT> const& rhs) -> std::vector<rope_change_t>;
+}
+
 
 namespace atma
 {
@@ -665,11 +1648,100 @@ namespace atma
 	private:
 		basic_rope_t<RT> const& rope_;
 		_rope_::node_leaf_ptr<RT> leaf_;
+		char const* leaf_data_ = nullptr;
 		size_t leaf_characters_ = 0;
 		size_t idx_ = 0;
 		size_t rel_idx_ = 0;
+		size_t rel_byte_idx_ = 0;
+	};
+
+}
+
+namespace atma
+{
+	// a line of the rope, as addressed by characters. the range
+	// [char_idx, char_idx + characters) includes the line-break
+	// that terminates the line, if there is one
+	struct rope_line_t
+	{
+		size_t line_idx = 0;
+		size_t char_idx = 0;
+		size_t characters = 0;
+	};
+
+	template <typename RT>
+	struct basic_rope_line_iterator_t
+	{
+		using value_type = rope_line_t;
+		using difference_type = ptrdiff_t;
+
+		basic_rope_line_iterator_t() = default;
+		basic_rope_line_iterator_t(basic_rope_t<RT> const& rope, size_t line_idx);
+
+		auto operator ++() -> basic_rope_line_iterator_t&;
+		auto operator  *() const -> rope_line_t const&;
+		auto operator ->() const -> rope_line_t const*;
+
+	private:
+		auto calculate_line_end_() -> void;
+
+	private:
+		basic_rope_t<RT> const* rope_ = nullptr;
+		rope_line_t line_;
+
+		template <typename RT2>
+		friend auto operator == (basic_rope_line_iterator_t<RT2> const& lhs, basic_rope_line_iterator_t<RT2> const& rhs) -> bool;
+	};
+
+	template <typename RT>
+	struct basic_rope_line_range_t
+	{
+		auto begin() const -> basic_rope_line_iterator_t<RT> { return begin_; }
+		auto end() const -> basic_rope_line_iterator_t<RT> { return end_; }
+
+		basic_rope_line_iterator_t<RT> begin_, end_;
+	};
+}
+
+namespace atma
+{
+	// an occurrence of a searched-for string, as addressed by characters
+	struct rope_match_t
+	{
+		size_t char_idx = 0;
+		size_t characters = 0;
+	};
+
+	template <typename RT>
+	struct basic_rope_match_iterator_t
+	{
+		using value_type = rope_match_t;
+		using difference_type = ptrdiff_t;
+
+		basic_rope_match_iterator_t() = default;
+		basic_rope_match_iterator_t(basic_rope_t<RT> const& rope, std::string_view str);
+
+		auto operator ++() -> basic_rope_match_iterator_t&;
+		auto operator  *() const -> rope_match_t const&;
+		auto operator ->() const -> rope_match_t const*;
+
+	private:
+		basic_rope_t<RT> const* rope_ = nullptr;
+		std::string_view str_;
+		rope_match_t match_{basic_rope_t<RT>::npos};
+
+		template <typename RT2>
+		friend auto operator == (basic_rope_match_iterator_t<RT2> const& lhs, basic_rope_match_iterator_t<RT2> const& rhs) -> bool;
 	};
 
+	template <typename RT>
+	struct basic_rope_match_range_t
+	{
+		auto begin() const -> basic_rope_match_iterator_t<RT> { return begin_; }
+		auto end() const -> basic_rope_match_iterator_t<RT> { return end_; }
+
+		basic_rope_match_iterator_t<RT> begin_, end_;
+	};
 }
 
 namespace atma::_rope_
@@ -692,38 +1764,178 @@ namespace atma::_rope_
 	};
 }
 
+namespace atma::_rope_
+{
+	// leaf_cursor_t
+	// ---------------
+	//  addresses one leaf of a tree, and can step to either neighbouring
+	//  leaf. it remembers the path taken from the root, so stepping only
+	//  climbs as far as the nearest common ancestor. the tree must outlive
+	//  the cursor, and not be edited in the meantime
+	//
+	template <typename RT>
+	struct leaf_cursor_t
+	{
+		// positions the cursor on the leaf containing char_idx. the one-past-
+		// the-end index is considered to be contained by the last leaf
+		leaf_cursor_t(tree_t<RT> const& root, size_t char_idx);
 
+		auto leaf() const -> tree_leaf_t<RT> const&;
+		auto data() const -> src_buf_t;
 
+		// the char-idx of the front of this leaf
+		auto char_idx() const -> size_t { return char_idx_; }
 
+		// steps to the neighbouring leaf. at either end of the tree, the
+		// cursor is left where it was and false is returned
+		auto next() -> bool;
+		auto prev() -> bool;
 
+	private:
+		auto descend_front_(tree_t<RT> const*) -> void;
+		auto descend_back_(tree_t<RT> const*) -> void;
 
+	private:
+		// trees of up to 4G characters are well within this height
+		static constexpr size_t max_height = 64;
 
+		struct step_t
+		{
+			tree_branch_t<RT> const* branch = nullptr;
+			size_t child_idx = 0;
+		};
 
+		std::array<step_t, max_height> path_;
+		size_t path_size_ = 0;
 
+		tree_t<RT> const* leaf_ = nullptr;
+		size_t char_idx_ = 0;
+	};
+}
 
+namespace atma
+{
+	// basic_rope_cursor_t
+	// ---------------------
+	//  a position within a rope that can be moved a character or a whole
+	//  leaf at a time in either direction. the path from the root to the
+	//  current leaf is kept, so stepping is amortized O(1) and seeking is
+	//  O(log n). the current leaf is exposed as a contiguous span for any
+	//  consumer that wants the text without copying it
+	//
+	//  the rope must outlive the cursor, and not be edited in the meantime
+	//
+	template <typename RT>
+	struct basic_rope_cursor_t
+	{
+		explicit basic_rope_cursor_t(basic_rope_t<RT> const& rope, size_t char_idx = 0);
 
+		// the char-idx of the character under the cursor. the one-past-the-
+		// end position is valid, but has no character under it
+		auto char_idx() const -> size_t { return leaf_cursor_.char_idx() + rel_idx_; }
+		auto at_end() const -> bool { return char_idx() == rope_->size(); }
 
+		auto operator *() const -> utf8_char_t;
 
+		// the text of the leaf under the cursor, and the char-idx of its front
+		auto leaf_span() const -> std::span<char const>;
+		auto leaf_char_idx() const -> size_t { return leaf_cursor_.char_idx(); }
 
+		// the byte-offset of the cursor within leaf_span()
+		auto leaf_byte_idx() const -> size_t { return rel_byte_idx_; }
 
+		// steps one character. stepping past either end of the rope
+		// leaves the cursor where it was and returns false
+		auto next_char() -> bool;
+		auto prev_char() -> bool;
 
+		// moves to the front of the neighbouring leaf. next_leaf from the
+		// last leaf moves to the one-past-the-end position
+		auto next_leaf() -> bool;
+		auto prev_leaf() -> bool;
 
+		auto seek(size_t char_idx) -> void;
 
+	private:
+		auto leaf_characters_() const -> size_t { return leaf_cursor_.leaf().info().characters; }
 
+	private:
+		basic_rope_t<RT> const* rope_ = nullptr;
+		_rope_::leaf_cursor_t<RT> leaf_cursor_;
+		size_t rel_idx_ = 0;
+		size_t rel_byte_idx_ = 0;
+	};
+}
 
+namespace atma::_rope_
+{
+	// node_memory_size_ :: the bytes allocated for a node
+	template <typename RT>
+	auto node_memory_size_(node_t<RT> const&) -> size_t;
 
+	// uniquely_owned_bytes_ :: the bytes that would be freed if tree were
+	// released. only nodes referenced from nowhere else are descended into
+	template <typename RT>
+	auto uniquely_owned_bytes_(tree_t<RT> const&) -> size_t;
 
+	// distinct_bytes_ :: the bytes of every node reachable from tree that
+	// hasn't already been visited
+	template <typename RT>
+	auto distinct_bytes_(tree_t<RT> const&, std::unordered_set<node_t<RT> const*>& visited) -> size_t;
+}
 
+namespace atma
+{
+	// basic_rope_history_t
+	// ----------------------
+	//  a sequence of versions of a rope, with one being current. a snapshot
+	//  is a copy of a rope, which only shares its nodes, so thousands of
+	//  versions cost little more than the edits between them
+	//
+	//  memory is accounted by node reference-counts. a version's unique
+	//  bytes are those of the nodes that nothing else references, which is
+	//  exactly what discarding that version would free
+	//
+	template <typename RT>
+	struct basic_rope_history_t
+	{
+		explicit basic_rope_history_t(basic_rope_t<RT> const& initial = basic_rope_t<RT>{});
 
+		// records rope as the newest version, which becomes current. any
+		// versions that could have been redone are discarded
+		auto snapshot(basic_rope_t<RT> const& rope) -> void;
 
+		auto current() const -> basic_rope_t<RT> const& { return versions_[current_]; }
+		auto current_version() const -> size_t { return current_; }
 
+		auto version_count() const -> size_t { return versions_.size(); }
+		auto version(size_t idx) const -> basic_rope_t<RT> const&;
 
+		auto can_undo() const -> bool { return current_ != 0; }
+		auto can_redo() const -> bool { return current_ + 1 != versions_.size(); }
 
+		// moves to the previous or next version, returning false if there isn't one
+		auto undo() -> bool;
+		auto redo() -> bool;
 
+		// the bytes of nodes that only version idx references
+		auto unique_bytes(size_t idx) const -> size_t;
 
+		// the bytes of every node referenced by any version, counted once
+		auto memory_usage() const -> size_t;
 
+		// coalesces the oldest undo-steps into one until memory_usage is within
+		// memory_budget. the first version, the current version, and anything
+		// that can be redone are always kept. returns the resulting memory_usage
+		auto compact(size_t memory_budget) -> size_t;
 
+	private:
+		std::vector<basic_rope_t<RT>> versions_;
+		size_t current_ = 0;
+	};
 
+	using rope_history_t = basic_rope_history_t<rope_default_traits>;
+}
 
 
 
@@ -738,25 +1950,58 @@ namespace atma::_rope_
 
 
 
-//---------------------------------------------------------------------
-//
-// text algorithms
-// (they aren't templated)
-// 
-//---------------------------------------------------------------------
-namespace atma::_rope_
-{
-	enum class split_bias
-	{
-		// always pick left
-		hard_left,
-		// prefer left
-		left,
-		// prefer right
-		right,
-		// always pick right
-		hard_right,
-	};
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+//---------------------------------------------------------------------
+//
+// text algorithms
+// (they aren't templated)
+// 
+//---------------------------------------------------------------------
+namespace atma::_rope_
+{
+	enum class split_bias
+	{
+		// always pick left
+		hard_left,
+		// prefer left
+		left,
+		// prefer right
+		right,
+		// always pick right
+		hard_right,
+	};
 
 	auto is_seam(char, char) -> bool;
 	auto is_break(src_buf_t buf, size_t byte_idx) -> bool;
@@ -849,6 +2094,32 @@ namespace atma::_rope_
 	// for_all_text :: visits each leaf in sequence and invokes f(std::string_view)
 	template <typename F, typename RT>
 	auto for_all_text(F f, tree_t<RT> const& ri) -> void;
+
+	// partition_for_tasks_ :: splits the tree at node boundaries into subtrees of at
+	//    most task_bytes (or single leaves), front to back
+	template <typename RT>
+	auto partition_for_tasks_(tree_t<RT> const&, size_t task_bytes, std::vector<tree_t<RT>>& tasks) -> void;
+
+	// run_tasks_ :: invokes task(idx) for every idx in [0, task_count), on the
+	//    work-provider's threads and this one, returning once they're all done.
+	//    if a task throws, the tasks not yet started are skipped, and the
+	//    (first) exception is rethrown here
+	template <typename WorkProvider>
+	auto run_tasks_(WorkProvider&, size_t task_count, std::function<void(size_t)> task) -> void;
+
+	// find_for_line_idx :: returns <index-of-child-node, remaining-lines, preceding-characters>
+	//    the child returned is the one containing the line-break that
+	//    terminates the line before line_idx. line_idx must be non-zero
+	template <typename RT>
+	auto find_for_line_idx(node_internal_t<RT> const&, size_t line_idx) -> std::tuple<size_t, size_t, size_t>;
+
+	// char_idx_of_line :: returns the character index at which the line begins
+	template <typename RT>
+	auto char_idx_of_line(tree_t<RT> const&, size_t line_idx) -> size_t;
+
+	// line_of_char_idx :: returns the line on which the character resides
+	template <typename RT>
+	auto line_of_char_idx(tree_t<RT> const&, size_t char_idx) -> size_t;
 }
 
 
@@ -995,6 +2266,11 @@ namespace atma::_rope_
 	template <typename RT>
 	auto mend_right_seam_(seam_t, tree_t<RT> const& seam_node, tree_t<RT> const& sibling_node)
 		-> mend_result_type<RT>;
+
+	// tree_join_ :: concatenates two trees, mending any cr/lf seam between them
+	template <typename RT>
+	auto tree_join_(tree_t<RT> const& left, tree_t<RT> const& right)
+		-> tree_t<RT>;
 }
 
 namespace atma::_rope_
@@ -1009,19 +2285,169 @@ namespace atma::_rope_
 namespace atma::_rope_
 {
 	// erase
+
+	template <typename RT>
+	auto erase(tree_t<RT> const&, size_t char_idx, size_t size_in_chars)
+		-> edit_result_t<RT>;
+
+	template <typename RT>
+	auto erase_small_text_(tree_leaf_t<RT> const&, size_t char_idx, size_t size_in_chars)
+		-> edit_result_t<RT>;
+
+	template <typename RT>
+	auto erase_across_leaves_(tree_t<RT> const&, size_t char_idx, size_t size_in_chars)
+		-> tree_t<RT>;
+}
+
+namespace atma::_rope_
+{
+	// search
+	//
+	//  within a leaf, candidates are found by testing the first & last byte of
+	//  the needle against a stride of positions at once, and only then compared
+	//  in full. candidates near the back of a leaf that would run off its end
+	//  are compared across however many following leaves they need. needles
+	//  are expected to be well-formed utf8, so every match begins on a char
+
+	constexpr size_t search_npos = ~size_t();
+
+	// find_in_chunk_ :: the first byte-idx >= from where needle lies wholly within str
+	auto find_in_chunk_(src_buf_t str, size_t from, std::string_view needle) -> size_t;
+
+	// rfind_in_chunk_ :: the last byte-idx <= last where needle lies wholly within str
+	auto rfind_in_chunk_(src_buf_t str, size_t last, std::string_view needle) -> size_t;
+
+	// matches_across_leaves_ :: does needle begin at byte_idx of the cursor's leaf
+	template <typename RT>
+	auto matches_across_leaves_(leaf_cursor_t<RT> cursor, size_t byte_idx, std::string_view needle)
+		-> bool;
+
+	template <typename RT>
+	auto find(tree_t<RT> const&, std::string_view needle, size_t char_idx)
+		-> size_t;
+
+	template <typename RT>
+	auto rfind(tree_t<RT> const&, std::string_view needle, size_t char_idx)
+		-> size_t;
+}
+
+namespace atma::_rope_
+{
+	// hashing
+	//
+	//  text is hashed as a polynomial in its bytes, modulo the mersenne prime
+	//  2^61-1. the hash of two adjacent texts follows from their hashes and
+	//  the length of the right-hand text alone, so a tree's hash depends only
+	//  on its text and never on its shape. hashes are cached in the nodes, so
+	//  a tree that shares most of its nodes with an already-hashed tree costs
+	//  only its unshared nodes to hash
+
+	constexpr uint64_t hash_modulus = (uint64_t(1) << 61) - 1;
+	constexpr uint64_t hash_base = 0x1ec3a5b7d291f04d % hash_modulus;
+
+	auto hash_mul_(uint64_t lhs, uint64_t rhs) -> uint64_t;
+	auto hash_pow_(size_t exponent) -> uint64_t;
+	auto hash_text_(char const* str, size_t size) -> uint64_t;
+
+	// hash_concat_ :: the hash of two texts, one after the other
+	auto hash_concat_(uint64_t lhs, uint64_t rhs, size_t rhs_bytes) -> uint64_t;
+
+	// tree_hash_ :: computes (and caches) the hash of every node it needs to
+	template <typename RT>
+	auto tree_hash_(tree_t<RT> const&) -> uint64_t;
+
+	// tree_cached_hash_ :: only what has already been computed
+	template <typename RT>
+	auto tree_cached_hash_(tree_t<RT> const&) -> std::optional<uint64_t>;
+
+	// subtrees_known_equal_ :: the same view of the same node, or equal hashes
+	// that have already been computed. false says nothing at all
+	template <typename RT>
+	auto subtrees_known_equal_(tree_t<RT> const&, tree_t<RT> const&) -> bool;
+}
+
+namespace atma::_rope_
+{
+	// tree_summary_ :: computes (and caches) the summary of every node it needs to
+	template <typename RT>
+	auto tree_summary_(tree_t<RT> const&) -> typename RT::summary_type;
+
+	// tree_summary_before_ :: the summary of the text before char_idx
+	template <typename RT>
+	auto tree_summary_before_(tree_t<RT> const&, size_t char_idx) -> typename RT::summary_type;
+
+	// tree_find_for_metric_ :: find_for_char_idx, for any metric of the summaries.
+	//    returns <index-of-child-node, characters-before-it>, having added the
+	//    summaries of the children before it to summary. the index is the number
+	//    of children if value is past all of them
+	template <typename RT, typename Metric>
+	auto tree_find_for_metric_(tree_t<RT> const&, Metric&&, size_t value, typename RT::summary_type& summary) -> std::tuple<size_t, size_t>;
+
+	// tree_char_idx_of_metric_ :: the char-idx of the character that value falls
+	// within, when metric is applied to the summaries of the text before each one
+	template <typename RT, typename Metric>
+	auto tree_char_idx_of_metric_(tree_t<RT> const&, Metric&&, size_t value) -> size_t;
+}
+
+namespace atma::_rope_
+{
+	// diff
+	//
+	//  the common prefix & suffix of two trees are trimmed by walking both
+	//  from the same end, skipping any subtrees known to be equal and only
+	//  comparing text where they aren't. whatever's left in the middle is
+	//  searched for a shared subtree, which splits it into two smaller diffs.
+	//  for trees that share most of their nodes, the work done is in
+	//  proportion to the edits between them, not the size of the trees
+
+	// a whole subtree, or a byte-range of a leaf
 	template <typename RT>
-	struct erase_result_t
+	struct diff_span_t
 	{
-		maybe_tree_t<RT> lhs, rhs;
+		tree_t<RT> const* tree = nullptr;
+		size_t char_idx = 0;
+		size_t begin_byte = 0;
+		size_t end_byte = 0;
+
+		auto is_whole() const -> bool { return begin_byte == 0 && end_byte == tree->size_bytes(); }
+		auto characters() const -> size_t { return tree->size_chars(); }
 	};
 
 	template <typename RT>
-	auto erase(tree_t<RT> const&, size_t char_idx, size_t size_in_chars)
-		-> erase_result_t<RT>;
+	using diff_spans_t = std::vector<diff_span_t<RT>>;
+
+	// collect_diff_spans_ :: the fewest spans exactly covering [begin, end) of tree
+	template <typename RT>
+	auto collect_diff_spans_(diff_spans_t<RT>&, tree_t<RT> const&, size_t char_idx, size_t begin, size_t end)
+		-> void;
+
+	// diff_common_affix_ :: the characters in common at the front (or back) of two span-sequences
+	template <bool FromBack, typename RT>
+	auto diff_common_affix_(diff_spans_t<RT> lhs, diff_spans_t<RT> rhs)
+		-> size_t;
+
+	// trees_equal_ :: whether two trees of the same size hold the same text
+	template <typename RT>
+	auto trees_equal_(tree_t<RT> const& lhs, tree_t<RT> const& rhs)
+		-> bool;
+
+	struct diff_anchor_t
+	{
+		size_t lhs_char_idx = 0;
+		size_t rhs_char_idx = 0;
+		size_t characters = 0;
+	};
+
+	// find_diff_anchor_ :: the largest subtree known to be in both span-sequences
+	template <typename RT>
+	auto find_diff_anchor_(diff_spans_t<RT> lhs, diff_spans_t<RT> rhs)
+		-> std::optional<diff_anchor_t>;
 
 	template <typename RT>
-	auto erase_(tree_t<RT> const&, size_t rel_char_idx, size_t rel_size_in_chars)
-		-> erase_result_t<RT>;
+	auto diff_ranges_(std::vector<rope_change_t>&,
+		tree_t<RT> const& lhs, size_t lhs_begin, size_t lhs_end,
+		tree_t<RT> const& rhs, size_t rhs_begin, size_t rhs_end)
+		-> void;
 }
 
 namespace atma::_rope_
@@ -1072,6 +2498,33 @@ namespace atma::_rope_
 		-> maybe_tree_t<RT>;
 }
 
+namespace atma::_rope_
+{
+	// in-place editing
+	//
+	//  a node that is reachable through only one tree (every node on its path
+	//  has a use-count of one) can't be observed by anyone else, so we may
+	//  edit it in place rather than copying the path. the leaf-payloads are
+	//  passed the mutable leaf, its current info, and the relative char-idx,
+	//  and return the leaf's new info, or nothing if they can't edit in place.
+	//  when they return nothing, they must not have modified anything
+
+	template <typename RT>
+	auto is_uniquely_owned_(tree_t<RT> const&) -> bool;
+
+	template <typename RT, typename FindFn, typename PayloadFn>
+	auto edit_in_place_(tree_t<RT>&, size_t char_idx, FindFn&&, PayloadFn&&)
+		-> bool;
+
+	template <typename RT>
+	auto insert_in_place_(tree_t<RT>&, size_t char_idx, src_buf_t insbuf)
+		-> bool;
+
+	template <typename RT>
+	auto erase_in_place_(tree_t<RT>&, size_t char_idx, size_t size_in_chars)
+		-> bool;
+}
+
 
 
 
@@ -1157,6 +2610,204 @@ namespace atma::_rope_
 
 
 
+
+
+
+//---------------------------------------------------------------------
+//
+//  leaf text-metric kernels
+//  --------------------------
+//  a leaf's text_info_t is recomputed on every insert, split, and
+//  seam-repair, so we count in 16/32-byte strides where the cpu lets
+//  us. every kernel counts the same things, assuming well-formed utf8:
+//
+//   - characters are the non-continuation bytes (not 0b10xxxxxx)
+//   - line-breaks are the bytes 0x0a-0x0d, less any lf following a cr
+//
+//  the fastest kernel available is chosen the first time it's needed
+//
+//---------------------------------------------------------------------
+namespace atma::_rope_
+{
+	using leaf_text_info_kernel_t = leaf_text_info_t(*)(char const*, size_t);
+
+	auto leaf_text_info_scalar(char const* str, size_t sz) -> leaf_text_info_t;
+
+#if ATMA_ROPE_SIMD_X64
+	auto leaf_text_info_sse42(char const* str, size_t sz) -> leaf_text_info_t;
+	auto leaf_text_info_avx2(char const* str, size_t sz) -> leaf_text_info_t;
+#endif
+
+	auto cpu_has_sse42() -> bool;
+	auto cpu_has_avx2() -> bool;
+
+	auto leaf_text_info_kernel() -> leaf_text_info_kernel_t;
+}
+
+namespace atma::_rope_
+{
+	// counts [begin, end) of str into r, one byte at a time
+	inline auto leaf_text_info_count_bytes_(leaf_text_info_t& r, char const* str, size_t begin, size_t end) -> void
+	{
+		char prev = (begin == 0) ? charcodes::null : str[begin - 1];
+
+		for (size_t i = begin; i != end; ++i)
+		{
+			auto const x = (uint8_t)str[i];
+
+			r.characters += (x & 0xc0) != 0x80;
+			r.line_breaks += (uint8_t)(x - 0x0a) < 4 && !(prev == charcodes::cr && str[i] == charcodes::lf);
+
+			prev = str[i];
+		}
+	}
+
+	// counts the characters of text of any length
+	inline auto leaf_text_info_count_chars_(std::string_view str) -> size_t
+	{
+		return std::count_if(str.begin(), str.end(), [](char x) { return ((uint8_t)x & 0xc0) != 0x80; });
+	}
+
+	inline auto leaf_text_info_scalar(char const* str, size_t sz) -> leaf_text_info_t
+	{
+		leaf_text_info_t r;
+		r.bytes = (uint16_t)sz;
+		leaf_text_info_count_bytes_(r, str, 0, sz);
+		return r;
+	}
+
+#if ATMA_ROPE_SIMD_X64
+	// strides start at the second byte so that every stride can load
+	// its preceding bytes unaligned, to find lfs that follow a cr
+	ATMA_ROPE_SIMD_TARGET("sse4.2,popcnt")
+	inline auto leaf_text_info_sse42(char const* str, size_t sz) -> leaf_text_info_t
+	{
+		leaf_text_info_t r;
+		r.bytes = (uint16_t)sz;
+
+		size_t i = std::min<size_t>(sz, 1);
+		leaf_text_info_count_bytes_(r, str, 0, i);
+
+		__m128i const continuation_max = _mm_set1_epi8((char)0xbf);
+		__m128i const newline_min = _mm_set1_epi8(0x0a);
+		__m128i const newline_range = _mm_set1_epi8(0x03);
+		__m128i const cr = _mm_set1_epi8(charcodes::cr);
+		__m128i const lf = _mm_set1_epi8(charcodes::lf);
+
+		for ( ; i + 16 <= sz; i += 16)
+		{
+			__m128i const x = _mm_loadu_si128(reinterpret_cast<__m128i const*>(str + i));
+			__m128i const prev = _mm_loadu_si128(reinterpret_cast<__m128i const*>(str + i - 1));
+
+			// signed compare: only continuation bytes are <= 0xbf
+			auto const characters = (uint32_t)_mm_movemask_epi8(_mm_cmpgt_epi8(x, continuation_max));
+
+			__m128i const newline_offset = _mm_sub_epi8(x, newline_min);
+			auto const newlines = (uint32_t)_mm_movemask_epi8(
+				_mm_cmpeq_epi8(_mm_min_epu8(newline_offset, newline_range), newline_offset));
+
+			auto const followon_lfs = (uint32_t)_mm_movemask_epi8(
+				_mm_and_si128(_mm_cmpeq_epi8(x, lf), _mm_cmpeq_epi8(prev, cr)));
+
+			r.characters += (uint16_t)_mm_popcnt_u32(characters);
+			r.line_breaks += (uint16_t)_mm_popcnt_u32(newlines & ~followon_lfs);
+		}
+
+		leaf_text_info_count_bytes_(r, str, i, sz);
+		return r;
+	}
+
+	ATMA_ROPE_SIMD_TARGET("avx2,popcnt")
+	inline auto leaf_text_info_avx2(char const* str, size_t sz) -> leaf_text_info_t
+	{
+		leaf_text_info_t r;
+		r.bytes = (uint16_t)sz;
+
+		size_t i = std::min<size_t>(sz, 1);
+		leaf_text_info_count_bytes_(r, str, 0, i);
+
+		__m256i const continuation_max = _mm256_set1_epi8((char)0xbf);
+		__m256i const newline_min = _mm256_set1_epi8(0x0a);
+		__m256i const newline_range = _mm256_set1_epi8(0x03);
+		__m256i const cr = _mm256_set1_epi8(charcodes::cr);
+		__m256i const lf = _mm256_set1_epi8(charcodes::lf);
+
+		for ( ; i + 32 <= sz; i += 32)
+		{
+			__m256i const x = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(str + i));
+			__m256i const prev = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(str + i - 1));
+
+			auto const characters = (uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(x, continuation_max));
+
+			__m256i const newline_offset = _mm256_sub_epi8(x, newline_min);
+			auto const newlines = (uint32_t)_mm256_movemask_epi8(
+				_mm256_cmpeq_epi8(_mm256_min_epu8(newline_offset, newline_range), newline_offset));
+
+			auto const followon_lfs = (uint32_t)_mm256_movemask_epi8(
+				_mm256_and_si256(_mm256_cmpeq_epi8(x, lf), _mm256_cmpeq_epi8(prev, cr)));
+
+			r.characters += (uint16_t)_mm_popcnt_u32(characters);
+			r.line_breaks += (uint16_t)_mm_popcnt_u32(newlines & ~followon_lfs);
+		}
+
+		leaf_text_info_count_bytes_(r, str, i, sz);
+		return r;
+	}
+#endif
+
+	inline auto cpu_has_sse42() -> bool
+	{
+#if !ATMA_ROPE_SIMD_X64
+		return false;
+#elif defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		bool const sse42 = info[2] & (1 << 20);
+		bool const popcnt = info[2] & (1 << 23);
+		return sse42 && popcnt;
+#else
+		return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+#endif
+	}
+
+	inline auto cpu_has_avx2() -> bool
+	{
+#if !ATMA_ROPE_SIMD_X64
+		return false;
+#elif defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		bool const popcnt = info[2] & (1 << 23);
+		bool const osxsave = info[2] & (1 << 27);
+		bool const avx = info[2] & (1 << 28);
+
+		// the os must also be saving the upper halves of the ymm registers
+		if (!(popcnt && osxsave && avx) || (_xgetbv(0) & 0x6) != 0x6)
+			return false;
+
+		__cpuidex(info, 7, 0);
+		return info[1] & (1 << 5);
+#else
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+#endif
+	}
+
+	inline auto leaf_text_info_kernel() -> leaf_text_info_kernel_t
+	{
+		static leaf_text_info_kernel_t const kernel = []() -> leaf_text_info_kernel_t
+		{
+#if ATMA_ROPE_SIMD_X64
+			if (cpu_has_avx2())
+				return &leaf_text_info_avx2;
+			else if (cpu_has_sse42())
+				return &leaf_text_info_sse42;
+#endif
+			return &leaf_text_info_scalar;
+		}();
+
+		return kernel;
+	}
+}
 
 
 
@@ -1167,26 +2818,27 @@ namespace atma::_rope_
 //---------------------------------------------------------------------
 namespace atma::_rope_
 {
-	inline text_info_t text_info_t::from_str(char const* str, size_t sz)
+	inline leaf_text_info_t leaf_text_info_t::from_str(char const* str, size_t sz)
 	{
 		ATMA_ASSERT(str);
+		ATMA_ASSERT(sz <= std::numeric_limits<uint16_t>::max(), "leaf_text_info_t only addresses the text of one leaf");
+
+		return leaf_text_info_kernel()(str, sz);
+	}
+
+	inline text_info_t text_info_t::from_str(char const* str, size_t sz)
+	{
+		// scanned in runs that leaf_text_info_t can address. a run can't see
+		// the cr before it, so an lf following one is a line-break too many
+		constexpr size_t run_size = 0x8000;
 
 		text_info_t r;
-		
-		utf8_char_t prev_char;
-		for (auto x : utf8_const_range_t{str, str + sz})
+		for (size_t i = 0; i < sz; i += run_size)
 		{
-			r.bytes += (uint16_t)x.size_bytes();
-			++r.characters;
+			r = r + leaf_text_info_t::from_str(str + i, std::min(run_size, sz - i));
 
-			// only count distinct newlines, so '\r\n' counts as only one
-			bool const is_followon_lf = (x == '\n') && (prev_char == '\r');
-			if (utf8_char_is_newline(x) && !is_followon_lf)
-			{
-				++r.line_breaks;
-			}
-			
-			prev_char = x;
+			if (i != 0 && str[i - 1] == charcodes::cr && str[i] == charcodes::lf)
+				--r.line_breaks;
 		}
 
 		return r;
@@ -1254,13 +2906,13 @@ namespace atma::_rope_
 	template <typename RT>
 	inline auto tree_t<RT>::size_chars() const -> size_t
 	{
-		return this->info().characters - this->info().dropped_characters;
+		return this->info().characters;
 	}
 	
 	template <typename RT>
 	inline auto tree_t<RT>::size_bytes() const -> size_t
 	{
-		return this->info().bytes - this->info().dropped_bytes;
+		return this->info().bytes;
 	}
 
 	template <typename RT>
@@ -1269,6 +2921,12 @@ namespace atma::_rope_
 		return this->child_count_ >= RT::branching_factor / 2;
 	}
 
+	template <typename RT>
+	inline auto tree_t<RT>::has_space_for_another_child() const -> bool
+	{
+		return this->child_count_ < RT::branching_factor;
+	}
+
 	// children as viewed by info
 	template <typename RT>
 	inline auto tree_t<RT>::children() const
@@ -1369,13 +3027,13 @@ namespace atma::_rope_
 	template <typename RT>
 	inline auto tree_leaf_t<RT>::data() const -> src_buf_t
 	{
-		return xfer_src(this->node().buf.data() + this->info().dropped_bytes, this->info().bytes);
+		return xfer_src(this->node().text().data() + this->info().dropped_bytes, this->info().bytes);
 	}
 
 	template <typename RT>
 	inline auto tree_leaf_t<RT>::byte_idx_from_char_idx(size_t char_idx) const -> size_t
 	{
-		return utf8_charseq_idx_to_byte_idx(this->node().buf.data() + this->info().dropped_bytes, this->info().bytes, char_idx);
+		return utf8_charseq_idx_to_byte_idx(this->node().text().data() + this->info().dropped_bytes, this->info().bytes, char_idx);
 	}
 }
 
@@ -1527,22 +3185,64 @@ namespace atma::_rope_
 	}
 
 	template <typename RT>
-	template <typename... Args>
-	inline node_leaf_t<RT>::node_leaf_t(Args&&... args)
-		: node_t<RT>{node_type_t::leaf, 1u}
+	inline node_leaf_t<RT>::node_leaf_t(node_type_t node_type)
+		: node_t<RT>{node_type, 1u}
+	{}
+
+	template <typename RT>
+	inline auto node_leaf_t<RT>::text() const -> src_buf_t
 	{
-#if ATMA_ROPE_DEBUG_BUFFER
-		atma::memory_value_construct(atma::xfer_dest(buf, RT::buf_size));
-#endif
+		if (this->is_mapped_leaf())
+		{
+			auto const& mapped = static_cast<node_mapped_leaf_t<RT> const&>(*this);
+			return xfer_src(mapped.data, mapped.size);
+		}
 
-		(node_leaf_construct_(buf, std::forward<Args>(args)), ...);
+		return xfer_src(buffer().data(), buffer().size());
 	}
-}
 
+	template <typename RT>
+	inline auto node_leaf_t<RT>::buffer() -> buf_t&
+	{
+		ATMA_ASSERT(!this->is_mapped_leaf());
+		return static_cast<node_buffer_leaf_t<RT>&>(*this).buf;
+	}
 
-//---------------------------------------------------------------------
-//
-//  IMPLEMENTATION :: node_t
+	template <typename RT>
+	inline auto node_leaf_t<RT>::buffer() const -> buf_t const&
+	{
+		ATMA_ASSERT(!this->is_mapped_leaf());
+		return static_cast<node_buffer_leaf_t<RT> const&>(*this).buf;
+	}
+
+	template <typename RT>
+	template <typename... Args>
+	inline node_buffer_leaf_t<RT>::node_buffer_leaf_t(Args&&... args)
+		: node_leaf_t<RT>{node_type_t::leaf}
+	{
+#if ATMA_ROPE_DEBUG_BUFFER
+		atma::memory_value_construct(atma::xfer_dest(buf, RT::buf_size));
+#endif
+
+		(node_leaf_construct_(buf, std::forward<Args>(args)), ...);
+	}
+
+	template <typename RT>
+	inline node_mapped_leaf_t<RT>::node_mapped_leaf_t(rope_mapped_text_ptr const& source, size_t offset, size_t size)
+		: node_leaf_t<RT>{node_type_t::mapped_leaf}
+		, source{source}
+		, data{source->data() + offset}
+		, size{uint32_t(size)}
+	{
+		ATMA_ASSERT(offset + size <= source->size());
+		ATMA_ASSERT(size <= RT::mapped_leaf_size);
+	}
+}
+
+
+//---------------------------------------------------------------------
+//
+//  IMPLEMENTATION :: node_t
 //
 //---------------------------------------------------------------------
 namespace atma::_rope_
@@ -1563,7 +3263,13 @@ namespace atma::_rope_
 	template <typename RT>
 	inline constexpr bool node_t<RT>::is_leaf() const
 	{
-		return node_type_ == node_type_t::leaf;
+		return node_type_ == node_type_t::leaf || node_type_ == node_type_t::mapped_leaf;
+	}
+
+	template <typename RT>
+	inline constexpr bool node_t<RT>::is_mapped_leaf() const
+	{
+		return node_type_ == node_type_t::mapped_leaf;
 	}
 
 	template <typename RT>
@@ -1603,9 +3309,9 @@ namespace atma::_rope_
 	{
 		auto visitor = visit_with{std::forward<Args>(args)...};
 
-		if (node_type_ == node_type_t::branch)
+		if (is_branch())
 			return std::invoke(visitor, this->as_branch());
-		else if (node_type_ == node_type_t::leaf)
+		else if (is_leaf())
 			return std::invoke(visitor, this->as_leaf());
 		else
 			throw std::bad_variant_access{};
@@ -1617,9 +3323,9 @@ namespace atma::_rope_
 	{
 		auto visitor = visit_with{std::forward<Args>(args)...};
 
-		if (node_type_ == node_type_t::branch)
+		if (is_branch())
 			return std::invoke(visitor, this->as_branch());
-		else if (node_type_ == node_type_t::leaf)
+		else if (is_leaf())
 			return std::invoke(visitor, this->as_leaf());
 		else
 			throw std::bad_variant_access{};
@@ -1644,10 +3350,13 @@ namespace atma::_rope_
 		ATMA_ASSERT(byte_idx <= buf.size());
 
 		bool const is_buffer_boundary = (byte_idx == 0 || byte_idx == buf.size());
-		bool const is_utf_codepoint_boundary = (buf[byte_idx] >> 6) != 0b10;
-		bool const is_not_mid_crlf = is_buffer_boundary || !is_seam(buf[byte_idx - 1], buf[byte_idx]);
+		if (is_buffer_boundary)
+			return true;
+
+		bool const is_utf_codepoint_boundary = ((uint8_t)buf[byte_idx] >> 6) != 0b10;
+		bool const is_not_mid_crlf = !is_seam(buf[byte_idx - 1], buf[byte_idx]);
 
-		return is_buffer_boundary || is_utf_codepoint_boundary && is_not_mid_crlf;
+		return is_utf_codepoint_boundary && is_not_mid_crlf;
 	}
 
 	inline auto prev_break(src_buf_t buf, size_t byte_idx) -> size_t
@@ -1811,7 +3520,7 @@ namespace atma::_rope_
 				: redist_split_idx - byte_idx
 				;
 
-			ATMA_ASSERT(utf8_byte_is_leading((byte const)splitbuf[redist_split_idx]));
+			ATMA_ASSERT(utf8_byte_is_leading((byte const)splitbuf[redist_split_idx - redist_splitbuf_copy_begin]));
 		}
 
 		tree_t<RT> new_lhs, new_rhs;
@@ -1885,7 +3594,7 @@ namespace atma::_rope_
 	{
 		return visit_(text_info_t{}, x,
 			[](node_internal_t<RT> const& x) { return x.calculate_combined_info(); },
-			[](node_leaf_t<RT> const& x) { return text_info_t::from_str(x.buf.data(), x.buf.size()); });
+			[](node_leaf_t<RT> const& x) { return text_info_t::from_str(x.text().data(), x.text().size()); });
 	}
 
 	template <typename RT>
@@ -1916,7 +3625,7 @@ namespace atma::_rope_
 			if (char_idx < acc_chars + child.info().characters)
 				break;
 
-			acc_chars += child.info().characters - child.info().dropped_characters;
+			acc_chars += child.info().characters;
 			++child_idx;
 		}
 
@@ -1933,7 +3642,7 @@ namespace atma::_rope_
 			if (char_idx <= acc_chars + child.info().characters)
 				break;
 
-			acc_chars += child.info().characters - child.info().dropped_characters;
+			acc_chars += child.info().characters;
 			++child_idx;
 		}
 
@@ -1944,16 +3653,137 @@ namespace atma::_rope_
 	inline auto for_all_text(F f, tree_t<RT> const& tree) -> void
 	{
 		tree.node().visit(
-			[f](node_internal_t<RT> const& x)
+			[&tree, f](node_internal_t<RT> const&)
 			{
-				x.for_each_child(atma::curry(&for_all_text<F, RT>, f));
+				// the node may have had children appended that this tree doesn't address
+				for (auto const& child : tree.children())
+					for_all_text(f, child);
 			},
 			[&tree, f](node_leaf_t<RT> const& leaf)
 			{
-				auto bufview = std::string_view{leaf.buf.data() + tree.info().dropped_bytes, tree.info().bytes};
+				auto bufview = std::string_view{leaf.text().data() + tree.info().dropped_bytes, tree.info().bytes};
 				std::invoke(f, bufview);
 			});
 	}
+
+	template <typename RT>
+	inline auto find_for_line_idx(node_internal_t<RT> const& x, size_t line_idx) -> std::tuple<size_t, size_t, size_t>
+	{
+		ATMA_ASSERT(line_idx > 0);
+
+		size_t child_idx = 0;
+		size_t acc_lines = 0;
+		size_t acc_chars = 0;
+		for (auto const& child : x.children())
+		{
+			if (line_idx <= acc_lines + child.info().line_breaks)
+				break;
+
+			acc_lines += child.info().line_breaks;
+			acc_chars += child.info().characters;
+			++child_idx;
+		}
+
+		return std::make_tuple(child_idx, line_idx - acc_lines, acc_chars);
+	}
+
+	template <typename RT>
+	inline auto char_idx_of_line(tree_t<RT> const& tree, size_t line_idx) -> size_t
+	{
+		ATMA_ASSERT(line_idx <= tree.info().line_breaks);
+
+		if (line_idx == 0)
+			return 0;
+
+		// descend through the children using their aggregated line-breaks,
+		// accumulating the characters of every child we step over
+		size_t acc_chars = 0;
+		tree_t<RT> cur = tree;
+		while (cur.is_branch())
+		{
+			auto [child_idx, remaining_lines, preceding_chars] = find_for_line_idx(cur.as_branch().node(), line_idx);
+			ATMA_ASSERT(child_idx < cur.child_count());
+
+			acc_chars += preceding_chars;
+			line_idx = remaining_lines;
+			cur = cur.as_branch().child_at((int)child_idx);
+		}
+
+		// find the line-break in the leaf. the line begins at the character
+		// following it, or following its LF if it's a CRLF pair
+		auto const leaf_data = cur.as_leaf().data();
+
+		size_t char_idx = 0;
+		size_t lines = 0;
+		utf8_char_t prev_char;
+		for (auto x : utf8_const_range_t{leaf_data.data(), leaf_data.data() + leaf_data.size()})
+		{
+			bool const is_followon_lf = (x == '\n') && (prev_char == '\r');
+			if (lines == line_idx && !is_followon_lf)
+				break;
+
+			if (utf8_char_is_newline(x) && !is_followon_lf)
+				++lines;
+
+			prev_char = x;
+			++char_idx;
+		}
+
+		return acc_chars + char_idx;
+	}
+
+	template <typename RT>
+	inline auto line_of_char_idx(tree_t<RT> const& tree, size_t char_idx) -> size_t
+	{
+		ATMA_ASSERT(char_idx <= tree.info().characters);
+
+		// descend through the children using their aggregated characters,
+		// accumulating the line-breaks of every child we step over
+		size_t acc_lines = 0;
+		tree_t<RT> cur = tree;
+		while (cur.is_branch())
+		{
+			auto const& branch = cur.as_branch();
+
+			size_t child_idx = 0;
+			for (auto const& child : branch.children())
+			{
+				if (char_idx < child.info().characters || child_idx + 1 == branch.child_count())
+					break;
+
+				acc_lines += child.info().line_breaks;
+				char_idx -= child.info().characters;
+				++child_idx;
+			}
+
+			cur = branch.child_at((int)child_idx);
+		}
+
+		// count the line-breaks preceding char_idx in the leaf. an LF that
+		// is the tail of a CRLF pair belongs to the same line as its CR
+		auto const leaf_data = cur.as_leaf().data();
+
+		size_t idx = 0;
+		utf8_char_t prev_char;
+		for (auto x : utf8_const_range_t{leaf_data.data(), leaf_data.data() + leaf_data.size()})
+		{
+			bool const is_followon_lf = (x == '\n') && (prev_char == '\r');
+			if (idx == char_idx)
+			{
+				if (is_followon_lf)
+					--acc_lines;
+				break;
+			}
+
+			if (utf8_char_is_newline(x) && !is_followon_lf)
+				++acc_lines;
+
+			prev_char = x;
+			++idx;
+		}
+
+		return acc_lines;
+	}
 }
 
 
@@ -2021,7 +3851,7 @@ namespace atma::_rope_
 
 		// slight gotcha: the info's child-count has to align with the node's child-count
 		bool const insertion_is_at_back = idx == dest.backing_children().size() && idx == children.size();
-		bool const space_for_additional_child = dest.node().has_space_for_another_child();
+		bool const space_for_additional_child = dest.has_space_for_another_child();
 
 		if (space_for_additional_child && insertion_is_at_back)
 		{
@@ -2176,10 +4006,10 @@ namespace atma::_rope_
 
 		auto& ins_info = maybe_ins_info.value();
 
-		auto const children = dest_node.children();
+		auto const children = dest.children();
 
 		// we can fit the additional node in
-		if (dest_node.has_space_for_another_child())
+		if (dest.has_space_for_another_child())
 		{
 			auto result_node = make_internal_ptr<RT>(
 				dest_node.height(),
@@ -2268,10 +4098,15 @@ namespace atma::_rope_
 		ATMA_ASSERT(left.height() == right.height());
 		auto const height = left.height();
 
+		// leaves may view only part of their buffer, so only internal
+		// nodes that view all of their children can be checked
 		if constexpr (ATMA_ENABLE_ASSERTS)
 		{
-			tree_t<RT> right_node_info_temp{right.node_pointer()};
-			ATMA_ASSERT(right_node_info_temp.info() == right.info());
+			if (right.is_branch() && right.child_count() == right.as_branch().node().children().size())
+			{
+				tree_t<RT> right_node_info_temp{right.node_pointer()};
+				ATMA_ASSERT(right_node_info_temp.info() == right.info());
+			}
 		}
 
 		auto result_text_info = left.info() + right.info();
@@ -2357,11 +4192,6 @@ namespace atma::_rope_
 			// no children I guess!
 			return {make_leaf_ptr<RT>()};
 		}
-		else if (idx == branch.child_count() - 1)
-		{
-			// all children from first node
-			return branch;
-		}
 		else if (idx == 1)
 		{
 			return {branch.children().front()};
@@ -2422,7 +4252,7 @@ namespace atma::_rope_
 			bool const left_is_saturated = is_saturated(left);
 			bool const left_is_one_level_below_right = left.height() + 1 == right.height();
 
-			if (left_is_saturated && left_is_one_level_below_right && right_branch.node().has_space_for_another_child())
+			if (left_is_saturated && left_is_one_level_below_right && right_branch.has_space_for_another_child())
 			{
 				auto n = insert_(right_branch, 0, left);
 				ATMA_ASSERT(!n.right);
@@ -2468,7 +4298,7 @@ namespace atma::_rope_
 			bool const right_is_saturated = is_saturated(right);
 			bool const right_is_one_level_below_left = right.height() + 1 == left.height();
 
-			if (right_is_saturated && right_is_one_level_below_left && left_branch.node().has_space_for_another_child())
+			if (right_is_saturated && right_is_one_level_below_left && left_branch.has_space_for_another_child())
 			{
 				auto n = append_(left.as_branch(), right);
 				//ATMA_ROPE_VERIFY_INFO_SYNC(n);
@@ -2665,10 +4495,10 @@ namespace atma::_rope_
 		// the tree and melding crlf pairs is for siblings
 		if (maybe_right_info && left_info.is_leaf())
 		{
-			auto const& leftleaf = left_info.as_leaf().node();
-			auto const& rightleaf = maybe_right_info->as_leaf().node();
+			auto const leftdata = left_info.as_leaf().data();
+			auto const rightdata = maybe_right_info->as_leaf().data();
 
-			ATMA_ASSERT(!is_seam(leftleaf.buf.back(), rightleaf.buf[maybe_right_info->info().dropped_bytes]));
+			ATMA_ASSERT(!is_seam(leftdata.back(), rightdata.front()));
 		}
 
 		// case 1: there's no seam. regardless if there's one or two children returned,
@@ -2678,137 +4508,50 @@ namespace atma::_rope_
 			auto r = replace_and_insert_(branch, child_idx, left_info, maybe_right_info);
 			return {r.left, r.right, seam_t::none};
 		}
-		// case 2: there's a seam and we only have one node
-		else if (seam != seam_t::none && !maybe_right_info)
-		{
-			// case 2.1: there's only a left-seam
-			if (seam == seam_t::left)
-			{
-				// case 2.1.1 - we're at the front, can't do anything about it at this level
-				if (child_idx == 0)
-				{
-					auto r = replace_<RT>(branch.as_tree(), child_idx, tree_t<RT>{left_info});
-					return {r, {}, seam_t::left};
-				}
-				// case 2.1.2 - in the middle, try and remove seam
-				else if (auto maybe_nodes = mend_left_seam_(seam, branch.child_at((int)child_idx - 1), left_info))
-				{
-#if 0
-					auto const& [prev, child] = *maybe_nodes;
-					auto [rl, rr] = construct_from_(
-						xfer_src(branch.children()).to(child_idx - 1),
-						xfer_src_list({prev, child}),
-						xfer_src(branch.children()).from(child_idx + 1));
-					
-					ATMA_ASSERT(!rr);
-					return {rl, rr, seam_t::none};
-#endif
-					return {};
-				}
-				// case 2.1.3 - we could not mend the seam (there was no corresponding cr)
-				else
-				{
-					auto r = replace_(branch, child_idx, left_info);
-					return {r, {}, seam_t::none};
-				}
-			}
-			// case 2.2: there's only a right-seam
-			else if (seam == seam_t::right)
-			{
-				// case 2.2.1 - we're at the back, nothing to do
-				if (child_idx == branch.children().size() - 1)
-				{
-					auto r = replace_<RT>(branch, child_idx, tree_t<RT>{left_info});
-					return {r, {}, seam_t::right};
-				}
-				// case 2.2.2 - in the middle, try and remove seam
-				else if (auto maybe_nodes = mend_right_seam_(seam, left_info, branch.child_at((int)child_idx + 1)))
-				{
-					auto const& [child, next] = *maybe_nodes;
-					auto [rl, rr] = replace_and_insert_<RT>(branch, child_idx, child, next);
-					ATMA_ASSERT(!rr);
-					return {rl, rr, seam_t::none};
-				}
-				// case 2.2.3 - we could not mend the seam
-				else
-				{
-					auto r = replace_(branch, child_idx, left_info);
-					return {r, {}, seam_t::none};
-				}
-			}
-			// case 2.3: there's both seams
-			else
-			{
-				// oh jesus
-			}
-		}
 
-#if 0
-		seam_t const left_seam = (seam & seam_t::left);
-		seam_t const right_seam = (seam & seam_t::right);
+		// case 2: there's a seam (or two). we try to mend each seam against our
+		//         sibling on that side. if there is no sibling on that side at this
+		//         level, we pass the seam upwards for our parent to deal with
+		tree_t<RT> left = left_info;
+		maybe_tree_t<RT> right = maybe_right_info;
+		seam_t result_seam = seam_t::none;
 
-		// the two (might be one!) nodes of our edit-result are sitting in the middle
-		// two positions of these children. the potentially-stitched siblings will lie
-		// on either side.
-		auto mended_children = std::array<maybe_tree_t<RT>, 4>
-			{
-				node.try_child_at((int)child_idx - 1),
-				left_info,
-				maybe_right_info,
-				node.try_child_at((int)child_idx + 1)
-			};
+		tree_branch_t<RT> dest = branch;
 
-		// left seam
-		if (left_seam != seam_t::none)
+		// case 2.1: left-seam, the front of our edit-result may start with an lf
+		if ((seam & seam_t::left) != seam_t::none)
 		{
-			auto const [mended_left_seam, maybe_mended_left_nodes] = mend_left_seam_(left_seam, mended_children[0], *mended_children[1]);
-			if (maybe_mended_left_nodes)
+			if (child_idx == 0)
 			{
-				mended_children[0] = std::get<0>(*maybe_mended_left_nodes);
-				mended_children[1] = std::get<1>(*maybe_mended_left_nodes);
+				result_seam = result_seam | seam_t::left;
 			}
-		}
-
-		// right seam
-		if (right_seam != seam_t::none)
-		{
-			auto& right_seam_node = mended_children[2] ? *mended_children[2] : *mended_children[1];
-			auto const [mended_right_seam, maybe_mended_right_nodes] = mend_right_seam_(right_seam, right_seam_node, mended_children[3]);
-			if (maybe_mended_right_nodes)
+			else if (auto maybe_nodes = mend_left_seam_(seam_t::left, branch.child_at((int)child_idx - 1), left))
 			{
-				right_seam_node = std::get<0>(*maybe_mended_right_nodes);
-				mended_children[3] = std::get<1>(*maybe_mended_right_nodes);
+				auto const& [prev, child] = *maybe_nodes;
+				dest = replace_(dest, child_idx - 1, prev);
+				left = child;
 			}
 		}
 
-
-		// if the edit_result we're stitching had two parts, and we were full,
-		// then we must split the node. this is the same as replace_and_insert_
-		// splitting us
-		if (mended_children[2] && branch.children().size() == RT::branching_factor)
+		// case 2.2: right-seam, the back of our edit-result may end with a cr
+		if ((seam & seam_t::right) != seam_t::none)
 		{
-			auto const left_size = RT::branching_factor / 2 + 1;
-			auto const right_size = RT::branching_factor / 2;
+			auto& seam_node = right ? *right : left;
 
-			// case 1: split is to left of both nodes   =>  N N N L R
-			if (child_idx < left_size)
+			if (child_idx == branch.child_count() - 1)
+			{
+				result_seam = result_seam | seam_t::right;
+			}
+			else if (auto maybe_nodes = mend_right_seam_(seam_t::right, seam_node, branch.child_at((int)child_idx + 1)))
 			{
-				//auto result_left = make_internal_ptr<RT>(
-				//	branch.height(),
-				//	
-				//	xfer_src(mended_children, 4),
-				//	xfer_src(branch.children()).from(std::min(child_idx + 2, branch.children().size())));
+				auto const& [child, next] = *maybe_nodes;
+				dest = replace_(dest, child_idx + 1, next);
+				seam_node = child;
 			}
 		}
 
-		auto blah = make_internal_ptr<RT>(
-			branch.height(),
-			xfer_src(branch.children()).take(std::max((int)child_idx - 2, 0)),
-			xfer_src(mended_children, 4),
-			xfer_src(branch.children()).from(std::min(child_idx + 2, branch.children().size())));
-#endif
-
-		return {};
+		auto r = replace_and_insert_(dest, child_idx, left, right);
+		return {r.left, r.right, result_seam};
 	}
 
 	template <typename RT>
@@ -2866,6 +4609,44 @@ namespace atma::_rope_
 	}
 }
 
+namespace atma::_rope_
+{
+	template <typename RT>
+	inline auto tree_join_(tree_t<RT> const& left, tree_t<RT> const& right) -> tree_t<RT>
+	{
+		// empty trees just disappear
+		if (left.info().characters == 0)
+			return right;
+		else if (right.info().characters == 0)
+			return left;
+
+		tree_t<RT> left_prime = left;
+		tree_t<RT> right_prime = right;
+
+		// a cr at the back of left and an lf at the front of right is a seam
+		bool left_back_is_mapped = false;
+		bool const left_has_trailing_cr = navigate_to_back_leaf(left,
+			[&left_back_is_mapped](tree_leaf_t<RT> const& leaf, size_t) {
+				left_back_is_mapped = leaf.node().is_mapped_leaf();
+				return !leaf.data().empty() && leaf.data().back() == charcodes::cr;
+			});
+
+		if (left_has_trailing_cr)
+		{
+			// the lf may be moved onto the back of left
+			if (left_back_is_mapped)
+				left_prime = isolate_for_edit_(left, left.info().characters - 1);
+
+			if (auto maybe_nodes = mend_right_seam_(seam_t::right, left_prime, right))
+			{
+				std::tie(left_prime, right_prime) = *maybe_nodes;
+			}
+		}
+
+		return tree_concat_<RT>(left_prime, right_prime);
+	}
+}
+
 namespace atma::_rope_
 {
 	template <typename RT>
@@ -2875,6 +4656,27 @@ namespace atma::_rope_
 			atma::bind(insert_small_text_<RT>, arg1, arg2, insbuf));
 	}
 
+	// splits a view of a leaf at byte_idx into two views of the same node,
+	// counting only the text on the left
+	template <typename RT>
+	inline auto cut_view_(tree_leaf_t<RT> const& leaf, size_t byte_idx) -> std::tuple<tree_t<RT>, tree_t<RT>>
+	{
+		auto const& info = leaf.info();
+		auto const data = leaf.data();
+		auto const left = text_info_t::from_str(data.data(), byte_idx);
+
+		// an lf is only counted as a line-break of its own without its cr
+		uint32_t const split_crlf = byte_idx != 0 && is_seam(data[byte_idx - 1], data[byte_idx]);
+
+		auto const left_info = left
+			+ text_info_t{.dropped_bytes = info.dropped_bytes, .dropped_characters = info.dropped_characters};
+
+		auto const right_info = info - left
+			+ text_info_t{.dropped_bytes = left.bytes, .dropped_characters = left.characters, .line_breaks = split_crlf};
+
+		return {tree_t<RT>{left_info, leaf.node_pointer()}, tree_t<RT>{right_info, leaf.node_pointer()}};
+	}
+
 	template <typename RT>
 	inline auto split_payload_(tree_leaf_t<RT> const& leaf, size_t char_idx) -> split_result_t<RT>
 	{
@@ -2897,6 +4699,14 @@ namespace atma::_rope_
 
 			return {1, leaf, {}};
 		}
+		else if (leaf.node().is_mapped_leaf())
+		{
+			// mapped text is never written to, so there's no need to copy
+			// it. both halves view the same node
+			auto [left, right] = cut_view_(leaf, split_idx);
+
+			return {1, left, right};
+		}
 		else
 		{
 			// okay, our char-idx has landed us in the middle of our buffer.
@@ -2965,7 +4775,7 @@ namespace atma::_rope_
 			// split_left up the callstack. the RHS must be joined to split_right appropriately
 			if (!split_right)
 			{
-				auto right = make_internal_ptr<RT>(our_height, dest.children().subspan(1));
+				auto right = node_split_across_rhs_(dest, split_idx);
 				return {our_height, split_left, right};
 			}
 			else if (split_right.value().is_saturated() && split_right.value().height() == orig_height)
@@ -2987,7 +4797,7 @@ namespace atma::_rope_
 		{
 			if (!split_left)
 			{
-				auto left = make_internal_ptr<RT>(our_height, dest.children().subspan(0, split_idx));
+				auto left = node_split_across_lhs_(dest, split_idx);
 				return {our_height, left, split_right};
 			}
 			else if (split_left.value().is_saturated() && split_left.value().height() == orig_height)
@@ -3043,206 +4853,284 @@ namespace atma::_rope_
 			&split_payload_<RT>,
 			&split_up_fn_<RT>);
 	}
-}
-
-namespace atma::_rope_
-{
-	template <typename RT>
-	auto erase(tree_t<RT> const& tree, size_t char_idx, size_t size_in_chars) -> erase_result_t<RT>
-	{
-		return erase_(tree, char_idx, char_idx + size_in_chars);
-	}
 
+	// mapped leaves are far bigger than we'd want to copy to make one edit,
+	// so before editing at char_idx, the mapped leaf there is cut (into
+	// views of the same text) down to a few characters either side of it,
+	// which are copied when they're edited like any other leaf
 	template <typename RT>
-	auto erase_(tree_t<RT> const& tree, size_t rel_char_idx, size_t rel_char_end_idx) -> erase_result_t<RT>
+	inline auto isolate_for_edit_(tree_t<RT> const& tree, size_t char_idx) -> tree_t<RT>
 	{
-		// branches need to navigate to the correct children
-		if (tree.node().is_branch())
-		{
-			auto const& branch = tree.as_branch();
+		if (char_idx >= tree.info().characters)
+			return tree;
 
-			ATMA_ASSERT(rel_char_idx < rel_char_end_idx);
-			ATMA_ASSERT(rel_char_idx <= branch.info().characters);
-			ATMA_ASSERT(rel_char_end_idx <= branch.info().characters);
+		using cuts_t = std::tuple<std::optional<size_t>, std::optional<size_t>>;
 
-			// find begin & end children
-			auto [start_child_idx, start_char_idx] = find_for_char_idx(branch.node(), rel_char_idx);
-			auto [end_child_idx, end_char_idx] = find_for_char_idx_within(branch.node(), rel_char_end_idx);
+		auto cuts = navigate_to_leaf(tree, char_idx, tree_find_for_char_idx<RT>,
+			[char_idx](tree_leaf_t<RT> const& leaf, size_t rel_char_idx) -> cuts_t
+			{
+				if (!leaf.node().is_mapped_leaf() || leaf.info().bytes <= RT::buf_edit_max_size)
+					return {};
 
+				// a window of buf_edit_split_size / 2 bytes, widened to whole
+				// characters and crlf pairs, which fits in a buffer
+				constexpr size_t reach = std::max<size_t>(RT::buf_edit_split_size / 4, 1);
 
-			// case 1: the section to erase is entirely within one child
-			if (start_child_idx == end_child_idx)
-			{
-				auto [result_lhs, result_rhs] = erase_(tree_t<RT>{
-					branch.children()[start_child_idx]},
-					start_char_idx, end_char_idx);
+				auto const data = leaf.data();
+				size_t const byte_idx = leaf.byte_idx_from_char_idx(rel_char_idx);
+				size_t const lo = byte_idx - std::min(byte_idx, reach);
+				size_t const hi = std::min(data.size(), byte_idx + reach);
 
-				if (result_lhs)
-				{
-					auto [ins_lhs, ins_rhs] = replace_and_insert_(branch, start_child_idx, *result_lhs, result_rhs);
-					return {ins_lhs, ins_rhs};
-				}
-				else if (result_rhs)
-				{
-					auto result = replace_(branch, start_child_idx, *result_rhs);
-					return {result};
-				}
-				else
-				{
-					// we lost the whole node, a.k.a. the char-idxs happened to be the
-					// first and last indexes of this buffer
+				size_t const begin = is_break(data, lo) ? lo : prev_break(data, lo);
+				size_t const end = is_break(data, hi) ? hi : next_break(data, hi);
 
-					auto new_branch = make_internal_ptr<RT>(branch.height(),
-						xfer_src(branch.children()).to(start_child_idx),
-						xfer_src(branch.children()).from(start_child_idx + 1));
+				auto chars = [&](size_t from, size_t to) { return leaf_text_info_count_chars_({data.data() + from, to - from}); };
 
-					return {new_branch};
-				}
-			}
-			// case 2: what to delete spans more than one child
-			else
-			{
-				auto const& start_child = tree_t<RT>{branch.children()[start_child_idx]};
-				auto const& end_child = tree_t<RT>{tree.children()[end_child_idx]};
-
-				// what we need to do is the following:
-				//   1) recurse into the two children in question
-				//   2) delete all intervening children
-				//   3) recreate the node with the remnants of the two nodes
-				//
-				// note: because the range of characters to delete is crossing the boundary
-				//       of child nodes, we can guarantee that neither result of our recursion
-				//       into our two children endpoints will return two parts, as the
-				//       range of characters extends fully past one of their ends. they *may*
-				//       return zero parts, if the full buffer was erased.
-				//
-				//       this means we can never have more nodes than previously,
-				//       which simplifies our upwards stitching.
-
-
-				// erase at the start of the range
-				auto [start_lhs, start_rhs] = erase_(
-					start_child,
-					start_char_idx, start_child.info().characters);
-
-				// erase at the end
-				auto [end_lhs, end_rhs] = erase_(
-					end_child,
-					0u, end_char_idx);
-				
-				auto new_branch = make_internal_ptr<RT>(branch.height(),
-					xfer_src(branch.children()).to(start_child_idx),
-					start_lhs, start_rhs,
-					end_lhs, end_rhs,
-					xfer_src(branch.children()).from(end_child_idx + 1));
+				return {
+					(begin == 0) ? std::nullopt : std::optional{char_idx - chars(begin, byte_idx)},
+					(end == data.size()) ? std::nullopt : std::optional{char_idx + chars(byte_idx, end)}};
+			});
 
-				return {new_branch};
-			}
-		}
-		// we're a leaf, we need to split our buffer
-		else
+		auto cut = [](tree_t<RT> const& tree, size_t char_idx) -> tree_t<RT>
 		{
-			auto const& leaf = tree.as_leaf();
+			auto [left, right, seam] = edit_chunk_at_char(tree, char_idx,
+				[](tree_leaf_t<RT> const& leaf, size_t rel_char_idx) {
+					auto [left, right] = cut_view_(leaf, leaf.byte_idx_from_char_idx(rel_char_idx));
+					return edit_result_t<RT>{left, right};
+				});
 
-			// case 1: the whole node is deleted
-			if (rel_char_idx == 0 && rel_char_end_idx == tree.info().characters)
-			{
-				return {};
-			}
-			// case 2: there's leftover bits on the lhs
-			//   - split buffer & return lhs
-			else if (rel_char_idx > 0 && rel_char_end_idx == tree.info().characters)
-			{
-				auto byte_idx = leaf.byte_idx_from_char_idx(rel_char_idx);
-				auto lhs = make_leaf_ptr<RT>(leaf.data().take(byte_idx));
-				return {lhs, {}};
-			}
-			// case 3: there's leftover bits on the rhs
-			//  - split buffer & return rhs
-			else if (rel_char_idx == 0 && rel_char_end_idx < tree.info().characters)
-			{
-				auto byte_idx = leaf.byte_idx_from_char_idx(rel_char_end_idx);
-				auto rhs = make_leaf_ptr<RT>(leaf.data().from(byte_idx));
-				return {{}, rhs};
-			}
-			// case 4: this delete operation is fully within this buffer
-			//  - recreate the buffer without the missing bit and return the node
-			else
-			{
-				auto start_byte_idx = leaf.byte_idx_from_char_idx(rel_char_idx);
-				auto end_byte_idx = leaf.byte_idx_from_char_idx(rel_char_end_idx);
+			return right
+				? tree_t<RT>{make_internal_ptr<RT>(left.height() + 1, left, *right)}
+				: left;
+		};
 
-				auto new_leaf = make_leaf_ptr<RT>(
-					leaf.data().take(start_byte_idx),
-					leaf.data().from(end_byte_idx));
+		// the end first, so that the beginning is still where it was
+		auto [begin, end] = cuts;
+		tree_t<RT> result = tree;
 
-				return {new_leaf};
-			}
-		}
+		if (end)
+			result = cut(result, *end);
+		if (begin)
+			result = cut(result, *begin);
+
+		return result;
 	}
-}
 
+	// isolates (see above) every leaf an edit of [char_idx, char_end_idx)
+	// might touch, including either neighbour, whose crlf pairs it may mend
+	template <typename RT>
+	inline auto isolate_for_edit_(tree_t<RT> const& tree, size_t char_idx, size_t char_end_idx) -> tree_t<RT>
+	{
+		tree_t<RT> result = tree;
+
+		if (char_idx != 0)
+			result = isolate_for_edit_(result, char_idx - 1);
+
+		result = isolate_for_edit_(result, char_idx);
+
+		if (char_end_idx != char_idx)
+		{
+			result = isolate_for_edit_(result, char_end_idx - 1);
+			result = isolate_for_edit_(result, char_end_idx);
+		}
 
+		return result;
+	}
+}
 
 namespace atma::_rope_
 {
 	template <typename RT>
-	inline auto insert_small_text_(tree_leaf_t<RT> const& leaf, size_t char_idx, src_buf_t insbuf) -> edit_result_t<RT>
+	inline auto erase_small_text_(tree_leaf_t<RT> const& leaf, size_t char_idx, size_t size_in_chars) -> edit_result_t<RT>
 	{
-		ATMA_ASSERT(insbuf.size() <= RT::buf_edit_max_size);
-		auto const& leaf_node = leaf.node();
 		auto const& leaf_info = leaf.info();
 
+		// validate assumptions:
+		//  - the range to erase is within this leaf
+		//  - we're not erasing the whole leaf (that's a structural change)
+		ATMA_ASSERT(char_idx + size_in_chars <= leaf_info.characters);
+		ATMA_ASSERT(size_in_chars < leaf_info.characters);
+
 		// early out
-		if (insbuf.empty())
+		if (size_in_chars == 0)
 		{
 			return {leaf};
 		}
 
-		// check left seam
-		//
-		// determine if the first character in our incoming text is an lf character,
-		// and we're trying to insert this text at the front of this chunk. if we
-		// are doing that, then we want to insert the lf character in the previous
-		// logical chunk, so if it may tack onto any cr character at the end of that
-		// previous chunk, resulting in us only counting them as one line-break
-		bool const inserting_at_front = char_idx == 0;
-		bool const lf_at_front = insbuf[0] == charcodes::lf;
-		seam_t const left_seam = (inserting_at_front && lf_at_front) ? seam_t::left : seam_t::none;
-		if (left_seam != seam_t::none)
-		{
-			insbuf = insbuf.skip(1);
-		}
-
-		// check right seam
-		//
-		// words
-		bool const inserting_at_end = char_idx == leaf.info().characters;
-		bool const cr_at_end = insbuf[insbuf.size() - 1] == charcodes::cr;
-		seam_t const right_seam = (inserting_at_end && cr_at_end) ? seam_t::right : seam_t::none;
+		auto const data = leaf.data();
+		size_t const byte_idx = leaf.byte_idx_from_char_idx(char_idx);
+		size_t const byte_end_idx = leaf.byte_idx_from_char_idx(char_idx + size_in_chars);
 
+		bool const erasing_front = char_idx == 0;
+		bool const erasing_back = char_idx + size_in_chars == leaf_info.characters;
 
-		// calculate byte index from character index
-		auto byte_idx = utf8_charseq_idx_to_byte_idx(leaf.data().data(), leaf.data().size(), char_idx);
+		tree_t<RT> result;
 
-		// if we want to append, we must first make sure that the (immutable, remember) buffer
-		// does not have any trailing information used by other trees. secondly, we must make
-		// sure that the byte_idx of the character is actually the last byte_idx of the buffer
-		bool buf_is_appendable = (leaf_info.dropped_bytes + leaf_info.bytes) == leaf_node.buf.size();
-		bool byte_idx_is_at_end = leaf_info.bytes == byte_idx;
-		bool can_fit_in_chunk = leaf_info.bytes + insbuf.size() <= RT::buf_edit_max_size;
+		// erasing from either end of the (immutable) buffer doesn't require a
+		// new buffer, we can just view less of it. the front is "dropped"
+		if (erasing_front)
+		{
+			auto const remaining = data.from(byte_end_idx);
 
-		ATMA_ASSERT(inserting_at_end == byte_idx_is_at_end);
+			auto result_info = text_info_t::from_str(remaining.data(), remaining.size())
+				+ text_info_t{
+					.dropped_bytes = uint32_t(leaf_info.dropped_bytes + byte_end_idx),
+					.dropped_characters = uint32_t(leaf_info.dropped_characters + size_in_chars)};
 
-		// simple append is possible
-		if (can_fit_in_chunk && inserting_at_end && buf_is_appendable)
+			result = tree_t<RT>{result_info, leaf.node_pointer()};
+		}
+		else if (erasing_back)
 		{
-			auto& mut_buf = const_cast<typename node_leaf_t<RT>::buf_t&>(leaf_node.buf);
+			auto const remaining = data.to(byte_idx);
 
-			mut_buf.append(insbuf);
+			auto result_info = text_info_t::from_str(remaining.data(), remaining.size())
+				+ text_info_t{
+					.dropped_bytes = leaf_info.dropped_bytes,
+					.dropped_characters = leaf_info.dropped_characters};
 
-			auto affix_string_info = _rope_::text_info_t::from_str(insbuf.data(), insbuf.size());
-			auto result_info = leaf_info + affix_string_info;
+			result = tree_t<RT>{result_info, leaf.node_pointer()};
+		}
+		else
+		{
+			result = tree_t<RT>{make_leaf_ptr<RT>(
+				data.to(byte_idx),
+				data.from(byte_end_idx))};
+		}
+
+		// we may have exposed an lf at the front, or a cr at the back, which
+		// will need mending against our neighbours
+		auto const result_data = result.as_leaf().data();
+		seam_t const left_seam = (erasing_front && result_data.front() == charcodes::lf) ? seam_t::left : seam_t::none;
+		seam_t const right_seam = (erasing_back && result_data.back() == charcodes::cr) ? seam_t::right : seam_t::none;
+
+		return edit_result_t<RT>{result, {}, left_seam | right_seam};
+	}
+
+	template <typename RT>
+	inline auto erase_across_leaves_(tree_t<RT> const& tree, size_t char_idx, size_t size_in_chars) -> tree_t<RT>
+	{
+		size_t const char_end_idx = char_idx + size_in_chars;
+
+		// split off the text either side of the range. this only allocates
+		// along the two paths to the split-points, everything else is shared
+		maybe_tree_t<RT> left = (char_idx == 0)
+			? maybe_tree_t<RT>{}
+			: split<RT>(tree, char_idx).left;
+
+		maybe_tree_t<RT> right = (char_end_idx == tree.info().characters)
+			? maybe_tree_t<RT>{}
+			: split<RT>(tree, char_end_idx).right;
+
+		if (!left && !right)
+		{
+			return tree_t<RT>{make_leaf_ptr<RT>()};
+		}
+		else if (!left)
+		{
+			return *right;
+		}
+		else if (!right)
+		{
+			return *left;
+		}
+
+		// we may have brought a cr & lf together across the two halves
+		return tree_join_<RT>(*left, *right);
+	}
+
+	template <typename RT>
+	inline auto erase(tree_t<RT> const& tree, size_t char_idx, size_t size_in_chars) -> edit_result_t<RT>
+	{
+		ATMA_ASSERT(char_idx + size_in_chars <= tree.info().characters);
+
+		if (size_in_chars == 0)
+		{
+			return {tree};
+		}
+
+		// determine if the erase is entirely within one leaf, leaving that leaf non-empty.
+		// this is by far the most common case (think backspace), and we can edit the
+		// chunk in place and stitch the tree back together
+		bool const is_within_leaf = navigate_to_leaf(tree, char_idx,
+			tree_find_for_char_idx<RT>,
+			[size_in_chars](tree_leaf_t<RT> const& leaf, size_t rel_char_idx)
+			{
+				return rel_char_idx + size_in_chars <= leaf.info().characters
+					&& size_in_chars < leaf.info().characters;
+			});
+
+		if (is_within_leaf)
+		{
+			return navigate_to_leaf(tree, char_idx,
+				tree_find_for_char_idx<RT>,
+				atma::bind(erase_small_text_<RT>, arg1, arg2, size_in_chars),
+				stitch_upwards_<RT>);
+		}
+		else
+		{
+			return {erase_across_leaves_(tree, char_idx, size_in_chars)};
+		}
+	}
+}
+
+
+
+namespace atma::_rope_
+{
+	template <typename RT>
+	inline auto insert_small_text_(tree_leaf_t<RT> const& leaf, size_t char_idx, src_buf_t insbuf) -> edit_result_t<RT>
+	{
+		ATMA_ASSERT(insbuf.size() <= RT::buf_edit_max_size);
+		auto const& leaf_node = leaf.node();
+		auto const& leaf_info = leaf.info();
+
+		// early out
+		if (insbuf.empty())
+		{
+			return {leaf};
+		}
+
+		// check left seam
+		//
+		// determine if the first character in our incoming text is an lf character,
+		// and we're trying to insert this text at the front of this chunk. if we
+		// are doing that, then we want to move the lf character to the previous
+		// logical chunk, so if it may tack onto any cr character at the end of that
+		// previous chunk, resulting in us only counting them as one line-break.
+		// the lf stays in our chunk until mend_left_seam_ moves it
+		bool const inserting_at_front = char_idx == 0;
+		bool const lf_at_front = insbuf[0] == charcodes::lf;
+		seam_t const left_seam = (inserting_at_front && lf_at_front) ? seam_t::left : seam_t::none;
+
+		// check right seam
+		//
+		// words
+		bool const inserting_at_end = char_idx == leaf.info().characters;
+		bool const cr_at_end = insbuf[insbuf.size() - 1] == charcodes::cr;
+		seam_t const right_seam = (inserting_at_end && cr_at_end) ? seam_t::right : seam_t::none;
+
+
+		// calculate byte index from character index
+		auto byte_idx = utf8_charseq_idx_to_byte_idx(leaf.data().data(), leaf.data().size(), char_idx);
+
+		// if we want to append, we must first make sure that the (immutable, remember) buffer
+		// does not have any trailing information used by other trees. secondly, we must make
+		// sure that the byte_idx of the character is actually the last byte_idx of the buffer
+		bool buf_is_appendable = !leaf_node.is_mapped_leaf() && (leaf_info.dropped_bytes + leaf_info.bytes) == leaf_node.buffer().size();
+		bool byte_idx_is_at_end = leaf_info.bytes == byte_idx;
+		bool can_fit_in_chunk = leaf_info.bytes + insbuf.size() <= RT::buf_edit_max_size;
+
+		ATMA_ASSERT(inserting_at_end == byte_idx_is_at_end);
+
+		// simple append is possible
+		if (can_fit_in_chunk && inserting_at_end && buf_is_appendable)
+		{
+			auto& mut_buf = const_cast<typename node_leaf_t<RT>::buf_t&>(leaf_node.buffer());
+
+			mut_buf.append(insbuf);
+
+			auto affix_string_info = _rope_::text_info_t::from_str(insbuf.data(), insbuf.size());
+			auto result_info = leaf_info + affix_string_info;
 			auto result = tree_leaf_t<RT>{result_info, 0, leaf.node_pointer()};
 
 			return _rope_::edit_result_t<RT>{result, {}, left_seam | right_seam};
@@ -3250,13 +5138,14 @@ namespace atma::_rope_
 		// we're not appending, but we can fit within the chunk: reallocate & insert
 		else if (can_fit_in_chunk)
 		{
-			auto affix_string_info = _rope_::text_info_t::from_str(insbuf.data(), insbuf.size());
-			auto result_info = leaf_info + affix_string_info;
-
 			auto result_node = _rope_::make_leaf_ptr<RT>(
 					leaf.data().take(byte_idx),
 					insbuf,
 					leaf.data().from(byte_idx));
+
+			// the new buffer holds only our view, so nothing is dropped from its front
+			auto const result_text = result_node->as_leaf().text();
+			auto result_info = _rope_::text_info_t::from_str(result_text.data(), result_text.size());
 			
 			auto result = tree_leaf_t<RT>{result_info, 0, result_node};
 
@@ -3315,15 +5204,148 @@ namespace atma::_rope_
 			return {};
 		}
 
-		bool const can_fit_in_chunk = leaf.node().buf.size() + 1 <= RT::buf_size;
-		ATMA_ASSERT(can_fit_in_chunk);
+		// the buffer is append-only, so if we view all the way up to its end
+		// we can just tack the lf on. otherwise there are bytes past our view
+		// that we mustn't touch, and we need a new buffer
+		bool const buf_is_appendable = !leaf.node().is_mapped_leaf() && leaf.info().all_bytes() == leaf.node().buffer().size();
+		bool const can_fit_in_chunk = leaf.node().text().size() + 1 <= RT::buf_size;
 
-		const_cast<node_leaf_t<RT>&>(leaf.node())
-			.buf.push_back(charcodes::lf);
+		if (buf_is_appendable && can_fit_in_chunk)
+		{
+			const_cast<node_leaf_t<RT>&>(leaf.node())
+				.buffer().push_back(charcodes::lf);
 
-		auto result_info = leaf.info() + text_info_t{.bytes = 1, .characters = 1};
-		auto result = tree_t<RT>{result_info, leaf.node_pointer()};
-		return result;
+			auto result_info = leaf.info() + text_info_t{.bytes = 1, .characters = 1};
+			auto result = tree_t<RT>{result_info, leaf.node_pointer()};
+			return result;
+		}
+		else
+		{
+			ATMA_ASSERT(leaf.info().bytes + 1 <= RT::buf_size);
+
+			char const lf = charcodes::lf;
+			auto result = tree_t<RT>{make_leaf_ptr<RT>(leaf.data(), xfer_src(&lf, 1))};
+			return result;
+		}
+	}
+}
+
+namespace atma::_rope_
+{
+	template <typename RT>
+	inline auto is_uniquely_owned_(tree_t<RT> const& tree) -> bool
+	{
+		return ref_counted_traits<node_t<RT>>::use_count(&tree.node()) == 1;
+	}
+
+	template <typename RT, typename FindFn, typename PayloadFn>
+	inline auto edit_in_place_(tree_t<RT>& tree, size_t char_idx, FindFn&& find_fn, PayloadFn&& payload_fn) -> bool
+	{
+		// mapped leaves are read-only, and are copied on edit
+		if (!is_uniquely_owned_(tree) || tree.node().is_mapped_leaf())
+			return false;
+
+		if (tree.is_leaf())
+		{
+			auto& leaf = const_cast<node_leaf_t<RT>&>(tree.node().as_leaf());
+
+			auto result_info = payload_fn(leaf, tree.info(), char_idx);
+			if (!result_info)
+				return false;
+
+			leaf.hash_cache.reset();
+			leaf.summary_cache.reset();
+
+			tree = tree_t<RT>{*result_info, tree.child_count(), tree.node_pointer()};
+			return true;
+		}
+
+		auto& branch = const_cast<node_internal_t<RT>&>(tree.node().as_branch());
+		auto [child_idx, child_char_idx] = find_fn(tree.as_branch(), char_idx);
+
+		auto& child = branch.child_at((uint32_t)child_idx);
+		auto const child_prior_info = child.info();
+
+		if (!edit_in_place_<RT>(child, child_char_idx, find_fn, payload_fn))
+			return false;
+
+		branch.hash_cache.reset();
+		branch.summary_cache.reset();
+
+		// only our aggregate changes, by however much our child's did
+		auto result_info = tree.info() - child_prior_info + child.info();
+		tree = tree_t<RT>{result_info, tree.child_count(), tree.node_pointer()};
+		return true;
+	}
+
+	// nothing else views this buffer, so we can discard whatever is outside our
+	// view, keeping the buffer as exactly our text from the front
+	template <typename RT>
+	inline auto compact_leaf_buffer_(node_leaf_t<RT>& leaf, text_info_t const& info) -> void
+	{
+		leaf.buffer().erase(info.all_bytes(), leaf.buffer().size() - info.all_bytes());
+		leaf.buffer().erase(0, info.dropped_bytes);
+	}
+
+	template <typename RT>
+	inline auto insert_in_place_(tree_t<RT>& tree, size_t char_idx, src_buf_t insbuf) -> bool
+	{
+		auto payload = [insbuf](node_leaf_t<RT>& leaf, text_info_t const& info, size_t rel_char_idx) -> std::optional<text_info_t>
+		{
+			// anything that would seam with a neighbour, or split, isn't for us
+			bool const left_seam = rel_char_idx == 0 && insbuf[0] == charcodes::lf;
+			bool const right_seam = rel_char_idx == info.characters && insbuf[insbuf.size() - 1] == charcodes::cr;
+			bool const can_fit_in_chunk = info.bytes + insbuf.size() <= RT::buf_edit_max_size;
+
+			if (left_seam || right_seam || !can_fit_in_chunk)
+				return std::nullopt;
+
+			char const* data = leaf.buffer().data() + info.dropped_bytes;
+			size_t const byte_idx = utf8_charseq_idx_to_byte_idx(data, info.bytes, rel_char_idx);
+
+			compact_leaf_buffer_(leaf, info);
+			leaf.buffer().insert(byte_idx, insbuf.data(), insbuf.size());
+
+			// recounting the whole leaf catches crlf pairs made or broken by the insert
+			return text_info_t::from_str(leaf.buffer().data(), leaf.buffer().size());
+		};
+
+		if (insbuf.empty())
+			return true;
+
+		return edit_in_place_<RT>(tree, char_idx, tree_find_for_char_idx_within<RT>, payload);
+	}
+
+	template <typename RT>
+	inline auto erase_in_place_(tree_t<RT>& tree, size_t char_idx, size_t size_in_chars) -> bool
+	{
+		auto payload = [size_in_chars](node_leaf_t<RT>& leaf, text_info_t const& info, size_t rel_char_idx) -> std::optional<text_info_t>
+		{
+			// erasing the whole leaf is a structural change
+			if (rel_char_idx + size_in_chars > info.characters || size_in_chars == info.characters)
+				return std::nullopt;
+
+			char const* data = leaf.buffer().data() + info.dropped_bytes;
+			size_t const byte_idx = utf8_charseq_idx_to_byte_idx(data, info.bytes, rel_char_idx);
+			size_t const byte_end_idx = utf8_charseq_idx_to_byte_idx(data, info.bytes, rel_char_idx + size_in_chars);
+
+			// exposing an lf at the front, or a cr at the back, may need mending
+			bool const left_seam = rel_char_idx == 0 && data[byte_end_idx] == charcodes::lf;
+			bool const right_seam = rel_char_idx + size_in_chars == info.characters && data[byte_idx - 1] == charcodes::cr;
+
+			if (left_seam || right_seam)
+				return std::nullopt;
+
+			compact_leaf_buffer_(leaf, info);
+			leaf.buffer().erase(byte_idx, byte_end_idx - byte_idx);
+
+			return text_info_t::from_str(leaf.buffer().data(), leaf.buffer().size());
+		};
+
+		if (size_in_chars == 0)
+			return true;
+
+		return edit_in_place_<RT>(tree, char_idx, tree_find_for_char_idx<RT>, payload);
 	}
 }
 
@@ -3458,6 +5480,31 @@ namespace atma::_rope_
 
 namespace atma::_rope_
 {
+	// cuts leaf-sized pieces from the front of str, invoking f with each, and
+	// returns how many bytes that took. where a piece is cut depends on the
+	// text after it, so unless str is the last of the text, a tail that'd
+	// fit in a leaf is left for the next call (with more text appended)
+	//
+	// note: we fill buffers only up to buf_edit_max_size, so that there's
+	// always room to append an lf when mending a seam. mapped leaves are
+	// never appended to, and are cut at mapped_leaf_size instead
+	template <typename RT, typename F>
+	inline auto cut_leaves_(src_buf_t str, bool last, F&& f, size_t leaf_size = RT::buf_edit_max_size) -> size_t
+	{
+		size_t const str_size = str.size();
+
+		while (last ? !str.empty() : str.size() > leaf_size)
+		{
+			size_t candidate_split_idx = std::min(str.size(), leaf_size);
+			auto split_idx = find_split_point(str, candidate_split_idx, split_bias::hard_left);
+
+			f(str.take(split_idx));
+			str = str.skip(split_idx);
+		}
+
+		return str_size - str.size();
+	}
+
 	template <typename RT>
 	struct build_rope_t_
 	{
@@ -3476,6 +5523,31 @@ namespace atma::_rope_
 		auto stack_finish(level_stack_t& stack) const -> tree_t<RT>;
 
 		auto operator ()(src_buf_t str) const -> tree_t<RT>;
+
+		// builds a tree bottom-up from non-empty text, leaves filled to capacity
+		auto build_(src_buf_t str) const -> tree_t<RT>;
+
+		// builds a tree of mapped_leaf_size leaves that view the mapped text
+		// rather than copy it. the text is still counted, which is spread
+		// across threads in the same way as below
+		auto operator ()(rope_mapped_text_ptr const&, size_t thread_count = 1) const -> tree_t<RT>;
+
+		// the loop shared by both of the above. make_leaf turns the text
+		// of each leaf (of at most leaf_size bytes) into a node
+		template <typename F>
+		auto build_leaves_(src_buf_t str, F&& make_leaf, size_t leaf_size = RT::buf_edit_max_size) const -> tree_t<RT>;
+
+		// pushes leaves cut from the front of str (see cut_leaves_)
+		template <typename F>
+		auto push_leaves_(level_stack_t&, src_buf_t str, bool last, F&& make_leaf, size_t leaf_size = RT::buf_edit_max_size) const -> size_t;
+
+		// partitions str at valid split-points and builds each partition on its
+		// own thread, then concatenates the resultant trees in order
+		auto operator ()(src_buf_t str, size_t thread_count) const -> tree_t<RT>;
+
+		// the partitioning behind the above. build builds one partition
+		template <typename F>
+		auto build_partitioned_(src_buf_t str, size_t thread_count, F&& build) const -> tree_t<RT>;
 	};
 
 	template <typename RT>
@@ -3598,29 +5670,138 @@ namespace atma::_rope_
 	inline auto build_rope_t_<RT>::operator ()(src_buf_t str) const -> tree_t<RT>
 	{
 		// remove null terminator if necessary
-		if (str[str.size() - 1] == '\0')
+		if (!str.empty() && str[str.size() - 1] == '\0')
 			str = str.take(str.size() - 1);
 
-		level_stack_t stack;
+		// an empty string is an empty leaf
+		if (str.empty())
+			return tree_t<RT>{make_leaf_ptr<RT>()};
 
-		// case 1. the str is small enough to just be inserted as a leaf
-		while (!str.empty())
-		{
-			size_t candidate_split_idx = std::min(str.size(), RT::buf_size);
-			auto split_idx = find_split_point(str, candidate_split_idx, split_bias::hard_left);
+		return build_(str);
+	}
 
-			auto leaf_text = str.take(split_idx);
-			str = str.skip(split_idx);
+	template <typename RT>
+	inline auto build_rope_t_<RT>::build_(src_buf_t str) const -> tree_t<RT>
+	{
+		return build_leaves_(str, [](src_buf_t leaf_text) {
+			return make_leaf_ptr<RT>(leaf_text);
+		});
+	}
+
+	template <typename RT>
+	inline auto build_rope_t_<RT>::operator ()(rope_mapped_text_ptr const& source, size_t thread_count) const -> tree_t<RT>
+	{
+		ATMA_ASSERT(source);
 
-			auto new_leaf = tree_t<RT>{make_leaf_ptr<RT>(leaf_text)};
+		// we can't drop a null-terminator from mapped text, as the leaves
+		// view the text verbatim. a file shouldn't have one anyway
+		auto str = src_buf_t{source->data(), source->size()};
+		if (str.empty())
+			return tree_t<RT>{make_leaf_ptr<RT>()};
 
-			stack_push(stack, 0, new_leaf);
-		}
+		auto make_leaf = [&source, base = source->data()](src_buf_t leaf_text) {
+			return make_mapped_leaf_ptr<RT>(source, leaf_text.data() - base, leaf_text.size());
+		};
+
+		return build_partitioned_(str, thread_count, [&](src_buf_t partition) {
+			return build_leaves_(partition, make_leaf, RT::mapped_leaf_size);
+		});
+	}
+
+	template <typename RT>
+	template <typename F>
+	inline auto build_rope_t_<RT>::build_leaves_(src_buf_t str, F&& make_leaf, size_t leaf_size) const -> tree_t<RT>
+	{
+		ATMA_ASSERT(!str.empty());
+
+		level_stack_t stack;
+		push_leaves_(stack, str, true, std::forward<F>(make_leaf), leaf_size);
 
 		// stack fixup
 		auto r = stack_finish(stack);
 		return r;
 	}
+
+	template <typename RT>
+	template <typename F>
+	inline auto build_rope_t_<RT>::push_leaves_(level_stack_t& stack, src_buf_t str, bool last, F&& make_leaf, size_t leaf_size) const -> size_t
+	{
+		return cut_leaves_<RT>(str, last, [&](src_buf_t leaf_text) {
+			stack_push(stack, 0, tree_t<RT>{make_leaf(leaf_text)});
+		}, leaf_size);
+	}
+
+	template <typename RT>
+	inline auto build_rope_t_<RT>::operator ()(src_buf_t str, size_t thread_count) const -> tree_t<RT>
+	{
+		// remove null terminator if necessary
+		if (!str.empty() && str[str.size() - 1] == '\0')
+			str = str.take(str.size() - 1);
+
+		if (str.empty())
+			return tree_t<RT>{make_leaf_ptr<RT>()};
+
+		return build_partitioned_(str, thread_count, [this](src_buf_t partition) {
+			return build_(partition);
+		});
+	}
+
+	template <typename RT>
+	template <typename F>
+	inline auto build_rope_t_<RT>::build_partitioned_(src_buf_t str, size_t thread_count, F&& build) const -> tree_t<RT>
+	{
+		// a thread is only worth it if it's got a decent number of leaves to build
+		constexpr size_t min_bytes_per_thread = RT::buf_size * RT::branching_factor * 64;
+		thread_count = std::min(thread_count, str.size() / min_bytes_per_thread);
+
+		if (thread_count <= 1)
+			return build(str);
+
+		// partition, making sure not to split utf8 characters or crlf pairs
+		std::vector<src_buf_t> partitions;
+		partitions.reserve(thread_count);
+
+		size_t partition_begin = 0;
+		for (size_t i = 1; i != thread_count; ++i)
+		{
+			size_t const partition_end = find_split_point(str, str.size() * i / thread_count, split_bias::hard_left);
+			if (partition_end <= partition_begin)
+				continue;
+
+			partitions.push_back(str.from_to(partition_begin, partition_end));
+			partition_begin = partition_end;
+		}
+
+		partitions.push_back(str.from(partition_begin));
+
+		// build each partition. this thread takes the first
+		std::vector<tree_t<RT>> subtrees(partitions.size());
+		{
+			std::vector<std::thread> threads;
+			threads.reserve(partitions.size() - 1);
+
+			for (size_t i = 1; i != partitions.size(); ++i)
+			{
+				threads.emplace_back([&build, &partitions, &subtrees, i] {
+					subtrees[i] = build(partitions[i]);
+				});
+			}
+
+			subtrees[0] = build(partitions[0]);
+
+			for (auto& x : threads)
+				x.join();
+		}
+
+		// concatenating is logarithmic in the size of the subtrees
+		tree_t<RT> result = subtrees[0];
+		for (size_t i = 1; i != subtrees.size(); ++i)
+		{
+			result = tree_concat_<RT>(result, subtrees[i]);
+		}
+
+		return result;
+	}
 }
 
 
@@ -3700,9 +5881,9 @@ namespace atma::_rope_
 	inline auto append_node_t_::append_node_(tree_t<RT> const& dest, node_ptr<RT> const& ins) const -> treeop_result_t<RT>
 	{
 		return dest.node().visit(
-			[&](node_internal_t<RT> const& x)
+			[&](node_internal_t<RT> const&)
 			{
-				auto const children = x.children();
+				auto const children = dest.children();
 				ATMA_ASSERT(children.size() >= RT::branching_factor / 2);
 
 				// recurse if our right-most child is an internal node
@@ -3757,15 +5938,22 @@ namespace atma::_rope_
 	inline auto build_rope_naive(src_buf_t str) -> tree_t<RT>
 	{
 		// remove null terminator if necessary
-		if (str[str.size() - 1] == '\0')
+		if (!str.empty() && str[str.size() - 1] == '\0')
 			str = str.take(str.size() - 1);
 
+		// an empty string is an empty leaf
+		if (str.empty())
+			return tree_t<RT>{make_leaf_ptr<RT>()};
+
 		tree_t<RT> root;
 
 		// case 1. the str is small enough to just be inserted as a leaf
+		//
+		// note: we fill leaves only up to buf_edit_max_size, so that there's
+		// always room to append an lf when mending a seam
 		while (!str.empty())
 		{
-			size_t candidate_split_idx = std::min(str.size(), RT::buf_size);
+			size_t candidate_split_idx = std::min(str.size(), RT::buf_edit_max_size);
 			auto split_idx = find_split_point(str, candidate_split_idx, split_bias::hard_left);
 
 			auto leaf_text = str.to(split_idx);
@@ -3842,8 +6030,20 @@ namespace atma
 	{}
 
 	template <typename RT>
-	inline basic_rope_t<RT>::basic_rope_t(_rope_::tree_t<RT> const& root_info)
+	inline basic_rope_t<RT>::basic_rope_t(src_bounded_memxfer_t<char const> str, size_t thread_count)
+		: root_{_rope_::build_rope_<RT>(str, thread_count)}
+	{}
+
+	template <typename RT>
+	inline basic_rope_t<RT>::basic_rope_t(rope_mapped_text_ptr const& source, size_t thread_count)
+		: root_{_rope_::build_rope_<RT>(source, thread_count)}
+		, has_mapped_leaves_{true}
+	{}
+
+	template <typename RT>
+	inline basic_rope_t<RT>::basic_rope_t(_rope_::tree_t<RT> const& root_info, bool has_mapped_leaves)
 		: root_(root_info)
+		, has_mapped_leaves_(has_mapped_leaves)
 	{}
 
 	template <typename RT>
@@ -3859,9 +6059,17 @@ namespace atma
 		//  - if we do, make a new rope and splice it into our rope
 		//  - if we don't, chunkify it (even for one chunk), and insert piece-by-piece
 
+		// mapped text is only copied where it's edited
+		if (has_mapped_leaves_)
+			root_ = _rope_::isolate_for_edit_(root_, char_idx, char_idx);
+
 		_rope_::edit_result_t<RT> edit_result;
 		if (sz <= RT::buf_edit_max_size)
 		{
+			// typing into a rope nobody else is sharing doesn't need to allocate
+			if (_rope_::insert_in_place_(root_, char_idx, xfer_src(str, sz)))
+				return;
+
 			edit_result = _rope_::insert(char_idx, root_, xfer_src(str, sz));
 		}
 #if 0
@@ -3944,40 +6152,100 @@ namespace atma
 	template <typename RT>
 	inline auto basic_rope_t<RT>::erase(size_t char_idx, size_t size_in_chars) -> void
 	{
-		// the easiest implementation is to split the tree twice, once at each character location
-		//
-		// but is this the best implementation?
-		auto [left, right] = _rope_::erase(_rope_::tree_t<RT>{root_}, char_idx, size_in_chars);
+		ATMA_ASSERT(char_idx + size_in_chars <= size());
+
+		// mapped text is only copied where it's edited
+		if (has_mapped_leaves_)
+			root_ = _rope_::isolate_for_edit_(root_, char_idx, char_idx + size_in_chars);
 
-		ATMA_ASSERT(left, "erase_result_t must return at least the lhs");
+		if (_rope_::erase_in_place_(root_, char_idx, size_in_chars))
+			return;
 
-		if (right.has_value())
+		auto edit_result = _rope_::erase(root_, char_idx, size_in_chars);
+
+		if (edit_result.right.has_value())
 		{
-			auto info = left.value().info() + right.value().info();
+			auto info = edit_result.left.info() + (*edit_result.right).info();
 
 			auto node = _rope_::make_internal_ptr<RT>(
-				left.value().node().height() + 1,
-				left.value(),
-				right.value());
+				edit_result.left.node().height() + 1,
+				edit_result.left,
+				*edit_result.right);
 
 			root_ = _rope_::tree_t<RT>{info, 2, node};
 		}
 		else
 		{
-			root_ = *left;
+			root_ = edit_result.left;
 		}
 	}
 
 	template <typename RT>
 	inline auto basic_rope_t<RT>::split(size_t char_idx) const -> std::tuple<basic_rope_t<RT>, basic_rope_t<RT>>
 	{
+		ATMA_ASSERT(char_idx <= size());
+
+		// splitting at either end doesn't need to touch the tree
+		if (char_idx == 0)
+			return {basic_rope_t{}, *this};
+		else if (char_idx == size())
+			return {*this, basic_rope_t{}};
+
 		auto [depth, left, right] = _rope_::split<RT>(root_, char_idx);
 
 		return {
-			basic_rope_t{left.value_or(_rope_::tree_t<RT>{_rope_::make_leaf_ptr<RT>()})},
-			basic_rope_t{right.value_or(_rope_::tree_t<RT>{_rope_::make_leaf_ptr<RT>()})}};
+			basic_rope_t{left.value_or(_rope_::tree_t<RT>{_rope_::make_leaf_ptr<RT>()}), has_mapped_leaves_},
+			basic_rope_t{right.value_or(_rope_::tree_t<RT>{_rope_::make_leaf_ptr<RT>()}), has_mapped_leaves_}};
+	}
+
+
+	template <typename RT>
+	inline auto basic_rope_t<RT>::char_idx_of_line(size_t line_idx) const -> size_t
+	{
+		ATMA_ASSERT(line_idx < line_count());
+
+		return _rope_::char_idx_of_line(root_, line_idx);
+	}
+
+	template <typename RT>
+	inline auto basic_rope_t<RT>::line_of_char_idx(size_t char_idx) const -> size_t
+	{
+		ATMA_ASSERT(char_idx <= size());
+
+		return _rope_::line_of_char_idx(root_, char_idx);
+	}
+
+	template <typename RT>
+	inline auto basic_rope_t<RT>::lines(size_t first_line, size_t last_line) const -> basic_rope_line_range_t<RT>
+	{
+		ATMA_ASSERT(first_line <= last_line);
+		ATMA_ASSERT(last_line <= line_count());
+
+		return basic_rope_line_range_t<RT>{
+			basic_rope_line_iterator_t<RT>{*this, first_line},
+			basic_rope_line_iterator_t<RT>{*this, last_line}};
+	}
+
+	template <typename RT>
+	inline auto basic_rope_t<RT>::cursor(size_t char_idx) const -> basic_rope_cursor_t<RT>
+	{
+		return basic_rope_cursor_t<RT>{*this, char_idx};
+	}
+
+	template <typename RT>
+	inline auto basic_rope_t<RT>::append(basic_rope_t<RT> const& rhs) -> void
+	{
+		root_ = _rope_::tree_join_<RT>(root_, rhs.root_);
+		has_mapped_leaves_ = has_mapped_leaves_ || rhs.has_mapped_leaves_;
 	}
 
+	template <typename RT>
+	inline auto operator + (basic_rope_t<RT> const& lhs, basic_rope_t<RT> const& rhs) -> basic_rope_t<RT>
+	{
+		auto result = lhs;
+		result.append(rhs);
+		return result;
+	}
 
 	template <typename RT>
 	template <typename F>
@@ -3999,49 +6267,9 @@ namespace atma
 		if (static_cast<_rope_::tree_t<RT> const&>(lhs.root()).size_bytes() != static_cast<_rope_::tree_t<RT> const&>(rhs.root()).size_bytes())
 			return false;
 
-		_rope_::basic_leaf_iterator_t<RT> lhs_leaf_iter{ lhs };
-		_rope_::basic_leaf_iterator_t<RT> rhs_leaf_iter{ rhs };
-		_rope_::basic_leaf_iterator_t<RT> sentinel;
-
-		// loop through leaves for both ropes
-		size_t lhs_offset = 0;
-		size_t rhs_offset = 0;
-		while (lhs_leaf_iter != sentinel && rhs_leaf_iter != sentinel)
-		{
-			auto lhsd = lhs_leaf_iter->data().from(lhs_offset);
-			auto rhsd = rhs_leaf_iter->data().from(rhs_offset);
-
-			if (auto r = memory_compare(lhsd, rhsd); r == 0)
-			{
-				// memory contents compared completely, keep going
-				++lhs_leaf_iter;
-				++rhs_leaf_iter;
-				lhs_offset = rhs_offset = 0;
-			}
-			else if (r == std::size(rhsd))
-			{
-				// memory contents compared equally, but rhs ran out of characters
-				++rhs_leaf_iter;
-				lhs_offset = r;
-				rhs_offset = 0;
-			}
-			else if (-r == std::size(lhsd))
-			{
-				// memory contents compared equally, but lhs ran out of characters
-				++lhs_leaf_iter;
-				lhs_offset = 0;
-				rhs_offset = -r;
-			}
-			else
-			{
-				// did not compare equally
-				return false;
-			}
-		}
-
-		// exhausted leaves to compare (all tested equal), so if we exhausted
-		// both ropes equally, then they were completely equal
-		return (lhs_leaf_iter == sentinel && rhs_leaf_iter == sentinel);
+		// subtrees the ropes share, or that have both been hashed, don't
+		// need their text compared, wherever they are in either tree
+		return _rope_::trees_equal_<RT>(lhs.root(), rhs.root());
 	}
 
 	template <typename RT>
@@ -4104,9 +6332,9 @@ namespace atma
 	{
 		using namespace _rope_;
 
-		std::tie(leaf_, leaf_characters_) = navigate_to_front_leaf<RT>(rope.root(), [](tree_leaf_t<RT> const& leaf, size_t)
+		std::tie(leaf_, leaf_data_, leaf_characters_) = navigate_to_front_leaf<RT>(rope.root(), [](tree_leaf_t<RT> const& leaf, size_t)
 			{
-				return std::make_tuple(atma::intrusive_ptr_cast<node_leaf_t<RT>>(leaf.node_pointer()), leaf.info().characters);
+				return std::make_tuple(atma::intrusive_ptr_cast<node_leaf_t<RT>>(leaf.node_pointer()), leaf.data().data(), leaf.info().characters);
 			});
 	}
 
@@ -4115,6 +6343,7 @@ namespace atma
 	{
 		using namespace _rope_;
 
+		rel_byte_idx_ += utf8_char_t{leaf_data_ + rel_byte_idx_}.size_bytes();
 		++idx_;
 		++rel_idx_;
 
@@ -4124,14 +6353,15 @@ namespace atma
 		if (rel_idx_ == leaf_characters_)
 		{
 			// exceeded this leaf, time to move to next leaf
-			std::tie(leaf_, leaf_characters_) = navigate_to_leaf<RT>(tree_t<RT>{rope_.root()}, idx_,
+			std::tie(leaf_, leaf_data_, leaf_characters_) = navigate_to_leaf<RT>(tree_t<RT>{rope_.root()}, idx_,
 				tree_find_for_char_idx<RT>,
 				[](tree_leaf_t<RT> const& leaf, size_t)
 				{
-					return std::make_tuple(atma::intrusive_ptr_cast<node_leaf_t<RT>>(leaf.node_pointer()), leaf.info().characters);
+					return std::make_tuple(atma::intrusive_ptr_cast<node_leaf_t<RT>>(leaf.node_pointer()), leaf.data().data(), leaf.info().characters);
 				});
 
 			rel_idx_ = 0;
+			rel_byte_idx_ = 0;
 		}
 
 		return *this;
@@ -4140,7 +6370,7 @@ namespace atma
 	template <typename RT>
 	inline auto basic_rope_char_iterator_t<RT>::operator *() -> utf8_char_t
 	{
-		return utf8_char_t{leaf_->buf.data() + rel_idx_};
+		return utf8_char_t{leaf_data_ + rel_byte_idx_};
 	}
 }
 
@@ -4148,6 +6378,65 @@ namespace atma
 
 
 
+namespace atma
+{
+	template <typename RT>
+	inline basic_rope_line_iterator_t<RT>::basic_rope_line_iterator_t(basic_rope_t<RT> const& rope, size_t line_idx)
+		: rope_(&rope)
+		, line_{line_idx}
+	{
+		// the one-past-the-end line has no extents
+		if (line_idx < rope.line_count())
+		{
+			line_.char_idx = rope.char_idx_of_line(line_idx);
+			calculate_line_end_();
+		}
+	}
+
+	template <typename RT>
+	inline auto basic_rope_line_iterator_t<RT>::operator ++() -> basic_rope_line_iterator_t<RT>&
+	{
+		++line_.line_idx;
+		line_.char_idx += line_.characters;
+		line_.characters = 0;
+
+		if (line_.line_idx < rope_->line_count())
+			calculate_line_end_();
+
+		return *this;
+	}
+
+	template <typename RT>
+	inline auto basic_rope_line_iterator_t<RT>::operator *() const -> rope_line_t const&
+	{
+		return line_;
+	}
+
+	template <typename RT>
+	inline auto basic_rope_line_iterator_t<RT>::operator ->() const -> rope_line_t const*
+	{
+		return &line_;
+	}
+
+	template <typename RT>
+	inline auto basic_rope_line_iterator_t<RT>::calculate_line_end_() -> void
+	{
+		size_t const next_line_idx = line_.line_idx + 1;
+
+		size_t const end_char_idx = (next_line_idx < rope_->line_count())
+			? rope_->char_idx_of_line(next_line_idx)
+			: rope_->size();
+
+		line_.characters = end_char_idx - line_.char_idx;
+	}
+
+	template <typename RT>
+	inline auto operator == (basic_rope_line_iterator_t<RT> const& lhs, basic_rope_line_iterator_t<RT> const& rhs) -> bool
+	{
+		return lhs.rope_ == rhs.rope_ && lhs.line_.line_idx == rhs.line_.line_idx;
+	}
+}
+
 namespace atma::_rope_
 {
 	template <typename RT>
@@ -4225,5 +6514,2239 @@ namespace atma::_rope_
 
 
 
+//---------------------------------------------------------------------
+//
+//  IMPLEMENTATION :: leaf_cursor_t
+//
+//---------------------------------------------------------------------
+namespace atma::_rope_
+{
+	template <typename RT>
+	inline leaf_cursor_t<RT>::leaf_cursor_t(tree_t<RT> const& root, size_t char_idx)
+	{
+		ATMA_ASSERT(char_idx <= root.info().characters);
+
+		tree_t<RT> const* x = &root;
+		while (x->is_branch())
+		{
+			auto const& branch = x->as_branch();
+			auto const children = branch.children();
+
+			// the last child also takes the one-past-the-end index
+			size_t child_idx = 0;
+			while (child_idx + 1 < children.size() && char_idx >= children[child_idx].info().characters)
+			{
+				char_idx -= children[child_idx].info().characters;
+				char_idx_ += children[child_idx].info().characters;
+				++child_idx;
+			}
+
+			ATMA_ASSERT(path_size_ != max_height);
+			path_[path_size_++] = {&branch, child_idx};
+			x = &children[child_idx];
+		}
+
+		leaf_ = x;
+	}
+
+	template <typename RT>
+	inline auto leaf_cursor_t<RT>::leaf() const -> tree_leaf_t<RT> const&
+	{
+		return leaf_->as_leaf();
+	}
+
+	template <typename RT>
+	inline auto leaf_cursor_t<RT>::data() const -> src_buf_t
+	{
+		return leaf_->as_leaf().data();
+	}
+
+	template <typename RT>
+	inline auto leaf_cursor_t<RT>::next() -> bool
+	{
+		// climb to the nearest ancestor that has a following child
+		for (size_t depth = path_size_; depth-- != 0; )
+		{
+			auto& [branch, child_idx] = path_[depth];
+			if (child_idx + 1 == branch->children().size())
+				continue;
+
+			char_idx_ += leaf_->info().characters;
+			path_size_ = depth + 1;
+			++child_idx;
+			descend_front_(&branch->children()[child_idx]);
+			return true;
+		}
+
+		return false;
+	}
+
+	template <typename RT>
+	inline auto leaf_cursor_t<RT>::prev() -> bool
+	{
+		for (size_t depth = path_size_; depth-- != 0; )
+		{
+			auto& [branch, child_idx] = path_[depth];
+			if (child_idx == 0)
+				continue;
+
+			path_size_ = depth + 1;
+			--child_idx;
+			descend_back_(&branch->children()[child_idx]);
+			char_idx_ -= leaf_->info().characters;
+			return true;
+		}
+
+		return false;
+	}
+
+	template <typename RT>
+	inline auto leaf_cursor_t<RT>::descend_front_(tree_t<RT> const* x) -> void
+	{
+		while (x->is_branch())
+		{
+			ATMA_ASSERT(path_size_ != max_height);
+			path_[path_size_++] = {&x->as_branch(), 0};
+			x = &x->as_branch().children().front();
+		}
+
+		leaf_ = x;
+	}
+
+	template <typename RT>
+	inline auto leaf_cursor_t<RT>::descend_back_(tree_t<RT> const* x) -> void
+	{
+		while (x->is_branch())
+		{
+			size_t const child_idx = x->as_branch().children().size() - 1;
+
+			ATMA_ASSERT(path_size_ != max_height);
+			path_[path_size_++] = {&x->as_branch(), child_idx};
+			x = &x->as_branch().children()[child_idx];
+		}
+
+		leaf_ = x;
+	}
+}
+
+
+
+
+//---------------------------------------------------------------------
+//
+//  IMPLEMENTATION :: basic_rope_cursor_t
+//
+//---------------------------------------------------------------------
+namespace atma
+{
+	template <typename RT>
+	inline basic_rope_cursor_t<RT>::basic_rope_cursor_t(basic_rope_t<RT> const& rope, size_t char_idx)
+		: rope_(&rope)
+		, leaf_cursor_(rope.root(), char_idx)
+	{
+		seek(char_idx);
+	}
+
+	template <typename RT>
+	inline auto basic_rope_cursor_t<RT>::operator *() const -> utf8_char_t
+	{
+		ATMA_ASSERT(!at_end());
+		return utf8_char_t{leaf_cursor_.data().data() + rel_byte_idx_};
+	}
+
+	template <typename RT>
+	inline auto basic_rope_cursor_t<RT>::leaf_span() const -> std::span<char const>
+	{
+		auto const data = leaf_cursor_.data();
+		return {data.data(), data.size()};
+	}
+
+	template <typename RT>
+	inline auto basic_rope_cursor_t<RT>::next_char() -> bool
+	{
+		if (at_end())
+			return false;
+
+		rel_byte_idx_ += utf8_char_size_bytes(leaf_cursor_.data().data() + rel_byte_idx_);
+		++rel_idx_;
+
+		// only the last leaf may be left with the cursor at its end
+		if (rel_idx_ == leaf_characters_() && leaf_cursor_.next())
+			rel_idx_ = rel_byte_idx_ = 0;
+
+		return true;
+	}
+
+	template <typename RT>
+	inline auto basic_rope_cursor_t<RT>::prev_char() -> bool
+	{
+		if (rel_idx_ == 0)
+		{
+			if (!leaf_cursor_.prev())
+				return false;
+
+			rel_idx_ = leaf_characters_();
+			rel_byte_idx_ = leaf_cursor_.data().size();
+		}
+
+		char const* const data = leaf_cursor_.data().data();
+		while (!utf8_byte_is_leading(byte(data[--rel_byte_idx_])))
+			;
+		--rel_idx_;
+
+		return true;
+	}
+
+	template <typename RT>
+	inline auto basic_rope_cursor_t<RT>::next_leaf() -> bool
+	{
+		if (at_end())
+			return false;
+
+		if (leaf_cursor_.next())
+		{
+			rel_idx_ = rel_byte_idx_ = 0;
+		}
+		else
+		{
+			rel_idx_ = leaf_characters_();
+			rel_byte_idx_ = leaf_cursor_.data().size();
+		}
+
+		return true;
+	}
+
+	template <typename RT>
+	inline auto basic_rope_cursor_t<RT>::prev_leaf() -> bool
+	{
+		// mirroring next_leaf, the one-past-the-end position steps
+		// back to the front of the last leaf
+		if (at_end() && rel_idx_ != 0)
+		{
+			rel_idx_ = rel_byte_idx_ = 0;
+			return true;
+		}
+
+		if (!leaf_cursor_.prev())
+			return false;
+
+		rel_idx_ = rel_byte_idx_ = 0;
+		return true;
+	}
+
+	template <typename RT>
+	inline auto basic_rope_cursor_t<RT>::seek(size_t char_idx) -> void
+	{
+		ATMA_ASSERT(char_idx <= rope_->size());
+
+		// seeking within the current leaf needs no descent
+		size_t const front = leaf_cursor_.char_idx();
+		if (char_idx < front || front + leaf_characters_() <= char_idx)
+		{
+			leaf_cursor_ = _rope_::leaf_cursor_t<RT>{rope_->root(), char_idx};
+		}
+
+		rel_idx_ = char_idx - leaf_cursor_.char_idx();
+		rel_byte_idx_ = 0;
+		if (rel_idx_ != 0)
+		{
+			rel_byte_idx_ = utf8_charseq_idx_to_byte_idx(leaf_cursor_.data().data(), leaf_cursor_.data().size(), rel_idx_);
+		}
+	}
+}
+
+
+
+//---------------------------------------------------------------------
+//
+//  IMPLEMENTATION :: search
+//
+//---------------------------------------------------------------------
+namespace atma::_rope_
+{
+	inline auto find_in_chunk_(src_buf_t str, size_t from, std::string_view needle) -> size_t
+	{
+		size_t const n = needle.size();
+		ATMA_ASSERT(n != 0);
+
+		if (str.size() < n)
+			return search_npos;
+
+		char const* const data = str.data();
+		size_t const last = str.size() - n;
+
+		auto matches_at = [&](size_t p) { return memcmp(data + p + 1, needle.data() + 1, n - 1) == 0; };
+
+		size_t p = from;
+
+#if ATMA_ROPE_SIMD_X64
+		// sse2 is part of x64, so this needs no runtime check
+		__m128i const front = _mm_set1_epi8(needle.front());
+		__m128i const back = _mm_set1_epi8(needle.back());
+
+		for ( ; p + 16 <= last + 1; p += 16)
+		{
+			__m128i const block_front = _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + p));
+			__m128i const block_back = _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + p + n - 1));
+
+			auto candidates = (uint32_t)_mm_movemask_epi8(
+				_mm_and_si128(_mm_cmpeq_epi8(block_front, front), _mm_cmpeq_epi8(block_back, back)));
+
+			for ( ; candidates != 0; candidates &= candidates - 1)
+			{
+				size_t const candidate = p + std::countr_zero(candidates);
+				if (matches_at(candidate))
+					return candidate;
+			}
+		}
+#endif
+
+		for ( ; p <= last; ++p)
+		{
+			if (data[p] == needle.front() && data[p + n - 1] == needle.back() && matches_at(p))
+				return p;
+		}
+
+		return search_npos;
+	}
+
+	inline auto rfind_in_chunk_(src_buf_t str, size_t last, std::string_view needle) -> size_t
+	{
+		size_t const n = needle.size();
+		ATMA_ASSERT(n != 0);
+		ATMA_ASSERT(last + n <= str.size());
+
+		char const* const data = str.data();
+
+		auto matches_at = [&](size_t p) { return memcmp(data + p + 1, needle.data() + 1, n - 1) == 0; };
+
+		// candidates are [0, end)
+		size_t end = last + 1;
+
+#if ATMA_ROPE_SIMD_X64
+		__m128i const front = _mm_set1_epi8(needle.front());
+		__m128i const back = _mm_set1_epi8(needle.back());
+
+		for ( ; end >= 16; end -= 16)
+		{
+			size_t const p = end - 16;
+
+			__m128i const block_front = _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + p));
+			__m128i const block_back = _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + p + n - 1));
+
+			auto candidates = (uint32_t)_mm_movemask_epi8(
+				_mm_and_si128(_mm_cmpeq_epi8(block_front, front), _mm_cmpeq_epi8(block_back, back)));
 
+			while (candidates != 0)
+			{
+				int const bit = 31 - std::countl_zero(candidates);
+				if (matches_at(p + bit))
+					return p + bit;
 
+				candidates &= ~(1u << bit);
+			}
+		}
+#endif
+
+		while (end-- != 0)
+		{
+			if (data[end] == needle.front() && data[end + n - 1] == needle.back() && matches_at(end))
+				return end;
+		}
+
+		return search_npos;
+	}
+
+	template <typename RT>
+	inline auto matches_across_leaves_(leaf_cursor_t<RT> cursor, size_t byte_idx, std::string_view needle) -> bool
+	{
+		auto data = cursor.data().from(byte_idx);
+
+		for (;;)
+		{
+			size_t const size = std::min(data.size(), needle.size());
+			if (memcmp(data.data(), needle.data(), size) != 0)
+				return false;
+
+			needle.remove_prefix(size);
+			if (needle.empty())
+				return true;
+			else if (!cursor.next())
+				return false;
+
+			data = cursor.data();
+		}
+	}
+
+	template <typename RT>
+	inline auto find(tree_t<RT> const& tree, std::string_view needle, size_t char_idx) -> size_t
+	{
+		if (char_idx > tree.info().characters)
+			return search_npos;
+		else if (needle.empty())
+			return char_idx;
+
+		leaf_cursor_t<RT> cursor{tree, char_idx};
+
+		auto char_idx_of = [&cursor](size_t byte_idx)
+			{ return cursor.char_idx() + text_info_t::from_str(cursor.data().data(), byte_idx).characters; };
+
+		size_t byte_idx = utf8_charseq_idx_to_byte_idx(cursor.data().data(), cursor.data().size(), char_idx - cursor.char_idx());
+
+		for (;;)
+		{
+			auto const data = cursor.data();
+
+			// matches wholly within this leaf come first
+			if (size_t const r = find_in_chunk_(data, byte_idx, needle); r != search_npos)
+				return char_idx_of(r);
+
+			// then those that start near the back and run into the following leaves
+			size_t const straddle_begin = (data.size() < needle.size()) ? 0 : data.size() - needle.size() + 1;
+			for (size_t p = std::max(byte_idx, straddle_begin); p < data.size(); ++p)
+			{
+				if (data[p] == needle.front() && matches_across_leaves_(cursor, p, needle))
+					return char_idx_of(p);
+			}
+
+			if (!cursor.next())
+				return search_npos;
+
+			byte_idx = 0;
+		}
+	}
+
+	template <typename RT>
+	inline auto rfind(tree_t<RT> const& tree, std::string_view needle, size_t char_idx) -> size_t
+	{
+		size_t const needle_characters = leaf_text_info_count_chars_(needle);
+		if (needle_characters > tree.info().characters)
+			return search_npos;
+
+		char_idx = std::min(char_idx, tree.info().characters - needle_characters);
+		if (needle.empty())
+			return char_idx;
+
+		leaf_cursor_t<RT> cursor{tree, char_idx};
+
+		auto char_idx_of = [&cursor](size_t byte_idx)
+			{ return cursor.char_idx() + text_info_t::from_str(cursor.data().data(), byte_idx).characters; };
+
+		// the last byte-idx a match may begin at
+		size_t last = utf8_charseq_idx_to_byte_idx(cursor.data().data(), cursor.data().size(), char_idx - cursor.char_idx());
+
+		for (;;)
+		{
+			auto const data = cursor.data();
+
+			// matches running into the following leaves are the furthest back
+			size_t const straddle_begin = (data.size() < needle.size()) ? 0 : data.size() - needle.size() + 1;
+			for (size_t p = std::min(last + 1, data.size()); p-- > straddle_begin; )
+			{
+				if (data[p] == needle.front() && matches_across_leaves_(cursor, p, needle))
+					return char_idx_of(p);
+			}
+
+			if (data.size() >= needle.size())
+			{
+				if (size_t const r = rfind_in_chunk_(data, std::min(last, data.size() - needle.size()), needle); r != search_npos)
+					return char_idx_of(r);
+			}
+
+			if (!cursor.prev())
+				return search_npos;
+
+			last = cursor.data().size();
+		}
+	}
+}
+
+namespace atma
+{
+	template <typename RT>
+	inline auto basic_rope_t<RT>::find(std::string_view str, size_t char_idx) const -> size_t
+	{
+		return _rope_::find(root_, str, char_idx);
+	}
+
+	template <typename RT>
+	inline auto basic_rope_t<RT>::rfind(std::string_view str, size_t char_idx) const -> size_t
+	{
+		return _rope_::rfind(root_, str, char_idx);
+	}
+
+	template <typename RT>
+	inline auto basic_rope_t<RT>::find_all(std::string_view str) const -> basic_rope_match_range_t<RT>
+	{
+		return basic_rope_match_range_t<RT>{
+			basic_rope_match_iterator_t<RT>{*this, str},
+			basic_rope_match_iterator_t<RT>{}};
+	}
+
+	template <typename RT>
+	inline basic_rope_match_iterator_t<RT>::basic_rope_match_iterator_t(basic_rope_t<RT> const& rope, std::string_view str)
+		: rope_(&rope)
+		, str_(str)
+	{
+		if (!str_.empty())
+		{
+			match_.characters = _rope_::leaf_text_info_count_chars_(str_);
+			match_.char_idx = rope.find(str_, 0);
+		}
+	}
+
+	template <typename RT>
+	inline auto basic_rope_match_iterator_t<RT>::operator ++() -> basic_rope_match_iterator_t<RT>&
+	{
+		ATMA_ASSERT(match_.char_idx != basic_rope_t<RT>::npos);
+
+		match_.char_idx = rope_->find(str_, match_.char_idx + match_.characters);
+		return *this;
+	}
+
+	template <typename RT>
+	inline auto basic_rope_match_iterator_t<RT>::operator *() const -> rope_match_t const&
+	{
+		return match_;
+	}
+
+	template <typename RT>
+	inline auto basic_rope_match_iterator_t<RT>::operator ->() const -> rope_match_t const*
+	{
+		return &match_;
+	}
+
+	// all exhausted iterators are equal, so a default-constructed one is the end
+	template <typename RT>
+	inline auto operator == (basic_rope_match_iterator_t<RT> const& lhs, basic_rope_match_iterator_t<RT> const& rhs) -> bool
+	{
+		return lhs.match_.char_idx == rhs.match_.char_idx
+			&& (lhs.match_.char_idx == basic_rope_t<RT>::npos || lhs.rope_ == rhs.rope_);
+	}
+}
+
+
+
+//---------------------------------------------------------------------
+//
+//  IMPLEMENTATION :: hashing
+//
+//---------------------------------------------------------------------
+namespace atma::_rope_
+{
+	inline auto hash_mul_(uint64_t lhs, uint64_t rhs) -> uint64_t
+	{
+		// the 122-bit product is built from 32-bit halves, and folded
+		// back down knowing that 2^61 = 1 (mod 2^61-1)
+		uint64_t const lhs_lo = lhs & 0xffffffff, lhs_hi = lhs >> 32;
+		uint64_t const rhs_lo = rhs & 0xffffffff, rhs_hi = rhs >> 32;
+
+		uint64_t const lo = lhs_lo * rhs_lo;
+		uint64_t const mid = lhs_lo * rhs_hi + lhs_hi * rhs_lo;
+		uint64_t const hi = lhs_hi * rhs_hi;
+
+		uint64_t r = (lo & hash_modulus) + (lo >> 61) + (hi << 3) + (mid >> 29) + ((mid << 35) >> 3) + 1;
+		r = (r & hash_modulus) + (r >> 61);
+		r = (r & hash_modulus) + (r >> 61);
+		return r - 1;
+	}
+
+	inline auto hash_pow_(size_t exponent) -> uint64_t
+	{
+		uint64_t result = 1;
+		for (uint64_t x = hash_base; exponent != 0; exponent >>= 1, x = hash_mul_(x, x))
+		{
+			if (exponent & 1)
+				result = hash_mul_(result, x);
+		}
+
+		return result;
+	}
+
+	inline auto hash_text_(char const* str, size_t size) -> uint64_t
+	{
+		// bytes are offset by one so that leading nulls aren't invisible
+		uint64_t result = 0;
+		for (size_t i = 0; i != size; ++i)
+		{
+			result = hash_mul_(result, hash_base) + uint8_t(str[i]) + 1;
+			result = (result >= hash_modulus) ? result - hash_modulus : result;
+		}
+
+		return result;
+	}
+
+	inline auto hash_concat_(uint64_t lhs, uint64_t rhs, size_t rhs_bytes) -> uint64_t
+	{
+		uint64_t const result = hash_mul_(lhs, hash_pow_(rhs_bytes)) + rhs;
+		return (result >= hash_modulus) ? result - hash_modulus : result;
+	}
+
+	// a leaf's view is its byte-range within its text, and a branch's
+	// view is however many children it addresses. mapped leaves are big
+	// enough that a byte-range takes all 64 bits
+	template <typename RT>
+	inline auto hash_view_key_(tree_t<RT> const& tree) -> uint64_t
+	{
+		return tree.is_leaf()
+			? (uint64_t(tree.info().dropped_bytes) << 32) | tree.info().bytes
+			: tree.child_count();
+	}
+
+	template <typename RT>
+	inline auto hash_cache_of_(tree_t<RT> const& tree) -> node_hash_cache_t const&
+	{
+		return tree.is_leaf()
+			? tree.node().as_leaf().hash_cache
+			: tree.node().as_branch().hash_cache;
+	}
+
+	template <typename RT>
+	inline auto tree_hash_(tree_t<RT> const& tree) -> uint64_t
+	{
+		if (tree.size_bytes() == 0)
+			return 0;
+
+		auto const& cache = hash_cache_of_(tree);
+		uint64_t const view = hash_view_key_(tree);
+
+		if (auto hash = cache.get(view))
+			return *hash;
+
+		uint64_t result = 0;
+		if (tree.is_leaf())
+		{
+			auto const data = tree.as_leaf().data();
+			result = hash_text_(data.data(), data.size());
+		}
+		else
+		{
+			for (auto const& child : tree.children())
+				result = hash_concat_(result, tree_hash_(child), child.size_bytes());
+		}
+
+		cache.set(view, result);
+		return result;
+	}
+
+	template <typename RT>
+	inline auto tree_cached_hash_(tree_t<RT> const& tree) -> std::optional<uint64_t>
+	{
+		if (tree.size_bytes() == 0)
+			return 0;
+
+		return hash_cache_of_(tree).get(hash_view_key_(tree));
+	}
+
+	template <typename RT>
+	inline auto subtrees_known_equal_(tree_t<RT> const& lhs, tree_t<RT> const& rhs) -> bool
+	{
+		if (lhs == rhs)
+			return true;
+
+		if (lhs.size_bytes() != rhs.size_bytes())
+			return false;
+
+		auto const lhs_hash = tree_cached_hash_(lhs);
+		auto const rhs_hash = tree_cached_hash_(rhs);
+		return lhs_hash && rhs_hash && *lhs_hash == *rhs_hash;
+	}
+}
+
+namespace atma
+{
+	template <typename RT>
+	inline auto basic_rope_t<RT>::hash() const -> uint64_t
+	{
+		return _rope_::tree_hash_(root_);
+	}
+}
+
+
+
+//---------------------------------------------------------------------
+//
+//  IMPLEMENTATION :: summaries
+//
+//---------------------------------------------------------------------
+namespace atma::_rope_
+{
+	template <typename RT>
+	inline auto summary_cache_of_(tree_t<RT> const& tree) -> node_summary_cache_t<RT> const&
+	{
+		return tree.is_leaf()
+			? tree.node().as_leaf().summary_cache
+			: tree.node().as_branch().summary_cache;
+	}
+
+	template <typename RT>
+	inline auto tree_summary_(tree_t<RT> const& tree) -> typename RT::summary_type
+	{
+		using summary_type = typename RT::summary_type;
+
+		if (tree.size_bytes() == 0)
+			return summary_type{};
+
+		// summaries share their views with hashes
+		auto const& cache = summary_cache_of_(tree);
+		uint64_t const view = hash_view_key_(tree);
+
+		if (auto summary = cache.get(view))
+			return *summary;
+
+		summary_type result{};
+		if (tree.is_leaf())
+		{
+			auto const data = tree.as_leaf().data();
+			result = summary_type::from_str(data.data(), data.size());
+		}
+		else
+		{
+			for (auto const& child : tree.children())
+				result = result + tree_summary_(child);
+		}
+
+		cache.set(view, result);
+		return result;
+	}
+
+	template <typename RT>
+	inline auto tree_summary_before_(tree_t<RT> const& tree, size_t char_idx) -> typename RT::summary_type
+	{
+		using summary_type = typename RT::summary_type;
+
+		ATMA_ASSERT(char_idx <= tree.size_chars());
+
+		summary_type result{};
+		tree_t<RT> const* x = &tree;
+		while (!x->is_leaf())
+		{
+			tree_t<RT> const* next = nullptr;
+			for (auto const& child : x->children())
+			{
+				if (char_idx < child.size_chars())
+				{
+					next = &child;
+					break;
+				}
+
+				char_idx -= child.size_chars();
+				result = result + tree_summary_(child);
+			}
+
+			// char_idx is the very end of the text
+			if (next == nullptr)
+				return result;
+
+			x = next;
+		}
+
+		// summarise whichever side of char_idx is shorter. the whole leaf's
+		// summary is (most likely) cached
+		auto const data = x->as_leaf().data();
+		size_t const byte_idx = utf8_charseq_idx_to_byte_idx(data.data(), data.size(), char_idx);
+		if (byte_idx <= data.size() / 2)
+			return result + summary_type::from_str(data.data(), byte_idx);
+		else
+			return result + (tree_summary_(*x) - summary_type::from_str(data.data() + byte_idx, data.size() - byte_idx));
+	}
+
+	template <typename RT, typename Metric>
+	inline auto tree_find_for_metric_(tree_t<RT> const& x, Metric&& metric, size_t value, typename RT::summary_type& summary) -> std::tuple<size_t, size_t>
+	{
+		size_t child_idx = 0;
+		size_t acc_chars = 0;
+		for (auto const& child : x.children())
+		{
+			auto const including = summary + tree_summary_(child);
+			if (value < size_t(std::invoke(metric, including)))
+				break;
+
+			summary = including;
+			acc_chars += child.size_chars();
+			++child_idx;
+		}
+
+		return std::make_tuple(child_idx, acc_chars);
+	}
+
+	template <typename RT, typename Metric>
+	inline auto tree_char_idx_of_metric_(tree_t<RT> const& tree, Metric&& metric, size_t value) -> size_t
+	{
+		using summary_type = typename RT::summary_type;
+
+		// whole subtrees are skipped while the summary that includes them
+		// hasn't gone past value, and so for characters within the leaf
+		summary_type result{};
+		size_t char_idx = 0;
+
+		tree_t<RT> const* x = &tree;
+		while (!x->is_leaf())
+		{
+			auto const [child_idx, chars_before] = tree_find_for_metric_(*x, metric, value, result);
+			char_idx += chars_before;
+
+			if (child_idx == x->child_count())
+				return char_idx;
+
+			x = &x->children()[child_idx];
+		}
+
+		// characters are counted by code-point, so a crlf is two of them
+		auto const data = x->as_leaf().data();
+		for (size_t byte_idx = 0; byte_idx != data.size(); ++char_idx)
+		{
+			size_t const next_byte_idx = byte_idx + utf8_char_size_bytes(data.data() + byte_idx);
+
+			result = result + summary_type::from_str(data.data() + byte_idx, next_byte_idx - byte_idx);
+			if (value < size_t(std::invoke(metric, result)))
+				break;
+
+			byte_idx = next_byte_idx;
+		}
+
+		return char_idx;
+	}
+}
+
+namespace atma
+{
+	template <typename RT>
+	inline auto basic_rope_t<RT>::summary() const -> summary_type
+	{
+		return _rope_::tree_summary_(root_);
+	}
+
+	template <typename RT>
+	inline auto basic_rope_t<RT>::summary_before(size_t char_idx) const -> summary_type
+	{
+		ATMA_ASSERT(char_idx <= size());
+
+		return _rope_::tree_summary_before_(root_, char_idx);
+	}
+
+	template <typename RT>
+	template <typename Metric>
+	inline auto basic_rope_t<RT>::char_idx_of_metric(Metric&& metric, size_t value) const -> size_t
+	{
+		return _rope_::tree_char_idx_of_metric_(root_, std::forward<Metric>(metric), value);
+	}
+}
+
+
+
+//---------------------------------------------------------------------
+//
+//  IMPLEMENTATION :: diff
+//
+//---------------------------------------------------------------------
+namespace atma::_rope_
+{
+	template <typename RT>
+	inline auto collect_diff_spans_(diff_spans_t<RT>& spans, tree_t<RT> const& tree, size_t char_idx, size_t begin, size_t end) -> void
+	{
+		ATMA_ASSERT(begin <= end && end <= tree.size_chars());
+
+		if (begin == end)
+			return;
+
+		if (begin == 0 && end == tree.size_chars())
+		{
+			spans.push_back({&tree, char_idx, 0, tree.size_bytes()});
+		}
+		else if (tree.is_leaf())
+		{
+			auto const data = tree.as_leaf().data();
+			spans.push_back({&tree, char_idx + begin,
+				utf8_charseq_idx_to_byte_idx(data.data(), data.size(), begin),
+				utf8_charseq_idx_to_byte_idx(data.data(), data.size(), end)});
+		}
+		else
+		{
+			size_t child_front = 0;
+			for (auto const& child : tree.children())
+			{
+				size_t const child_back = child_front + child.size_chars();
+				if (begin < child_back && child_front < end)
+				{
+					collect_diff_spans_(spans, child, char_idx + child_front,
+						std::max(begin, child_front) - child_front,
+						std::min(end, child_back) - child_front);
+				}
+
+				child_front = child_back;
+			}
+		}
+	}
+
+	// replaces a branch's span with its children's, in order
+	template <typename RT>
+	inline auto expand_diff_span_(diff_spans_t<RT>& spans, size_t idx) -> void
+	{
+		auto const x = spans[idx];
+		ATMA_ASSERT(x.tree->is_branch());
+
+		auto const children = x.tree->children();
+		spans.erase(spans.begin() + idx);
+
+		size_t char_idx = x.char_idx;
+		for (auto const& child : children)
+		{
+			spans.insert(spans.begin() + idx++, {&child, char_idx, 0, child.size_bytes()});
+			char_idx += child.size_chars();
+		}
+	}
+
+	template <bool FromBack, typename RT>
+	inline auto diff_common_affix_(diff_spans_t<RT> lhs, diff_spans_t<RT> rhs) -> size_t
+	{
+		// the next spans to compare are kept at the back
+		if constexpr (!FromBack)
+		{
+			std::reverse(lhs.begin(), lhs.end());
+			std::reverse(rhs.begin(), rhs.end());
+		}
+
+		auto expand_back = [](diff_spans_t<RT>& spans)
+		{
+			size_t const idx = spans.size() - 1;
+			expand_diff_span_(spans, idx);
+			if constexpr (!FromBack)
+				std::reverse(spans.begin() + idx, spans.end());
+		};
+
+		size_t common = 0;
+		while (!lhs.empty() && !rhs.empty())
+		{
+			auto& x = lhs.back();
+			auto& y = rhs.back();
+
+			if (x.is_whole() && y.is_whole() && subtrees_known_equal_(*x.tree, *y.tree))
+			{
+				common += x.characters();
+				lhs.pop_back();
+				rhs.pop_back();
+				continue;
+			}
+
+			// descend whichever is taller, so that subtrees of the same
+			// height end up facing each other
+			if (x.tree->is_branch() || y.tree->is_branch())
+			{
+				if (x.tree->height() >= y.tree->height())
+					expand_back(lhs);
+				else
+					expand_back(rhs);
+				continue;
+			}
+
+			auto const xs = std::string_view{x.tree->as_leaf().data().data() + x.begin_byte, x.end_byte - x.begin_byte};
+			auto const ys = std::string_view{y.tree->as_leaf().data().data() + y.begin_byte, y.end_byte - y.begin_byte};
+			size_t const n = std::min(xs.size(), ys.size());
+
+			size_t k = 0;
+			if constexpr (FromBack)
+				while (k != n && xs[xs.size() - 1 - k] == ys[ys.size() - 1 - k]) ++k;
+			else
+				while (k != n && xs[k] == ys[k]) ++k;
+
+			if (k != n)
+			{
+				// only whole characters are in common
+				if constexpr (FromBack)
+					while (k != 0 && !utf8_byte_is_leading(byte(xs[xs.size() - k]))) --k;
+				else
+					while (k != 0 && !(utf8_byte_is_leading(byte(xs[k])) && utf8_byte_is_leading(byte(ys[k])))) --k;
+
+				common += leaf_text_info_count_chars_(FromBack ? xs.substr(xs.size() - k) : xs.substr(0, k));
+				break;
+			}
+
+			// the shorter span is used up, and we carry on into the next
+			common += leaf_text_info_count_chars_(FromBack ? xs.substr(xs.size() - k) : xs.substr(0, k));
+
+			if constexpr (FromBack)
+				x.end_byte -= k, y.end_byte -= k;
+			else
+				x.begin_byte += k, y.begin_byte += k;
+
+			if (x.begin_byte == x.end_byte)
+				lhs.pop_back();
+			if (y.begin_byte == y.end_byte)
+				rhs.pop_back();
+		}
+
+		return common;
+	}
+
+	template <typename RT>
+	inline auto trees_equal_(tree_t<RT> const& lhs, tree_t<RT> const& rhs) -> bool
+	{
+		ATMA_ASSERT(lhs.size_bytes() == rhs.size_bytes());
+
+		// the same walk as diff_common_affix_, but the text that isn't
+		// skipped is compared a leaf at a time, and we stop at a difference
+		diff_spans_t<RT> xs{{&lhs, 0, 0, lhs.size_bytes()}};
+		diff_spans_t<RT> ys{{&rhs, 0, 0, rhs.size_bytes()}};
+
+		// the next spans to compare are kept at the back
+		auto expand_back = [](diff_spans_t<RT>& spans)
+		{
+			size_t const idx = spans.size() - 1;
+			expand_diff_span_(spans, idx);
+			std::reverse(spans.begin() + idx, spans.end());
+		};
+
+		while (!xs.empty() && !ys.empty())
+		{
+			auto& x = xs.back();
+			auto& y = ys.back();
+
+			if (x.is_whole() && y.is_whole() && subtrees_known_equal_(*x.tree, *y.tree))
+			{
+				xs.pop_back();
+				ys.pop_back();
+				continue;
+			}
+
+			if (x.tree->is_branch() || y.tree->is_branch())
+			{
+				if (x.tree->height() >= y.tree->height())
+					expand_back(xs);
+				else
+					expand_back(ys);
+				continue;
+			}
+
+			size_t const n = std::min(x.end_byte - x.begin_byte, y.end_byte - y.begin_byte);
+			if (memcmp(x.tree->as_leaf().data().data() + x.begin_byte, y.tree->as_leaf().data().data() + y.begin_byte, n) != 0)
+				return false;
+
+			x.begin_byte += n;
+			y.begin_byte += n;
+
+			// note: this also steps over empty leaves
+			if (x.begin_byte == x.end_byte)
+				xs.pop_back();
+			if (y.begin_byte == y.end_byte)
+				ys.pop_back();
+		}
+
+		// both trees are the same size, so anything left over is empty
+		return true;
+	}
+
+	template <typename RT>
+	inline auto find_diff_anchor_(diff_spans_t<RT> lhs, diff_spans_t<RT> rhs) -> std::optional<diff_anchor_t>
+	{
+		// shared subtrees may sit deeper than the spans covering the range, so
+		// the tallest spans are broken down a level at a time. past a point
+		// the search isn't worth it, and the whole range is reported changed
+		constexpr size_t max_spans = 256;
+
+		for (;;)
+		{
+			std::optional<diff_anchor_t> result;
+			for (auto const& x : lhs)
+			{
+				if (!x.is_whole() || x.characters() == 0 || (result && x.characters() <= result->characters))
+					continue;
+
+				for (auto const& y : rhs)
+				{
+					if (y.is_whole() && subtrees_known_equal_(*x.tree, *y.tree))
+					{
+						result = diff_anchor_t{x.char_idx, y.char_idx, x.characters()};
+						break;
+					}
+				}
+			}
+
+			if (result)
+				return result;
+
+			uint32_t height = 1;
+			for (auto const* spans : {&lhs, &rhs})
+				for (auto const& x : *spans)
+					height = std::max(height, x.tree->height());
+
+			if (height == 1 || lhs.size() + rhs.size() > max_spans)
+				return std::nullopt;
+
+			for (auto* spans : {&lhs, &rhs})
+			{
+				for (size_t i = spans->size(); i-- != 0; )
+				{
+					if ((*spans)[i].tree->height() == height)
+						expand_diff_span_(*spans, i);
+				}
+			}
+		}
+	}
+
+	template <typename RT>
+	inline auto diff_ranges_(std::vector<rope_change_t>& changes,
+		tree_t<RT> const& lhs, size_t lhs_begin, size_t lhs_end,
+		tree_t<RT> const& rhs, size_t rhs_begin, size_t rhs_end) -> void
+	{
+		auto spans_of = [](tree_t<RT> const& tree, size_t begin, size_t end)
+		{
+			diff_spans_t<RT> result;
+			collect_diff_spans_(result, tree, 0, begin, end);
+			return result;
+		};
+
+		size_t const prefix = diff_common_affix_<false>(spans_of(lhs, lhs_begin, lhs_end), spans_of(rhs, rhs_begin, rhs_end));
+		lhs_begin += prefix;
+		rhs_begin += prefix;
+
+		size_t const suffix = diff_common_affix_<true>(spans_of(lhs, lhs_begin, lhs_end), spans_of(rhs, rhs_begin, rhs_end));
+		lhs_end -= suffix;
+		rhs_end -= suffix;
+
+		if (lhs_begin == lhs_end && rhs_begin == rhs_end)
+			return;
+
+		if (auto anchor = find_diff_anchor_<RT>(spans_of(lhs, lhs_begin, lhs_end), spans_of(rhs, rhs_begin, rhs_end)))
+		{
+			diff_ranges_(changes,
+				lhs, lhs_begin, anchor->lhs_char_idx,
+				rhs, rhs_begin, anchor->rhs_char_idx);
+
+			diff_ranges_(changes,
+				lhs, anchor->lhs_char_idx + anchor->characters, lhs_end,
+				rhs, anchor->rhs_char_idx + anchor->characters, rhs_end);
+		}
+		else
+		{
+			changes.push_back({lhs_begin, lhs_end - lhs_begin, rhs_begin, rhs_end - rhs_begin});
+		}
+	}
+}
+
+namespace atma
+{
+	template <typename RT>
+	inline auto diff(basic_rope_t<RT> const& lhs, basic_rope_t<RT> const& rhs) -> std::vector<rope_change_t>
+	{
+		std::vector<rope_change_t> result;
+		_rope_::diff_ranges_<RT>(result, lhs.root(), 0, lhs.size(), rhs.root(), 0, rhs.size());
+		return result;
+	}
+}
+
+
+
+//---------------------------------------------------------------------
+//
+//  IMPLEMENTATION :: basic_rope_history_t
+//
+//---------------------------------------------------------------------
+namespace atma::_rope_
+{
+	template <typename RT>
+	inline auto node_memory_size_(node_t<RT> const& node) -> size_t
+	{
+		if (node.is_mapped_leaf())
+			return sizeof(node_mapped_leaf_t<RT>);
+		else if (node.is_leaf())
+			return sizeof(node_buffer_leaf_t<RT>);
+		else
+			return sizeof(node_internal_t<RT>);
+	}
+
+	template <typename RT>
+	inline auto uniquely_owned_bytes_(tree_t<RT> const& tree) -> size_t
+	{
+		// our reference is the only one, so the node goes when we do, and
+		// takes every child it holds with it (even ones we don't view)
+		if (ref_counted_traits<node_t<RT>>::use_count(&tree.node()) != 1)
+			return 0;
+
+		size_t result = node_memory_size_(tree.node());
+		for (auto const& child : tree.backing_children())
+			result += uniquely_owned_bytes_(child);
+
+		return result;
+	}
+
+	template <typename RT>
+	inline auto distinct_bytes_(tree_t<RT> const& tree, std::unordered_set<node_t<RT> const*>& visited) -> size_t
+	{
+		if (!visited.insert(&tree.node()).second)
+			return 0;
+
+		size_t result = node_memory_size_(tree.node());
+		for (auto const& child : tree.backing_children())
+			result += distinct_bytes_(child, visited);
+
+		return result;
+	}
+}
+
+namespace atma
+{
+	template <typename RT>
+	inline basic_rope_history_t<RT>::basic_rope_history_t(basic_rope_t<RT> const& initial)
+		: versions_{initial}
+	{}
+
+	template <typename RT>
+	inline auto basic_rope_history_t<RT>::snapshot(basic_rope_t<RT> const& rope) -> void
+	{
+		versions_.erase(versions_.begin() + current_ + 1, versions_.end());
+		versions_.push_back(rope);
+		++current_;
+	}
+
+	template <typename RT>
+	inline auto basic_rope_history_t<RT>::version(size_t idx) const -> basic_rope_t<RT> const&
+	{
+		ATMA_ASSERT(idx < versions_.size());
+		return versions_[idx];
+	}
+
+	template <typename RT>
+	inline auto basic_rope_history_t<RT>::undo() -> bool
+	{
+		if (!can_undo())
+			return false;
+
+		--current_;
+		return true;
+	}
+
+	template <typename RT>
+	inline auto basic_rope_history_t<RT>::redo() -> bool
+	{
+		if (!can_redo())
+			return false;
+
+		++current_;
+		return true;
+	}
+
+	template <typename RT>
+	inline auto basic_rope_history_t<RT>::unique_bytes(size_t idx) const -> size_t
+	{
+		ATMA_ASSERT(idx < versions_.size());
+		return _rope_::uniquely_owned_bytes_<RT>(versions_[idx].root());
+	}
+
+	template <typename RT>
+	inline auto basic_rope_history_t<RT>::memory_usage() const -> size_t
+	{
+		std::unordered_set<_rope_::node_t<RT> const*> visited;
+
+		size_t result = 0;
+		for (auto const& x : versions_)
+			result += _rope_::distinct_bytes_<RT>(x.root(), visited);
+
+		return result;
+	}
+
+	template <typename RT>
+	inline auto basic_rope_history_t<RT>::compact(size_t memory_budget) -> size_t
+	{
+		size_t usage = memory_usage();
+
+		// discarding a version frees exactly its unique bytes. once the second
+		// version is discarded, undoing from the third goes straight to the first
+		size_t discarded = 0;
+		while (usage > memory_budget && 1 + discarded < current_)
+		{
+			usage -= unique_bytes(1 + discarded);
+
+			// releasing now, so that the following version's unique bytes
+			// includes whatever it shared only with this one
+			versions_[1 + discarded] = basic_rope_t<RT>{};
+			++discarded;
+		}
+
+		versions_.erase(versions_.begin() + 1, versions_.begin() + 1 + discarded);
+		current_ -= discarded;
+
+		return usage;
+	}
+}
+
+
+
+//---------------------------------------------------------------------
+//
+//  IMPLEMENTATION :: parallel traversal
+//
+//---------------------------------------------------------------------
+namespace atma::_rope_
+{
+	template <typename RT>
+	inline auto partition_for_tasks_(tree_t<RT> const& tree, size_t task_bytes, std::vector<tree_t<RT>>& tasks) -> void
+	{
+		if (tree.size_bytes() == 0)
+			return;
+
+		if (tree.is_leaf() || tree.size_bytes() <= task_bytes)
+		{
+			tasks.push_back(tree);
+			return;
+		}
+
+		for (auto const& child : tree.children())
+			partition_for_tasks_(child, task_bytes, tasks);
+	}
+
+	template <typename RT>
+	inline auto task_bytes_for_(tree_t<RT> const& tree) -> size_t
+	{
+		// a few tasks per core so that uneven tasks balance out, but not
+		// so many that enqueuing them costs more than it saves
+		constexpr size_t min_bytes_per_task = RT::buf_size * RT::branching_factor * 64;
+		size_t const task_count = std::max<size_t>(std::thread::hardware_concurrency(), 1) * 4;
+
+		return std::max(min_bytes_per_task, tree.size_bytes() / task_count);
+	}
+
+	template <typename WorkProvider>
+	inline auto run_tasks_(WorkProvider& provider, size_t task_count, std::function<void(size_t)> task) -> void
+	{
+		// work enqueued to the provider may well run after we've returned,
+		// so it shares ownership of the bookkeeping. by then there are no
+		// tasks left to claim, so task (and what it references) isn't touched
+		struct state_t
+		{
+			std::function<void(size_t)> task;
+			size_t task_count = 0;
+			std::atomic<size_t> next_idx{0};
+			std::atomic<size_t> done_count{0};
+
+			// written only by whoever sets failed, and read once everything's done
+			std::atomic<bool> failed{false};
+			std::exception_ptr error;
+
+			auto run() -> void
+			{
+				for (size_t idx = next_idx++; idx < task_count; idx = next_idx++)
+				{
+					// a thrown task is still done, or we'd wait on it forever
+					if (!failed.load())
+					{
+						try
+						{
+							task(idx);
+						}
+						catch (...)
+						{
+							if (!failed.exchange(true))
+								error = std::current_exception();
+						}
+					}
+
+					if (++done_count == task_count)
+						done_count.notify_all();
+				}
+			}
+		};
+
+		if (task_count == 0)
+			return;
+
+		auto state = std::make_shared<state_t>();
+		state->task = std::move(task);
+		state->task_count = task_count;
+
+		for (size_t i = 1; i != task_count; ++i)
+			provider.enqueue([state] { state->run(); });
+
+		// this thread works too, so progress doesn't depend on the provider
+		state->run();
+
+		for (size_t done = state->done_count.load(); done != task_count; done = state->done_count.load())
+			state->done_count.wait(done);
+
+		if (state->error)
+			std::rethrow_exception(state->error);
+	}
+}
+
+namespace atma
+{
+	template <typename RT>
+	template <typename WorkProvider, typename F>
+	inline auto basic_rope_t<RT>::parallel_for_all_text(WorkProvider& provider, F&& f) const -> void
+	{
+		std::vector<_rope_::tree_t<RT>> tasks;
+		_rope_::partition_for_tasks_(root_, _rope_::task_bytes_for_(root_), tasks);
+
+		_rope_::run_tasks_(provider, tasks.size(), [&tasks, &f](size_t idx) {
+			_rope_::for_all_text(std::ref(f), tasks[idx]);
+		});
+	}
+
+	template <typename RT>
+	template <typename WorkProvider, typename T, typename Map, typename Reduce>
+	inline auto basic_rope_t<RT>::parallel_reduce(WorkProvider& provider, T identity, Map&& map, Reduce&& reduce) const -> T
+	{
+		std::vector<_rope_::tree_t<RT>> tasks;
+		_rope_::partition_for_tasks_(root_, _rope_::task_bytes_for_(root_), tasks);
+
+		// wrapped so that tasks never share an element (looking at you, bool)
+		struct task_result_t { T value; };
+		std::vector<task_result_t> results(tasks.size(), task_result_t{identity});
+
+		_rope_::run_tasks_(provider, tasks.size(), [&](size_t idx) {
+			_rope_::for_all_text([&](std::string_view str) {
+				results[idx].value = std::invoke(reduce, std::move(results[idx].value), std::invoke(map, str));
+			}, tasks[idx]);
+		});
+
+		T result = std::move(identity);
+		for (auto& x : results)
+			result = std::invoke(reduce, std::move(result), std::move(x.value));
+
+		return result;
+	}
+}
+
+
+
+//---------------------------------------------------------------------
+//
+//  IMPLEMENTATION :: rebalancing
+//
+//---------------------------------------------------------------------
+namespace atma::_rope_
+{
+	template <typename RT>
+	inline auto collect_stats_(tree_t<RT> const& tree, rope_stats_t& stats) -> void
+	{
+		if (ref_counted_traits<node_t<RT>>::use_count(&tree.node()) > 1)
+			++stats.shared_count;
+
+		if (tree.is_leaf())
+		{
+			size_t const bucket = tree.size_bytes() * rope_stats_t::fill_buckets / RT::buf_edit_max_size;
+
+			++stats.leaf_count;
+			++stats.leaf_fill_histogram[std::min(bucket, rope_stats_t::fill_buckets - 1)];
+			stats.bytes += tree.size_bytes();
+		}
+		else
+		{
+			++stats.internal_count;
+			stats.child_count += tree.child_count();
+
+			for (auto const& child : tree.children())
+				collect_stats_(child, stats);
+		}
+	}
+
+	// merges neighbouring internal nodes whose children fit in fewer nodes, at
+	// every level below tree, but only where they overlap [begin, end). new
+	// nodes are built rather than nodes edited, so sharing is unaffected
+	template <typename RT>
+	inline auto merge_siblings_(tree_t<RT> const& tree, size_t begin, size_t end, bool is_root) -> tree_t<RT>
+	{
+		// the children of the lowest internal nodes are leaves
+		if (tree.height() <= 2)
+			return tree;
+
+		std::vector<tree_t<RT>> children;
+		std::vector<bool> in_range;
+		children.reserve(tree.child_count());
+		in_range.reserve(tree.child_count());
+
+		size_t child_begin = 0;
+		for (auto const& child : tree.children())
+		{
+			size_t const child_end = child_begin + child.size_chars();
+			children.push_back(child);
+			in_range.push_back(child_begin <= end && begin <= child_end);
+			child_begin = child_end;
+		}
+
+		// a run of neighbours whose children fit in fewer nodes is rebuilt as
+		// that many nodes, sharing the children out evenly. runs are no longer
+		// than a node is wide, and a non-root node mustn't drop below the
+		// minimum number of children
+		bool changed = false;
+		auto merge_children = [&]
+		{
+			for (size_t i = 0; i + 1 < children.size(); )
+			{
+				size_t run = 0, grandchildren = 0, nodes = 0;
+				for (size_t j = i; j != children.size() && j - i != RT::branching_factor && in_range[j]; ++j)
+				{
+					grandchildren += children[j].child_count();
+					nodes = ceil_div(grandchildren, RT::branching_factor);
+					if (j != i && nodes < j - i + 1)
+					{
+						run = j - i + 1;
+						break;
+					}
+				}
+
+				if (run == 0 || (!is_root && children.size() - (run - nodes) < RT::minimum_branches))
+				{
+					++i;
+					continue;
+				}
+
+				std::vector<tree_t<RT>> xs;
+				xs.reserve(grandchildren);
+				for (size_t j = i; j != i + run; ++j)
+					xs.insert(xs.end(), children[j].children().begin(), children[j].children().end());
+
+				for (size_t n = 0, taken = 0; n != nodes; ++n)
+				{
+					size_t const count = (grandchildren - taken) / (nodes - n);
+					children[i + n] = tree_t<RT>{make_internal_ptr<RT>(tree.height() - 1, std::span{xs}.subspan(taken, count))};
+					taken += count;
+				}
+
+				children.erase(children.begin() + i + nodes, children.begin() + i + run);
+				in_range.erase(in_range.begin() + i + nodes, in_range.begin() + i + run);
+				changed = true;
+			}
+		};
+
+		// merging here gives our children more room to merge theirs, and
+		// merging theirs can free up room for more merges here
+		merge_children();
+
+		child_begin = 0;
+		for (auto& child : children)
+		{
+			size_t const child_end = child_begin + child.size_chars();
+
+			if (child_begin <= end && begin <= child_end)
+			{
+				auto merged = merge_siblings_(child, begin - std::min(begin, child_begin), end - child_begin, false);
+				if (&merged.node() != &child.node())
+				{
+					child = merged;
+					changed = true;
+				}
+			}
+
+			child_begin = child_end;
+		}
+
+		merge_children();
+
+		if (!changed)
+			return tree;
+
+		return tree_t<RT>{make_internal_ptr<RT>(tree.height(), children)};
+	}
+}
+
+namespace atma
+{
+	template <typename RT>
+	inline auto basic_rope_t<RT>::stats() const -> rope_stats_t
+	{
+		rope_stats_t result;
+		result.height = root_.height();
+		result.leaf_capacity = RT::buf_edit_max_size;
+		result.branching_factor = RT::branching_factor;
+
+		_rope_::collect_stats_(root_, result);
+		return result;
+	}
+
+	template <typename RT>
+	inline auto basic_rope_t<RT>::rebalance(size_t byte_budget, size_t char_idx) -> size_t
+	{
+		// runs of leaves at most three-quarters full can be packed into fewer
+		constexpr size_t underfilled_bytes = RT::buf_edit_max_size * 3 / 4;
+
+		if (char_idx >= size())
+			return size();
+
+		// internal nodes over the text we've looked at are merged last, once
+		// packing the leaves has thinned them out
+		auto finish = [this, begin = char_idx](size_t end) -> size_t
+		{
+			root_ = _rope_::merge_siblings_(root_, begin, end, true);
+
+			while (root_.height() > 1 && root_.child_count() == 1)
+			{
+				auto child = root_.children()[0];
+				root_ = child;
+			}
+
+			return end;
+		};
+
+		_rope_::leaf_cursor_t<RT> cursor{root_, char_idx};
+
+		size_t work = 0;
+		while (work < byte_budget)
+		{
+			char_idx = cursor.char_idx();
+
+			if (cursor.leaf().size_bytes() > underfilled_bytes)
+			{
+				work += cursor.leaf().size_bytes();
+				if (!cursor.next())
+					return finish(size());
+
+				continue;
+			}
+
+			// gather the run of under-filled leaves starting here, but no more
+			// than the budget allows. a lone under-filled leaf can still share
+			// with its successor
+			std::string text;
+			size_t run_characters = 0;
+			size_t run_leaves = 0;
+			bool at_end = false;
+
+			auto take_leaf = [&] {
+				auto const data = cursor.data();
+				text.append(data.data(), data.size());
+				run_characters += cursor.leaf().size_chars();
+				++run_leaves;
+				at_end = !cursor.next();
+			};
+
+			take_leaf();
+			while (!at_end && cursor.leaf().size_bytes() <= underfilled_bytes && work + text.size() < byte_budget)
+				take_leaf();
+
+			if (!at_end && run_leaves == 1 && text.size() + cursor.leaf().size_bytes() <= RT::buf_edit_max_size)
+				take_leaf();
+
+			// every leaf costs something, even an empty one
+			work += text.size() + run_leaves;
+
+			// only bother if it saves a leaf. the run is rebuilt on its own, and
+			// concatenation takes care of the internal nodes along both seams
+			if (_rope_::ceil_div(text.size(), RT::buf_edit_max_size) < run_leaves)
+			{
+				auto [lhs, rest] = split(char_idx);
+				auto [run, rhs] = rest.split(run_characters);
+
+				*this = text.empty()
+					? lhs + rhs
+					: lhs + basic_rope_t<RT>{text.data(), text.size()} + rhs;
+
+				if (at_end)
+					return finish(size());
+
+				cursor = _rope_::leaf_cursor_t<RT>{root_, char_idx + run_characters};
+			}
+			else if (at_end)
+			{
+				return finish(size());
+			}
+		}
+
+		return finish(cursor.char_idx());
+	}
+}
+
+
+
+
+
+
+//---------------------------------------------------------------------
+//
+//  IMPLEMENTATION :: serialization
+//
+//---------------------------------------------------------------------
+namespace atma::_rope_
+{
+	// the tree format is a header, then every node in pre-order. internal
+	// nodes are a tag, a child-count and the subtree's text-info, and leaves
+	// are a tag, the leaf's text-info, and then the text
+	//
+	// version 2 records internal nodes' text-info, and allows leaves of up
+	// to mapped_leaf_size bytes
+	struct stream_header_t
+	{
+		char magic[4] = {'r', 'o', 'p', 'e'};
+		uint32_t version = 2;
+		uint32_t buf_size = 0;
+		uint32_t branching_factor = 0;
+	};
+
+	enum class stream_node_tag_t : uint32_t
+	{
+		branch,
+		leaf,
+	};
+
+	struct stream_branch_t
+	{
+		uint32_t child_count = 0;
+		uint32_t bytes = 0;
+		uint32_t characters = 0;
+		uint32_t line_breaks = 0;
+	};
+
+	struct stream_leaf_t
+	{
+		uint32_t bytes = 0;
+		uint32_t characters = 0;
+		uint32_t line_breaks = 0;
+	};
+
+	// trees can't legitimately get anywhere near this tall
+	constexpr uint32_t stream_max_height = 64;
+
+	// the text of a leaf read from a stream that's too big for a buffer
+	struct owned_text_t : rope_mapped_text_t
+	{
+		explicit owned_text_t(size_t size)
+			: owned_text_t{std::make_unique<char[]>(size), size}
+		{}
+
+		auto buffer() -> char* { return text_.get(); }
+
+	private:
+		owned_text_t(std::unique_ptr<char[]> text, size_t size)
+			: rope_mapped_text_t{text.get(), size}
+			, text_{std::move(text)}
+		{}
+
+		std::unique_ptr<char[]> text_;
+	};
+
+	inline auto stream_write_(output_bytestream_t& stream, void const* data, size_t size, write_result_t& result) -> bool
+	{
+		if (result.status == stream_status_t::error)
+			return false;
+
+		auto r = stream.write(data, size);
+		result.bytes_written += r.bytes_written;
+
+		if (r.bytes_written != size)
+			result.status = stream_status_t::error;
+
+		return result.status != stream_status_t::error;
+	}
+
+	inline auto stream_read_(input_bytestream_t& stream, void* data, size_t size, read_result_t& result) -> bool
+	{
+		if (result.status == stream_status_t::error)
+			return false;
+
+		auto r = stream.read(data, size);
+		result.bytes_read += r.bytes_read;
+
+		if (r.bytes_read != size)
+			result.status = stream_status_t::error;
+
+		return result.status != stream_status_t::error;
+	}
+
+	template <typename RT>
+	inline auto write_tree_(output_bytestream_t& stream, tree_t<RT> const& tree, write_result_t& result) -> bool
+	{
+		return tree.node().visit(
+			[&](node_internal_t<RT> const&)
+			{
+				auto const tag = stream_node_tag_t::branch;
+				auto const branch = stream_branch_t{tree.child_count(), tree.info().bytes, tree.info().characters, tree.info().line_breaks};
+
+				if (!stream_write_(stream, &tag, sizeof(tag), result) || !stream_write_(stream, &branch, sizeof(branch), result))
+					return false;
+
+				for (auto const& child : tree.children())
+					if (!write_tree_(stream, child, result))
+						return false;
+
+				return true;
+			},
+			[&](node_leaf_t<RT> const&)
+			{
+				auto const tag = stream_node_tag_t::leaf;
+				auto const text = tree.as_leaf().data();
+				auto const leaf = stream_leaf_t{tree.info().bytes, tree.info().characters, tree.info().line_breaks};
+
+				return stream_write_(stream, &tag, sizeof(tag), result)
+					&& stream_write_(stream, &leaf, sizeof(leaf), result)
+					&& stream_write_(stream, text.data(), text.size(), result);
+			});
+	}
+
+	// what reading the leaves so far has told us
+	struct stream_reading_t
+	{
+		bool ends_in_cr = false;
+		bool has_mapped_leaves = false;
+	};
+
+	// rebuilds a subtree at the given depth (the root being 1) from the stream,
+	// checking it's one we could have built ourselves: every leaf is whole
+	// characters, doesn't split a crlf with the leaf before (which ended in a
+	// cr if reading.ends_in_cr), and has text-info that's possible for its size, and
+	// every node but the root is non-empty, has at least minimum_branches
+	// children, and sums them up
+	//
+	// the recorded text-info is trusted, so the text isn't counted unless
+	// the checks ask for it
+	template <typename RT>
+	inline auto read_tree_(input_bytestream_t& stream, uint32_t height, rope_stream_checks_t checks, read_result_t& result, stream_reading_t& reading) -> maybe_tree_t<RT>
+	{
+		if (height > stream_max_height)
+			return std::nullopt;
+
+		stream_node_tag_t tag;
+		if (!stream_read_(stream, &tag, sizeof(tag), result))
+			return std::nullopt;
+
+		if (tag == stream_node_tag_t::leaf)
+		{
+			stream_leaf_t leaf;
+			if (!stream_read_(stream, &leaf, sizeof(leaf), result))
+				return std::nullopt;
+
+			if (leaf.bytes > RT::mapped_leaf_size || (leaf.bytes == 0 && height != 1))
+				return std::nullopt;
+
+			// characters are one to four bytes each, and line-breaks are characters
+			if (leaf.characters > leaf.bytes || leaf.bytes > uint64_t(leaf.characters) * 4 || leaf.line_breaks > leaf.characters)
+				return std::nullopt;
+
+			// a leaf too big for a buffer was mapped. it's read into text of
+			// its own, which is viewed the same way
+			char buffer[RT::buf_size];
+			char* text = buffer;
+
+			rope_mapped_text_ptr owned;
+			if (leaf.bytes > RT::buf_edit_max_size)
+			{
+				auto* x = new owned_text_t{leaf.bytes};
+				owned = rope_mapped_text_ptr{x};
+				text = x->buffer();
+				reading.has_mapped_leaves = true;
+			}
+
+			if (!stream_read_(stream, text, leaf.bytes, result))
+				return std::nullopt;
+
+			if (leaf.bytes != 0)
+			{
+				// whole characters only, and no crlf split between leaves
+				size_t last = leaf.bytes - 1;
+				while (last != 0 && !utf8_byte_is_leading(byte(text[last])))
+					--last;
+
+				if (!utf8_byte_is_leading(byte(text[0])) || last + utf8_char_size_bytes(text + last) != leaf.bytes)
+					return std::nullopt;
+
+				if (reading.ends_in_cr && text[0] == charcodes::lf)
+					return std::nullopt;
+
+				reading.ends_in_cr = text[leaf.bytes - 1] == charcodes::cr;
+			}
+
+			auto const info = text_info_t{.bytes = leaf.bytes, .characters = leaf.characters, .line_breaks = leaf.line_breaks};
+
+			if (checks == rope_stream_checks_t::text)
+			{
+				auto const counted = text_info_t::from_str(text, leaf.bytes);
+				if (counted.characters != leaf.characters || counted.line_breaks != leaf.line_breaks)
+					return std::nullopt;
+			}
+
+			return owned
+				? tree_t<RT>{info, make_mapped_leaf_ptr<RT>(owned, 0, leaf.bytes)}
+				: tree_t<RT>{info, make_leaf_ptr<RT>(src_buf_t{text, leaf.bytes})};
+		}
+		else if (tag == stream_node_tag_t::branch)
+		{
+			stream_branch_t branch;
+			if (!stream_read_(stream, &branch, sizeof(branch), result))
+				return std::nullopt;
+
+			uint32_t const child_count = branch.child_count;
+			if (child_count == 0 || child_count > RT::branching_factor || (height != 1 && child_count < RT::minimum_branches))
+				return std::nullopt;
+
+			std::array<tree_t<RT>, RT::branching_factor> children;
+			text_info_t info;
+			for (uint32_t i = 0; i != child_count; ++i)
+			{
+				auto child = read_tree_<RT>(stream, height + 1, checks, result, reading);
+				if (!child)
+					return std::nullopt;
+
+				// every leaf must be at the same depth
+				if (i != 0 && child->height() != children[0].height())
+					return std::nullopt;
+
+				children[i] = *child;
+				info = info + child->info();
+			}
+
+			if (info.bytes != branch.bytes || info.characters != branch.characters || info.line_breaks != branch.line_breaks)
+				return std::nullopt;
+
+			auto node = make_internal_ptr<RT>(children[0].height() + 1, xfer_src(children.data(), child_count));
+			return tree_t<RT>{info, child_count, node};
+		}
+
+		return std::nullopt;
+	}
+}
+
+namespace atma
+{
+	template <typename RT>
+	inline auto basic_rope_t<RT>::write_to(output_bytestream_t& stream, rope_stream_format_t format) const -> write_result_t
+	{
+		auto result = write_result_t{stream_status_t::good, 0};
+
+		if (format == rope_stream_format_t::tree)
+		{
+			auto const header = _rope_::stream_header_t{.buf_size = RT::buf_size, .branching_factor = RT::branching_factor};
+
+			if (_rope_::stream_write_(stream, &header, sizeof(header), result))
+				_rope_::write_tree_(stream, root_, result);
+		}
+		else
+		{
+			for_all_text([&](std::string_view text) {
+				_rope_::stream_write_(stream, text.data(), text.size(), result);
+			});
+		}
+
+		return result;
+	}
+
+	template <typename RT>
+	inline auto basic_rope_t<RT>::read_from(input_bytestream_t& stream, rope_stream_format_t format, rope_stream_checks_t checks) -> read_result_t
+	{
+		auto result = read_result_t{stream_status_t::good, 0};
+
+		if (format == rope_stream_format_t::tree)
+		{
+			_rope_::stream_header_t header;
+			if (!_rope_::stream_read_(stream, &header, sizeof(header), result))
+				return result;
+
+			auto const expected = _rope_::stream_header_t{.buf_size = RT::buf_size, .branching_factor = RT::branching_factor};
+			if (memcmp(&header, &expected, sizeof(header)) != 0)
+				return read_result_t{stream_status_t::error, result.bytes_read};
+
+			_rope_::stream_reading_t reading;
+			auto tree = _rope_::read_tree_<RT>(stream, 1, checks, result, reading);
+			if (!tree)
+				return read_result_t{stream_status_t::error, result.bytes_read};
+
+			root_ = *tree;
+			has_mapped_leaves_ = reading.has_mapped_leaves;
+			return result;
+		}
+
+		// the chunk always has room for more than a leaf's worth, as that's
+		// what we might have left over from the chunk before
+		constexpr size_t chunk_size = RT::buf_size * 64;
+		auto chunk = std::make_unique<char[]>(chunk_size);
+		size_t chunk_used = 0;
+
+		auto const& builder = _rope_::build_rope_<RT>;
+		typename _rope_::build_rope_t_<RT>::level_stack_t stack;
+
+		auto make_leaf = [](_rope_::src_buf_t leaf_text) {
+			return _rope_::make_leaf_ptr<RT>(leaf_text);
+		};
+
+		for (bool last = false; !last; )
+		{
+			auto r = stream.read(chunk.get() + chunk_used, chunk_size - chunk_used);
+			if (r.status == stream_status_t::error)
+				return read_result_t{stream_status_t::error, result.bytes_read + r.bytes_read};
+
+			result.bytes_read += r.bytes_read;
+			chunk_used += r.bytes_read;
+			last = r.status != stream_status_t::good || r.bytes_read == 0;
+
+			size_t const consumed = builder.push_leaves_(stack, _rope_::src_buf_t{chunk.get(), chunk_used}, last, make_leaf);
+			memmove(chunk.get(), chunk.get() + consumed, chunk_used - consumed);
+			chunk_used -= consumed;
+		}
+
+		root_ = stack.empty()
+			? _rope_::tree_t<RT>{_rope_::make_leaf_ptr<RT>()}
+			: builder.stack_finish(stack);
+		has_mapped_leaves_ = false;
+
+		return result;
+	}
+}
+
+
+
+
+
+
+//---------------------------------------------------------------------
+//
+//  IMPLEMENTATION :: batched edits
+//
+//---------------------------------------------------------------------
+namespace atma::_rope_
+{
+	// an edit touches the characters [begin, end) if it erases any of them,
+	// or inserts amongst them. inserts at end belong to whatever's next,
+	// unless nothing is
+	inline auto edit_touches_(rope_edit_t const& edit, size_t begin, size_t end, bool at_end) -> bool
+	{
+		bool const erases = edit.erase_characters != 0
+			&& edit.char_idx < end && begin < edit.char_idx + edit.erase_characters;
+
+		bool const inserts = !edit.text.empty()
+			&& begin <= edit.char_idx && (edit.char_idx < end || (at_end && edit.char_idx == end));
+
+		return erases || inserts;
+	}
+
+	// packs the same-height trees [first, trees.size()) into as few internal
+	// nodes as they'll fit, spreading them evenly, and replaces them with
+	// those nodes. so long as there are minimum_branches trees, every node
+	// gets at least that many
+	template <typename RT>
+	inline auto batch_pack_(std::vector<tree_t<RT>>& trees, size_t first) -> void
+	{
+		size_t const tree_count = trees.size() - first;
+		size_t const node_count = ceil_div(tree_count, RT::branching_factor);
+
+		// node i is built from trees that are all at or after i, so it can
+		// be written in place
+		for (size_t i = 0; i != node_count; ++i)
+		{
+			size_t const begin = first + tree_count * i / node_count;
+			size_t const end = first + tree_count * (i + 1) / node_count;
+
+			text_info_t info;
+			for (size_t j = begin; j != end; ++j)
+				info = info + trees[j].info();
+
+			auto node = make_internal_ptr<RT>(
+				trees[begin].height() + 1,
+				std::span<tree_t<RT> const>{trees.data() + begin, end - begin});
+
+			trees[first + i] = tree_t<RT>{info, uint32_t(end - begin), node};
+		}
+
+		trees.resize(first + node_count);
+	}
+
+	// mends a crlf pair split between trees[idx - 1] and trees[idx]
+	template <typename RT>
+	inline auto batch_mend_(std::vector<tree_t<RT>>& trees, size_t idx) -> void
+	{
+		bool const has_trailing_cr = navigate_to_back_leaf(trees[idx - 1],
+			[](tree_leaf_t<RT> const& leaf, size_t) { return !leaf.data().empty() && leaf.data().back() == charcodes::cr; });
+
+		if (has_trailing_cr)
+		{
+			if (auto maybe_nodes = mend_right_seam_(seam_t::right, trees[idx - 1], trees[idx]))
+				std::tie(trees[idx - 1], trees[idx]) = *maybe_nodes;
+		}
+	}
+
+	// appends the leaves the edited leaf becomes. edited is scratch-space,
+	// reused between leaves
+	template <typename RT>
+	inline auto batch_edit_leaf_(tree_leaf_t<RT> const& leaf, size_t begin, std::span<rope_edit_t const> edits, std::vector<tree_t<RT>>& result, std::string& edited) -> void
+	{
+		auto const text = leaf.data();
+		size_t const end = begin + leaf.info().characters;
+
+		edited.clear();
+
+		size_t byte_idx = 0;
+		for (auto const& edit : edits)
+		{
+			size_t const erase_begin = std::max(edit.char_idx, begin) - begin;
+			size_t const erase_end = std::min(edit.char_idx + edit.erase_characters, end) - begin;
+
+			size_t const erase_begin_byte = leaf.byte_idx_from_char_idx(erase_begin);
+			edited.append(text.data() + byte_idx, erase_begin_byte - byte_idx);
+
+			// an edit that began in an earlier leaf inserted its text there
+			if (begin <= edit.char_idx)
+				edited.append(edit.text);
+
+			byte_idx = leaf.byte_idx_from_char_idx(erase_end);
+		}
+
+		edited.append(text.data() + byte_idx, text.size() - byte_idx);
+
+		cut_leaves_<RT>(src_buf_t{edited.data(), edited.size()}, true, [&](src_buf_t leaf_text) {
+			result.emplace_back(make_leaf_ptr<RT>(leaf_text));
+		});
+	}
+
+	// appends what the edited tree becomes to result. if the trees appended
+	// are all as tall as the tree was, they're fit to be the children of an
+	// internal node and we return true. otherwise the tree came out too
+	// small for a node of its own, so it's joined into one tree of whatever
+	// height, and our ancestors will have to be joined too
+	template <typename RT>
+	inline auto batch_edit_(tree_t<RT> const& tree, size_t begin, bool at_end, std::span<rope_edit_t const> edits, std::vector<tree_t<RT>>& result, std::string& scratch) -> bool
+	{
+		if (tree.is_leaf())
+		{
+			batch_edit_leaf_(tree.as_leaf(), begin, edits, result, scratch);
+			return true;
+		}
+
+		size_t const first = result.size();
+		bool regular = true;
+
+		// only edited children can have split a crlf pair, with whatever's
+		// either side of them. they mended their own trees one level down
+		bool mend_next = false;
+		auto mend = [&](size_t idx) {
+			if (regular && first < idx && idx < result.size())
+				batch_mend_(result, idx);
+		};
+
+		size_t edit_idx = 0;
+		size_t child_begin = begin;
+		uint32_t child_idx = 0;
+
+		for (auto const& child : tree.children())
+		{
+			size_t const child_end = child_begin + child.info().characters;
+			bool const child_at_end = at_end && ++child_idx == tree.child_count();
+
+			// edits are sorted and don't overlap, so those touching this child
+			// are contiguous. only the first can have begun in an earlier child
+			while (edit_idx != edits.size() && edits[edit_idx].char_idx < child_begin && !edit_touches_(edits[edit_idx], child_begin, child_end, child_at_end))
+				++edit_idx;
+
+			size_t edits_end = edit_idx;
+			while (edits_end != edits.size() && edit_touches_(edits[edits_end], child_begin, child_end, child_at_end))
+				++edits_end;
+
+			auto const child_edits = edits.subspan(edit_idx, edits_end - edit_idx);
+			size_t const boundary = result.size();
+
+			if (child_edits.empty())
+			{
+				result.push_back(child);
+
+				if (std::exchange(mend_next, false))
+					mend(boundary);
+			}
+			else if (auto const& edit = child_edits.front(); child_edits.size() == 1
+				&& edit.char_idx <= child_begin && child_end <= edit.char_idx + edit.erase_characters
+				&& (edit.text.empty() || edit.char_idx < child_begin))
+			{
+				// erased entirely, so there's no need to look inside
+				mend_next = true;
+			}
+			else
+			{
+				regular = batch_edit_(child, child_begin, child_at_end, child_edits, result, scratch) && regular;
+				mend(boundary);
+				mend_next = true;
+			}
+
+			// the last edit may carry on into the next child
+			if (child_edits.empty() || child_edits.back().char_idx + child_edits.back().erase_characters <= child_end)
+				edit_idx = edits_end;
+			else
+				edit_idx = edits_end - 1;
+
+			child_begin = child_end;
+		}
+
+		// a leaf that was just the lf of a pair is now empty
+		if (regular && tree.height() == 2)
+		{
+			auto const empties = std::remove_if(result.begin() + first, result.end(),
+				[](tree_t<RT> const& x) { return x.info().characters == 0; });
+
+			result.erase(empties, result.end());
+		}
+
+		size_t const count = result.size() - first;
+		if (count == 0)
+		{
+			return true;
+		}
+		else if (regular && count >= RT::minimum_branches)
+		{
+			batch_pack_<RT>(result, first);
+			return true;
+		}
+
+		// too few trees for a node of our own, so join them all (joining
+		// mends crlf pairs as it goes)
+		tree_t<RT> joined = result[first];
+		for (size_t i = first + 1; i != result.size(); ++i)
+			joined = tree_join_<RT>(joined, result[i]);
+
+		result.resize(first + 1);
+		result[first] = joined;
+		return false;
+	}
+}
+
+namespace atma
+{
+	template <typename RT>
+	inline auto basic_rope_t<RT>::apply_edits(std::span<rope_edit_t const> edits) -> void
+	{
+		// sort, leaving out edits that do nothing
+		std::vector<rope_edit_t> sorted;
+		sorted.reserve(edits.size());
+		std::ranges::copy_if(edits, std::back_inserter(sorted),
+			[](rope_edit_t const& x) { return x.erase_characters != 0 || !x.text.empty(); });
+
+		std::ranges::stable_sort(sorted, std::less<>{}, &rope_edit_t::char_idx);
+
+		for (size_t i = 0; i != sorted.size(); ++i)
+		{
+			ATMA_ASSERT(sorted[i].char_idx + sorted[i].erase_characters <= size(), "edit out of range");
+			ATMA_ASSERT(i == 0 || sorted[i - 1].char_idx + sorted[i - 1].erase_characters <= sorted[i].char_idx, "edits overlap");
+		}
+
+		if (sorted.empty())
+			return;
+
+		// mapped text is only copied where it's edited
+		if (has_mapped_leaves_)
+		{
+			for (auto const& edit : sorted)
+				root_ = _rope_::isolate_for_edit_(root_, edit.char_idx, edit.char_idx + edit.erase_characters);
+		}
+
+		std::string scratch;
+		scratch.reserve(RT::buf_size * 2);
+
+		std::vector<_rope_::tree_t<RT>> trees;
+		trees.reserve(RT::branching_factor * 2);
+		_rope_::batch_edit_(root_, 0, true, std::span<rope_edit_t const>{sorted}, trees, scratch);
+
+		if (trees.empty())
+		{
+			root_ = _rope_::tree_t<RT>{_rope_::make_leaf_ptr<RT>()};
+			return;
+		}
+
+		// if there's more than one tree, they're all the same height
+		while (trees.size() > 1)
+			_rope_::batch_pack_<RT>(trees, 0);
+
+		root_ = trees.front();
+
+		// a root with one child may as well be that child
+		while (root_.is_branch() && root_.child_count() == 1)
+			root_ = *root_.children().begin();
+
+		if constexpr (_rope_::debug_internal_validation_v<RT>)
+		{
+			ATMA_ASSERT(_rope_::validate_rope_(root_));
+		}
+	}
+}
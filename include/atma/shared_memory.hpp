@@ -2,6 +2,11 @@
 
 #include <atma/platform/allocation.hpp>
 
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <utility>
+
 import atma.types;
 
 namespace atma
@@ -19,6 +24,14 @@ namespace atma
 
 	struct shared_memory_t
 	{
+		// a reference let go of by release, to be taken back exactly once by adopt.
+		// trivially copyable, so it can go wherever bytes go
+		struct released_t
+		{
+			void* allocation = nullptr;
+			size_t size = 0;
+		};
+
 		shared_memory_t() = default;
 		explicit shared_memory_t(size_t size);
 		explicit shared_memory_t(size_t size, void* data);
@@ -32,11 +45,19 @@ namespace atma
 		auto operator = (shared_memory_t&&) -> shared_memory_t&;
 
 		auto size() const -> size_t;
+
+		// how many references there are to our block, zero if we're empty
+		auto use_count() const -> uint32_t;
+
 		auto begin() -> byte*;
 		auto end() -> byte*;
 		auto begin() const -> byte const*;
 		auto end() const -> byte const*;
 
+		// lets go of our reference without dropping it, leaving us empty
+		auto release() -> released_t;
+		static auto adopt(released_t const&) -> shared_memory_t;
+
 	private:
 		auto decrement() -> void;
 		auto increment() -> void;
@@ -97,7 +118,9 @@ namespace atma
 	{
 		if (this != &rhs)
 		{
+			decrement();
 			data_ = rhs.data_;
+			increment();
 		}
 
 		return *this;
@@ -118,6 +141,11 @@ namespace atma
 		return *reinterpret_cast<size_t*>(data_);
 	}
 
+	inline auto shared_memory_t::use_count() const -> uint32_t
+	{
+		return data_ ? ref().load() : 0;
+	}
+
 	inline auto shared_memory_t::begin() -> byte*
 	{
 		return data_ + sizeof(size_t) + sizeof(std::atomic_uint32_t) + 4u;
@@ -138,6 +166,20 @@ namespace atma
 		return begin() + size();
 	}
 
+	inline auto shared_memory_t::release() -> released_t
+	{
+		released_t r{data_, data_ ? size() : 0};
+		data_ = nullptr;
+		return r;
+	}
+
+	inline auto shared_memory_t::adopt(released_t const& x) -> shared_memory_t
+	{
+		shared_memory_t r;
+		r.data_ = (byte*)x.allocation;
+		return r;
+	}
+
 	inline auto shared_memory_t::decrement() -> void
 	{
 		if (data_ && --ref() == 0)
@@ -321,9 +321,10 @@ namespace atma
 
 	inline auto inplace_engine_t::reenter(std::atomic<bool> const& good) -> void
 	{
+		// the flags we run on are only ever flipped by signals, which wake us
 		while (good)
 		{
-			if (auto D = queue_.consume())
+			if (auto D = queue_.consume_wait(std::chrono::milliseconds{100}))
 			{
 				queue_fn_t* f = (queue_fn_t*)D.data();
 				(*f)();
@@ -422,6 +423,14 @@ namespace atma
 
 		static auto worker_thread_runloop(thread_pool_t*, std::atomic_bool&) -> void;
 
+		// a closure too big for internal_function_t is stored just after it, so
+		// room for it has to be made whether or not fn itself stores it externally
+		static constexpr uint32 allocation_alignment = (uint32)alignof(std::max_align_t);
+		static auto allocation_size(function_t const& fn) -> uint32
+		{
+			return (uint32)internal_function_t::contiguous_relative_allocation_size_for(fn);
+		}
+
 	private:
 		// queue for work submission
 		lockfree_queue_t queue_;
@@ -441,8 +450,14 @@ namespace atma
 	inline thread_pool_t::~thread_pool_t()
 	{
 		running_ = false;
+		queue_.notify_all();
 		for (auto& x : threads_)
 			x.join();
+
+		// work that never got to run still owns its closure
+		while (queue_.with_consumption([](auto& D) {
+			((internal_function_t*)D.data())->~internal_function_t();
+		}));
 	}
 
 	inline auto thread_pool_t::thread_count() const -> size_t
@@ -452,14 +467,14 @@ namespace atma
 
 	inline auto thread_pool_t::enqueue(function_t const& fn) -> void
 	{
-		queue_.with_allocation(sizeof(internal_function_t) + (uint32)fn.external_buffer_size(), 4, true, [&fn](auto& A) {
+		queue_.with_allocation(allocation_size(fn), allocation_alignment, true, [&fn](auto& A) {
 			new (A.data()) internal_function_t{fn, (char*)A.data() + sizeof(internal_function_t)};
 		});
 	}
 
 	inline auto thread_pool_t::enqueue(function_t&& fn) -> void
 	{
-		queue_.with_allocation(sizeof(internal_function_t) + (uint32)fn.external_buffer_size(), 4, true, [&fn](auto& A) {
+		queue_.with_allocation(allocation_size(fn), allocation_alignment, true, [&fn](auto& A) {
 			new (A.data()) internal_function_t{std::move(fn), (char*)A.data() + sizeof(internal_function_t)};
 		});
 	}
@@ -472,7 +487,7 @@ namespace atma
 			enqueue_repeat(fn);
 		};
 
-		queue_.with_allocation(sizeof(internal_function_t) + (uint32)rfn.external_buffer_size(), 4, true, [&rfn](auto& A) {
+		queue_.with_allocation(allocation_size(rfn), allocation_alignment, true, [&rfn](auto& A) {
 			new (A.data()) internal_function_t{rfn, (char*)A.data() + sizeof(internal_function_t)};
 		});
 	}
@@ -485,7 +500,7 @@ namespace atma
 			enqueue_repeat(std::move(fn));
 		};
 
-		queue_.with_allocation(sizeof(internal_function_t) + (uint32)rfn.external_buffer_size(), 4, true, [&rfn](auto& A) {
+		queue_.with_allocation(allocation_size(rfn), allocation_alignment, true, [&rfn](auto& A) {
 			new (A.data()) internal_function_t{rfn, (char*)A.data() + sizeof(internal_function_t)};
 		});
 	}
@@ -499,16 +514,16 @@ namespace atma
 		atma::unique_memory_t mem;
 		while (running)
 		{
-			if (pool->queue_.with_consumption([&](auto& D)
+			if (pool->queue_.with_consumption_wait(std::chrono::milliseconds{100}, [&](auto& D)
 			{
 				D.local_copy(mem);
 			}))
 			{
+				// the copy owns the closure now, the queue's bytes are just cleared
 				internal_function_t* f = (internal_function_t*)mem.begin();
 				(*f)();
+				f->~internal_function_t();
 			}
-
-			Sleep(1);
 		}
 	}
 }
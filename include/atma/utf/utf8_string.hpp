@@ -562,7 +562,7 @@ namespace atma
 			return;
 
 		uint idx = 0;
-		switch (detail::char_length_table[*c])
+		switch (detail::char_length_table[(uint8)*c])
 		{
 			case 4: bytes_[idx++] = (byte)*c++; [[fallthrough]];
 			case 3: bytes_[idx++] = (byte)*c++; [[fallthrough]];
@@ -1168,7 +1168,7 @@ namespace atma
 	// c in codepoint [0, 128), a.k.a: ascii
 	constexpr auto utf8_char_is_ascii(char const c) -> bool
 	{
-		return detail::char_length_table[c] == 1;
+		return detail::char_length_table[(uint8)c] == 1;
 	}
 
 	constexpr auto utf8_char_is_newline(char const* leading) -> bool
@@ -1189,7 +1189,7 @@ namespace atma
 		ATMA_ASSERT(leading);
 		ATMA_ENSURE(utf8_byte_is_leading((byte)*leading));
 
-		return detail::char_length_table[*leading];
+		return detail::char_length_table[(uint8)*leading];
 	}
 
 	constexpr auto utf8_char_advance(char const*& leading) -> void
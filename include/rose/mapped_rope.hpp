@@ -0,0 +1,49 @@
+#pragma once
+
+#include <rose/mmap.hpp>
+
+#include <atma/rope.hpp>
+
+#include <optional>
+
+
+namespace rose
+{
+	// mapped_rope_text_t
+	// --------------------
+	//  the text of a memory-mapped file, for ropes to view directly. the
+	//  file is unmapped when the last rope viewing it goes
+	//
+	struct mapped_rope_text_t : atma::rope_mapped_text_t
+	{
+		explicit mapped_rope_text_t(mmap_view_t&& view)
+			: atma::rope_mapped_text_t{view.data(), view.size()}
+			, view_{std::move(view)}
+		{}
+
+	private:
+		mmap_view_t view_;
+	};
+
+	// opens the file at path as a rope, without reading it into memory. its
+	// text is still counted, across thread_count threads. returns nothing if
+	// the file couldn't be mapped
+	template <typename RT = atma::rope_default_traits>
+	inline auto open_mapped_rope(stdfs::path const& path, size_t thread_count = 1) -> std::optional<atma::basic_rope_t<RT>>
+	{
+		mmap_t mmap{path, file_access_t::read};
+		if (!mmap.valid())
+			return std::nullopt;
+
+		// empty files can't be mapped, and don't need to be
+		if (mmap.size() == 0)
+			return atma::basic_rope_t<RT>{};
+
+		mmap_view_t view{mmap};
+		if (!view.valid())
+			return std::nullopt;
+
+		auto text = atma::rope_mapped_text_ptr{new mapped_rope_text_t{std::move(view)}};
+		return atma::basic_rope_t<RT>{text, thread_count};
+	}
+}
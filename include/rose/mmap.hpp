@@ -47,6 +47,33 @@ namespace rose
 
 	using mmap_ptr = atma::intrusive_ptr<mmap_t>;
 
+	// mmap_view_t
+	// -------------
+	//  a read-only view of an entire mmap. the view keeps the mapping alive
+	//  by itself, so the mmap_t it came from needn't outlive it
+	//
+	struct mmap_view_t
+	{
+		mmap_view_t() = default;
+		explicit mmap_view_t(mmap_t const&);
+		mmap_view_t(mmap_view_t&&);
+		~mmap_view_t();
+
+		auto operator = (mmap_view_t&&) -> mmap_view_t&;
+
+		// not copyable
+		mmap_view_t(mmap_view_t const&) = delete;
+		mmap_view_t& operator = (mmap_view_t const&) = delete;
+
+		auto valid() const -> bool;
+		auto data() const -> char const*;
+		auto size() const -> size_t;
+
+	private:
+		void const* data_ = nullptr;
+		size_t size_ = 0;
+	};
+
 	inline auto mmap_t::handle() const -> handle_t
 	{
 		return handle_;
@@ -61,5 +88,19 @@ namespace rose
 	{
 		return access_mask_;
 	}
-}
 
+	inline auto mmap_view_t::valid() const -> bool
+	{
+		return data_ != nullptr;
+	}
+
+	inline auto mmap_view_t::data() const -> char const*
+	{
+		return reinterpret_cast<char const*>(data_);
+	}
+
+	inline auto mmap_view_t::size() const -> size_t
+	{
+		return size_;
+	}
+}
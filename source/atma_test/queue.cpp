@@ -1,6 +1,7 @@
 #include <atma/unit_test.hpp>
 
 #include <atma/lockfree_queue.hpp>
+#include <atma/interprocess_queue.hpp>
 #include <atma/threading.hpp>
 #include <atma/function.hpp>
 
@@ -8,6 +9,14 @@
 #include <thread>
 #include <atomic>
 #include <mutex>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+#if !defined(ATMA_PLATFORM_WINDOWS)
+#  include <sys/wait.h>
+#  include <unistd.h>
+#endif
 
 
 using queue_t = atma::lockfree_queue_t;
@@ -119,3 +128,762 @@ SCENARIO("lockfree_queue is amazing")
 #endif
 }
 
+SCENARIO("lockfree_queue grows when full")
+{
+	GIVEN("a growable queue with room for only a few messages")
+	{
+		atma::lockfree_queue_t Q{8 + 64, 1024 * 1024};
+
+		THEN("writers never wait for readers, and readers follow the writers across buffers")
+		{
+			for (uint32 i = 0; i != 1000; ++i)
+				Q.with_allocation(8, [i](auto& A) { A.encode_uint32(i); A.encode_uint32(~i); });
+
+			for (uint32 i = 0; i != 1000; ++i)
+			{
+				bool consumed = Q.with_consumption([i](queue_t::decoder_t& D) {
+					uint32 a, b;
+					D.decode_uint32(a);
+					D.decode_uint32(b);
+					CHECK(a == i);
+					CHECK(b == ~i);
+				});
+
+				CHECK(consumed);
+			}
+
+			CHECK(!Q.with_consumption([](auto&) {}));
+		}
+
+		THEN("a message larger than the current buffer grows the queue to fit it")
+		{
+			Q.with_allocation(4 * 4096, 4, true, [](auto& A) {
+				for (uint32 i = 0; i != 4096; ++i)
+					A.encode_uint32(i);
+			});
+
+			uint32 mismatches = 0;
+			CHECK(Q.with_consumption([&](queue_t::decoder_t& D) {
+				for (uint32 i = 0, x; i != 4096; ++i)
+				{
+					D.decode_uint32(x);
+					mismatches += x != i;
+				}
+			}));
+
+			CHECK(mismatches == 0);
+		}
+
+		THEN("a message that couldn't fit even in the largest buffer is refused, rather than waited on")
+		{
+			bool called = false;
+			CHECK(!Q.with_allocation(1024 * 1024, [&](auto&) { called = true; }));
+			CHECK(!Q.with_allocation(600 * 1024, 4, true, [&](auto&) { called = true; }));
+			CHECK(!called);
+
+			// the same message may wrap, so fits
+			CHECK(Q.with_allocation(600 * 1024, 4, false, [](auto& A) { A.encode_uint32(42); }));
+			CHECK(Q.with_consumption([](queue_t::decoder_t& D) {
+				uint32 x;
+				D.decode_uint32(x);
+				CHECK(x == 42);
+			}));
+		}
+	}
+
+	GIVEN("many writers and readers on a growable queue")
+	{
+		for (uint32 max_size : {8u + 4096u, 1024u * 1024u})
+		{
+			atma::lockfree_queue_t Q{8 + 64, max_size};
+
+			uint32 const count = 20000;
+			std::atomic<uint32> written{0}, read{0};
+			std::vector<std::atomic<uint32>> seen(count);
+
+			std::vector<std::thread> threads;
+			for (int i = 0; i != 3; ++i)
+			{
+				threads.emplace_back([&] {
+					for (uint32 idx; (idx = written++) < count; )
+						Q.with_allocation(8, 4, true, [idx](auto& A) { A.encode_uint32(idx); A.encode_uint32(~idx); });
+				});
+
+				threads.emplace_back([&] {
+					while (read < count)
+						Q.with_consumption([&](queue_t::decoder_t& D) {
+							uint32 a, b;
+							D.decode_uint32(a);
+							D.decode_uint32(b);
+							if (a == ~b && a < count)
+								++seen[a];
+							++read;
+						});
+				});
+			}
+
+			for (auto& t : threads)
+				t.join();
+
+			THEN("every message is read exactly once, whether the queue stops growing or not")
+			{
+				CHECK(std::ranges::all_of(seen, [](auto& x) { return x == 1; }));
+			}
+		}
+	}
+}
+
+SCENARIO("lockfree_queue consumes in batches")
+{
+	GIVEN("a queue with a burst of small messages")
+	{
+		uint32 const burst = 2000;
+		uint32 const rounds = 200;
+
+		auto fill = [&](queue_t& Q, uint32 round) {
+			for (uint32 i = 0; i != burst; ++i)
+				Q.with_allocation(8, [=](auto& A) { A.encode_uint32(round); A.encode_uint32(i); });
+		};
+
+		auto decode = [](queue_t::decoder_t& D, uint64& sum) {
+			uint32 a, b;
+			D.decode_uint32(a);
+			D.decode_uint32(b);
+			sum += a + b;
+		};
+
+		THEN("batches hold every message once, in order, respecting max_count and max_bytes")
+		{
+			queue_t Q{8 + 64 * 1024};
+			fill(Q, 0);
+
+			uint32 next = 0;
+			while (auto B = Q.consume_batch(7, 5 * 8))
+			{
+				CHECK(B.size() <= 5);
+
+				for (auto& D : B)
+				{
+					uint32 a, b;
+					D.decode_uint32(a);
+					D.decode_uint32(b);
+					CHECK(b == next++);
+				}
+
+				Q.finalize_batch(B);
+			}
+
+			CHECK(next == burst);
+		}
+
+		THEN("batched consumption is benchmarked against per-message consumption")
+		{
+			queue_t Q{8 + 64 * 1024};
+			uint64 single_sum = 0, batch_sum = 0;
+			std::chrono::nanoseconds single_time{}, batch_time{};
+
+			for (uint32 round = 0; round != rounds; ++round)
+			{
+				fill(Q, round);
+				auto start = std::chrono::high_resolution_clock::now();
+				while (Q.with_consumption([&](auto& D) { decode(D, single_sum); }))
+					;
+				single_time += std::chrono::high_resolution_clock::now() - start;
+
+				fill(Q, round);
+				start = std::chrono::high_resolution_clock::now();
+				while (Q.with_batch_consumption(256, 0xffffffff, [&](auto& D) { decode(D, batch_sum); }))
+					;
+				batch_time += std::chrono::high_resolution_clock::now() - start;
+			}
+
+			auto per_message = [&](std::chrono::nanoseconds t) { return t.count() / double(burst * rounds); };
+			MESSAGE("per-message consume: " << per_message(single_time) << "ns/message");
+			MESSAGE("batched consume:     " << per_message(batch_time) << "ns/message");
+
+			CHECK(single_sum == batch_sum);
+		}
+	}
+}
+
+SCENARIO("lockfree_queue consumers wait for writers")
+{
+	using namespace std::chrono_literals;
+
+	GIVEN("an empty queue")
+	{
+		queue_t Q{8 + 512};
+
+		THEN("consume_wait gives up after its timeout")
+		{
+			auto start = std::chrono::steady_clock::now();
+			CHECK(!Q.with_consumption_wait(20ms, [](auto&) {}));
+			CHECK(std::chrono::steady_clock::now() - start >= 20ms);
+		}
+
+		THEN("a parked reader is woken by a writer, well before its timeout")
+		{
+			std::atomic<bool> parked{false};
+			uint32 value = 0;
+			std::chrono::steady_clock::duration waited{};
+
+			std::thread reader{[&] {
+				parked = true;
+				auto start = std::chrono::steady_clock::now();
+				Q.with_consumption_wait(10s, [&](auto& D) { D.decode_uint32(value); });
+				waited = std::chrono::steady_clock::now() - start;
+			}};
+
+			while (!parked)
+				std::this_thread::yield();
+			std::this_thread::sleep_for(20ms);
+
+			Q.with_allocation(4, [](auto& A) { A.encode_uint32(42); });
+			reader.join();
+
+			CHECK(value == 42);
+			CHECK(waited < 5s);
+		}
+
+		THEN("notify_all wakes a parked reader with nothing to consume")
+		{
+			std::atomic<bool> parked{false};
+			std::chrono::steady_clock::duration waited{};
+
+			std::thread reader{[&] {
+				parked = true;
+				auto start = std::chrono::steady_clock::now();
+				Q.with_consumption_wait(10s, [](auto&) {});
+				waited = std::chrono::steady_clock::now() - start;
+			}};
+
+			while (!parked)
+				std::this_thread::yield();
+			std::this_thread::sleep_for(20ms);
+
+			Q.notify_all();
+			reader.join();
+
+			CHECK(waited < 5s);
+		}
+
+		THEN("a reader beaten to an allocation goes back to waiting")
+		{
+			std::atomic<uint32> parked{0};
+			std::atomic<uint32> consumed{0};
+
+			auto read = [&] {
+				++parked;
+				if (Q.with_consumption_wait(10s, [](auto&) {}))
+					++consumed;
+			};
+
+			std::thread reader1{read}, reader2{read};
+
+			while (parked != 2)
+				std::this_thread::yield();
+			std::this_thread::sleep_for(20ms);
+
+			// both readers are woken, only one gets it
+			Q.with_allocation(4, [](auto& A) { A.encode_uint32(1); });
+			std::this_thread::sleep_for(50ms);
+			CHECK(consumed == 1);
+
+			Q.with_allocation(4, [](auto& A) { A.encode_uint32(2); });
+			reader1.join();
+			reader2.join();
+
+			CHECK(consumed == 2);
+		}
+	}
+}
+
+
+SCENARIO("lockfree_queue shards producers across lanes")
+{
+	GIVEN("a queue with a lane for each of four producers")
+	{
+		queue_t Q{8 + 4096, queue_t::lanes_t{4}};
+		uint32 const messages = 2000;
+
+		auto produce = [&](uint32 id) {
+			for (uint32 i = 0; i != messages; ++i)
+				Q.with_allocation(8, [&](auto& A) { A.encode_uint32(id); A.encode_uint32(i); });
+		};
+
+		THEN("each producer's allocations are consumed in order, whilst they're produced")
+		{
+			std::vector<std::thread> producers;
+			for (uint32 id = 0; id != 4; ++id)
+				producers.emplace_back(produce, id);
+
+			std::vector<uint32> next(4, 0);
+			bool ordered = true;
+			for (uint32 consumed = 0; consumed != 4 * messages; )
+			{
+				consumed += Q.with_consumption([&](auto& D) {
+					uint32 id, i;
+					D.decode_uint32(id);
+					D.decode_uint32(i);
+					ordered = ordered && next[id] == i;
+					next[id] = i + 1;
+				});
+			}
+
+			for (auto& x : producers)
+				x.join();
+
+			CHECK(ordered);
+			CHECK(next == std::vector<uint32>(4, messages));
+		}
+
+		THEN("consumers go round the lanes")
+		{
+			std::vector<std::thread> producers;
+			for (uint32 id = 0; id != 4; ++id)
+				producers.emplace_back([&, id] { for (uint32 i = 0; i != 200; ++i) Q.with_allocation(8, [&](auto& A) { A.encode_uint32(id); A.encode_uint32(i); }); });
+			for (auto& x : producers)
+				x.join();
+
+			// every four in a row come from four different producers
+			std::vector<uint32> ids;
+			while (Q.with_consumption([&](auto& D) { uint32 id; D.decode_uint32(id); ids.push_back(id); }))
+				;
+
+			REQUIRE(ids.size() == 800);
+			for (size_t i = 0; i != ids.size(); i += 4)
+			{
+				std::sort(ids.begin() + i, ids.begin() + i + 4);
+				CHECK(std::equal(ids.begin() + i, ids.begin() + i + 4, std::vector<uint32>{0, 1, 2, 3}.begin()));
+			}
+		}
+	}
+
+	GIVEN("producers writing as fast as they can")
+	{
+		uint32 const total = 64 * 1024;
+
+		auto time_producers = [&](queue_t& Q, uint32 producer_count) {
+			std::atomic<bool> go{false};
+			std::vector<std::thread> producers;
+			for (uint32 id = 0; id != producer_count; ++id)
+			{
+				producers.emplace_back([&, id] {
+					while (!go)
+						std::this_thread::yield();
+					for (uint32 i = 0; i != total / producer_count; ++i)
+						Q.with_allocation(8, [&](auto& A) { A.encode_uint32(id); A.encode_uint32(i); });
+				});
+			}
+
+			auto start = std::chrono::high_resolution_clock::now();
+			go = true;
+			for (auto& x : producers)
+				x.join();
+			auto elapsed = std::chrono::high_resolution_clock::now() - start;
+
+			uint32 consumed = 0;
+			while (Q.with_consumption([](auto&) {}))
+				++consumed;
+			CHECK(consumed == total);
+
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / double(total);
+		};
+
+		// nanoseconds per message for 1 to 64 producers racing to fill one buffer, and
+		// the same producers each filling their own lane
+		THEN("sharding is benchmarked against a single buffer, from 1 to 64 producers")
+		{
+			MESSAGE("benchmarking on " << std::thread::hardware_concurrency() << " hardware threads");
+
+			for (uint32 producer_count = 1; producer_count <= 64; producer_count *= 2)
+			{
+				queue_t single{8 + total * 12 + 64};
+				queue_t sharded{8 + total / producer_count * 12 + 64, queue_t::lanes_t{producer_count}};
+
+				auto single_ns = time_producers(single, producer_count);
+				auto sharded_ns = time_producers(sharded, producer_count);
+
+				MESSAGE(producer_count << " producers: single " << single_ns << "ns/message, sharded " << sharded_ns << "ns/message");
+			}
+		}
+	}
+}
+
+SCENARIO("lockfree_queue reports what it's doing")
+{
+	GIVEN("a queue")
+	{
+		atma::lockfree_queue_t Q{256};
+
+		THEN("bytes in flight follow allocations until they're finalized")
+		{
+			CHECK(Q.stats().bytes_in_flight == 0);
+
+			for (uint32 i = 0; i != 3; ++i)
+				Q.with_allocation(8, [i](auto& A) { A.encode_uint32(i); A.encode_uint32(~i); });
+
+			CHECK(Q.stats().bytes_in_flight == 3 * (4 + 8));
+
+			while (Q.with_consumption([](auto&) {}))
+				;
+
+			CHECK(Q.stats().bytes_in_flight == 0);
+		}
+
+		THEN("if enabled, so do the counters")
+		{
+			if constexpr (ATMA_LOCKFREE_QUEUE_STATS)
+			{
+				// 12 messages fill the first 240 bytes, leaving 16 for a contiguous 20 byte message
+				for (uint32 i = 0; i != 20; ++i)
+				{
+					Q.with_allocation(8, 4, true, [i](auto& A) { A.encode_uint32(i); A.encode_uint32(~i); });
+					Q.with_consumption([](auto&) {});
+				}
+
+				Q.with_allocation(20, 4, true, [](auto& A) { for (uint32 i = 0; i != 5; ++i) A.encode_uint32(i); });
+
+				auto stats = Q.stats();
+				CHECK(stats.pads == 1);
+				CHECK(stats.jumps == 0);
+				CHECK(stats.high_water_bytes >= 4 + 8);
+				CHECK(stats.sizes[4] == 20);
+				CHECK(stats.sizes[5] == 1);
+			}
+		}
+	}
+
+	GIVEN("a growable queue")
+	{
+		atma::lockfree_queue_t Q{8 + 64, 1024 * 1024};
+
+		THEN("bytes in flight count the read & write buffers, but none between")
+		{
+			for (uint32 i = 0; i != 100; ++i)
+				Q.with_allocation(8, [i](auto& A) { A.encode_uint32(i); A.encode_uint32(~i); });
+
+			auto in_flight = Q.stats().bytes_in_flight;
+			CHECK(in_flight > 0);
+			CHECK(in_flight <= 100 * (4 + 8) + 64);
+
+			if constexpr (ATMA_LOCKFREE_QUEUE_STATS)
+				CHECK(Q.stats().jumps > 0);
+
+			while (Q.with_consumption([](auto&) {}))
+				;
+
+			CHECK(Q.stats().bytes_in_flight == 0);
+		}
+	}
+}
+
+SCENARIO("lockfree_queue carries large messages out-of-line")
+{
+	GIVEN("a queue far smaller than its messages")
+	{
+		atma::lockfree_queue_t Q{256};
+
+		THEN("the consumer gets the very block the producer filled in")
+		{
+			size_t const size = 1024 * 1024;
+
+			// enough messages that the handle wraps around the buffer
+			for (uint32 i = 0; i != 40; ++i)
+			{
+				byte* body = nullptr;
+				Q.with_large_allocation(size, [&](atma::shared_memory_t& mem) {
+					body = mem.begin();
+					for (size_t j = 0; j != size / 4; ++j)
+						reinterpret_cast<uint32*>(mem.begin())[j] = i + (uint32)j;
+				});
+
+				Q.with_allocation(4, [i](auto& A) { A.encode_uint32(i); });
+
+				CHECK(Q.with_consumption([&](queue_t::decoder_t& D) {
+					REQUIRE(D.is_large());
+					auto mem = D.decode_memory();
+					CHECK(mem.begin() == body);
+					CHECK(mem.size() == size);
+
+					uint32 mismatches = 0;
+					for (size_t j = 0; j != size / 4; ++j)
+						mismatches += reinterpret_cast<uint32*>(mem.begin())[j] != i + (uint32)j;
+					CHECK(mismatches == 0);
+				}));
+
+				CHECK(Q.with_consumption([i](queue_t::decoder_t& D) {
+					CHECK(!D.is_large());
+					uint32 x;
+					D.decode_uint32(x);
+					CHECK(x == i);
+				}));
+			}
+		}
+
+		THEN("batches tell large messages apart from the rest")
+		{
+			for (uint32 i = 0; i != 4; ++i)
+			{
+				Q.with_large_allocation(64, [i](atma::shared_memory_t& mem) { mem.begin()[0] = byte(i); });
+				Q.with_allocation(4, [i](auto& A) { A.encode_uint32(i); });
+			}
+
+			uint32 large = 0, normal = 0;
+			CHECK(Q.with_batch_consumption(8, 0xffffffff, [&](queue_t::decoder_t& D) {
+				if (D.is_large())
+				{
+					auto mem = D.decode_memory();
+					CHECK(mem.begin()[0] == byte(large++));
+				}
+				else
+				{
+					uint32 x;
+					D.decode_uint32(x);
+					CHECK(x == normal++);
+				}
+			}) == 8);
+
+			CHECK(large == 4);
+			CHECK(normal == 4);
+		}
+
+		THEN("blocks of messages never consumed are released with the queue")
+		{
+			atma::shared_memory_t kept[2];
+
+			{
+				atma::lockfree_queue_t Q2{256};
+				for (auto& x : kept)
+					Q2.with_large_allocation(64, [&](atma::shared_memory_t& mem) { x = mem; });
+
+				CHECK(kept[0].use_count() == 2);
+				CHECK(kept[1].use_count() == 2);
+			}
+
+			// the queue's references are gone, leaving only ours
+			CHECK(kept[0].use_count() == 1);
+			CHECK(kept[1].use_count() == 1);
+			CHECK(kept[0].size() == 64);
+		}
+	}
+}
+
+SCENARIO("interprocess_queue is shared between mappings")
+{
+	auto name = "atma_test_queue_" + std::to_string(atma::platform::current_process_id());
+	atma::interprocess_queue_t::remove(name.c_str());
+
+	GIVEN("a queue opened twice, so mapped at two addresses")
+	{
+		auto W = atma::interprocess_queue_t::open(name.c_str(), 512);
+		auto R = atma::interprocess_queue_t::open(name.c_str(), 512);
+		REQUIRE(W);
+		REQUIRE(R);
+		CHECK(R->attachments() == 2);
+
+		THEN("what's written through one is read through the other")
+		{
+			for (uint32 i = 0; i != 200; ++i)
+			{
+				W->with_allocation(8, [i](auto& A) { A.encode_uint32(i); A.encode_uint32(i * 3); });
+
+				uint32 a = 0, b = 0;
+				CHECK(R->with_consumption([&](auto& D) { D.decode_uint32(a); D.decode_uint32(b); }));
+				CHECK(a == i);
+				CHECK(b == i * 3);
+			}
+
+			CHECK(!R->with_consumption([](auto&) {}));
+		}
+
+		THEN("detaching leaves the queue, and its contents, to the others")
+		{
+			W->with_allocation(4, [](auto& A) { A.encode_uint32(7); });
+			W.reset();
+			CHECK(R->attachments() == 1);
+
+			uint32 x = 0;
+			CHECK(R->with_consumption([&](auto& D) { D.decode_uint32(x); }));
+			CHECK(x == 7);
+		}
+	}
+
+	GIVEN("a full queue, and more writers in this process than it has claims for")
+	{
+		auto Q = atma::interprocess_queue_t::open(name.c_str(), 512);
+		REQUIRE(Q);
+
+		uint32 const filled = 32;
+		for (uint32 i = 0; i != filled; ++i)
+			Q->with_allocation(8, [i](auto& A) { A.encode_uint32(i); A.encode_uint32(0); });
+
+		// as many again won't fit, so most writers are left waiting for readers
+		// to make room, holding every write claim a process has (and then some)
+		std::vector<std::thread> writers;
+		for (uint32 i = 0; i != 32; ++i)
+			writers.emplace_back([&, i] { Q->with_allocation(8, [&](auto& A) { A.encode_uint32(filled + i); A.encode_uint32(1); }); });
+
+		std::this_thread::sleep_for(std::chrono::milliseconds{50});
+
+		THEN("a reader in the same process can still claim, and make room for all of them")
+		{
+			uint32 const total = filled + (uint32)writers.size();
+			uint32 consumed = 0;
+			while (consumed != total)
+			{
+				if (!Q->with_consumption([](auto&) {}))
+					std::this_thread::yield();
+				else
+					++consumed;
+			}
+
+			for (auto& x : writers)
+				x.join();
+
+			CHECK(consumed == total);
+			CHECK(!Q->with_consumption([](auto&) {}));
+		}
+	}
+
+	atma::interprocess_queue_t::remove(name.c_str());
+}
+
+#if !defined(ATMA_PLATFORM_WINDOWS)
+SCENARIO("interprocess_queue recovers from processes that died using it")
+{
+	auto name = "atma_test_queue_" + std::to_string(atma::platform::current_process_id());
+	atma::interprocess_queue_t::remove(name.c_str());
+
+	GIVEN("a writer that died with an allocation uncommitted, and a reader that died mid-read")
+	{
+		pid_t child = fork();
+		if (child == 0)
+		{
+			auto Q = atma::interprocess_queue_t::open(name.c_str(), 256);
+			for (uint32 i = 0; i != 4; ++i)
+				Q->with_allocation(4, [i](auto& A) { A.encode_uint32(i); });
+
+			// consumed, not finalized
+			auto D = Q->consume();
+
+			// allocated, not committed
+			auto A = Q->allocate(4);
+			A.encode_uint32(99);
+
+			Q->with_allocation(4, [](auto& A) { A.encode_uint32(4); });
+			_exit(0);
+		}
+
+		int status = 0;
+		waitpid(child, &status, 0);
+
+		auto Q = atma::interprocess_queue_t::open(name.c_str(), 256);
+		REQUIRE(Q);
+		CHECK(Q->attachments() == 1);
+
+		THEN("the next process to attach gets everything else, and a working queue")
+		{
+			std::vector<uint32> got;
+			while (Q->with_consumption([&](auto& D) { uint32 x; D.decode_uint32(x); got.push_back(x); }))
+				;
+
+			CHECK(got == std::vector<uint32>{1, 2, 3, 4});
+
+			// go around the buffer a few times
+			for (uint32 i = 0; i != 100; ++i)
+			{
+				Q->with_allocation(16, [i](auto& A) { A.encode_uint32(i); });
+
+				uint32 x = 0;
+				CHECK(Q->with_consumption([&](auto& D) { D.decode_uint32(x); }));
+				CHECK(x == i);
+			}
+		}
+	}
+
+	atma::interprocess_queue_t::remove(name.c_str());
+}
+
+SCENARIO("interprocess_queue recovers from processes that died while others carry on")
+{
+	auto name = "atma_test_queue_" + std::to_string(atma::platform::current_process_id());
+	atma::interprocess_queue_t::remove(name.c_str());
+
+	auto Q = atma::interprocess_queue_t::open(name.c_str(), 256);
+	REQUIRE(Q);
+
+	GIVEN("a writer that died with an allocation uncommitted")
+	{
+		pid_t child = fork();
+		if (child == 0)
+		{
+			auto Q2 = atma::interprocess_queue_t::open(name.c_str(), 256);
+
+			// allocated, not committed
+			auto A = Q2->allocate(4);
+			A.encode_uint32(99);
+
+			Q2->with_allocation(4, [](auto& A) { A.encode_uint32(5); });
+			_exit(0);
+		}
+
+		int status = 0;
+		waitpid(child, &status, 0);
+		CHECK(Q->attachments() == 2);
+
+		THEN("readers are stuck behind it until a survivor recovers it")
+		{
+			CHECK(!Q->with_consumption([](auto&) {}));
+
+			Q->recover();
+			CHECK(Q->attachments() == 1);
+
+			uint32 x = 0;
+			CHECK(Q->with_consumption([&](auto& D) { D.decode_uint32(x); }));
+			CHECK(x == 5);
+		}
+	}
+
+	GIVEN("a reader that died mid-read")
+	{
+		for (uint32 i = 1; i != 3; ++i)
+			Q->with_allocation(4, [i](auto& A) { A.encode_uint32(i); });
+
+		pid_t child = fork();
+		if (child == 0)
+		{
+			auto Q2 = atma::interprocess_queue_t::open(name.c_str(), 256);
+
+			// consumed, not finalized
+			auto D = Q2->consume();
+			_exit(0);
+		}
+
+		int status = 0;
+		waitpid(child, &status, 0);
+		CHECK(Q->attachments() == 2);
+
+		THEN("a survivor recovers it, and the buffer can be gone around again")
+		{
+			Q->recover();
+			CHECK(Q->attachments() == 1);
+
+			uint32 x = 0;
+			CHECK(Q->with_consumption([&](auto& D) { D.decode_uint32(x); }));
+			CHECK(x == 2);
+
+			for (uint32 i = 0; i != 100; ++i)
+			{
+				Q->with_allocation(16, [i](auto& A) { A.encode_uint32(i); });
+
+				CHECK(Q->with_consumption([&](auto& D) { D.decode_uint32(x); }));
+				CHECK(x == i);
+			}
+		}
+	}
+
+	Q.reset();
+	atma::interprocess_queue_t::remove(name.c_str());
+}
+#endif
@@ -5,11 +5,20 @@
 #include <atma/ranges/core.hpp>
 #include <atma/algorithm.hpp>
 #include <atma/utf/utf8_string.hpp>
+#include <atma/threading.hpp>
 
 #include <array>
+#include <string>
+#include <vector>
+#include <algorithm>
 #include <utility>
 #include <iostream>
 #include <concepts>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <functional>
 
 import atma.bind;
 //import atma.rope;
@@ -598,6 +607,148 @@ SCENARIO("internal rope-building routines are called")
 //
 // construction
 //
+namespace
+{
+	// the reference definition of a leaf's metrics, one utf8-char at a time
+	auto reference_leaf_text_info(char const* str, size_t sz) -> atma::_rope_::leaf_text_info_t
+	{
+		atma::_rope_::leaf_text_info_t r;
+
+		atma::utf8_char_t prev_char;
+		for (auto x : atma::utf8_const_range_t{str, str + sz})
+		{
+			r.bytes += (uint16_t)x.size_bytes();
+			++r.characters;
+
+			bool const is_followon_lf = (x == '\n') && (prev_char == '\r');
+			if (atma::utf8_char_is_newline(x) && !is_followon_lf)
+				++r.line_breaks;
+
+			prev_char = x;
+		}
+
+		return r;
+	}
+
+	auto available_leaf_text_info_kernels() -> std::vector<std::pair<char const*, atma::_rope_::leaf_text_info_kernel_t>>
+	{
+		std::vector<std::pair<char const*, atma::_rope_::leaf_text_info_kernel_t>> result{
+			{"scalar", &atma::_rope_::leaf_text_info_scalar}};
+
+#if ATMA_ROPE_SIMD_X64
+		if (atma::_rope_::cpu_has_sse42())
+			result.push_back({"sse4.2", &atma::_rope_::leaf_text_info_sse42});
+		if (atma::_rope_::cpu_has_avx2())
+			result.push_back({"avx2", &atma::_rope_::leaf_text_info_avx2});
+#endif
+
+		return result;
+	}
+}
+
+SCENARIO("leaf text-metric kernels are used")
+{
+	GIVEN("text of mixed-width characters and line-breaks straddling every stride boundary")
+	{
+		std::string text;
+		for (size_t i = 0; i != 40; ++i)
+		{
+			text.append(passage, i * 7 % passage_size);
+			text.append(i % 3 ? "\r\n" : "\r");
+			text.append(i % 2 ? "\xc3\xa9t\xc3\xa9" : "\xe2\x82\xac\n\x0b");
+			text.append("\f\xf0\x9f\x98\x80\r");
+		}
+
+		THEN("every kernel agrees with the reference for every sub-range")
+		{
+			for (auto const& [name, kernel] : available_leaf_text_info_kernels())
+			{
+				CAPTURE(name);
+
+				for (size_t begin = 0; begin < text.size(); begin += 13)
+				{
+					// only begin & end on character boundaries
+					if ((text[begin] & 0xc0) == 0x80)
+						continue;
+
+					for (size_t size : {0, 1, 15, 16, 17, 31, 32, 33, 64, 200, 512})
+					{
+						size_t end = std::min(begin + size, text.size());
+						while (end < text.size() && (text[end] & 0xc0) == 0x80)
+							++end;
+
+						auto const expected = reference_leaf_text_info(text.data() + begin, end - begin);
+						auto const actual = kernel(text.data() + begin, end - begin);
+
+						CHECK(actual.bytes == expected.bytes);
+						CHECK(actual.characters == expected.characters);
+						CHECK(actual.line_breaks == expected.line_breaks);
+					}
+				}
+			}
+		}
+	}
+
+	GIVEN("text too long for one leaf's metrics, with a crlf at every 4kb boundary")
+	{
+		std::string text(0x1000 - 1, 'a');
+		while (text.size() < 0x20000)
+		{
+			text.append("\r\n");
+			text.append(0x1000 - 2, 'a');
+		}
+
+		THEN("it's counted in runs, each crlf once")
+		{
+			auto const info = atma::_rope_::text_info_t::from_str(text.data(), text.size());
+			CHECK(info.bytes == text.size());
+			CHECK(info.characters == text.size());
+			CHECK(info.line_breaks == std::ranges::count(text, '\r'));
+		}
+	}
+}
+
+SCENARIO("leaf text-metric kernels are benchmarked at the default buf_size")
+{
+	GIVEN("a document cut into leaves of the default buf_size")
+	{
+		constexpr size_t leaf_size = atma::rope_default_traits::buf_size;
+
+		std::string document;
+		while (document.size() < 256 * leaf_size)
+			document.append(passage, passage_size);
+
+		THEN("every kernel computes the same metrics, and we report how long it took")
+		{
+			auto const expected = reference_leaf_text_info(document.data(), leaf_size);
+
+			// include the reference, which walks utf8-chars, as a baseline
+			auto kernels = available_leaf_text_info_kernels();
+			kernels.insert(kernels.begin(), {"utf8-char reference", &reference_leaf_text_info});
+
+			for (auto const& [name, kernel] : kernels)
+			{
+				constexpr size_t iterations = 64;
+
+				size_t characters = 0;
+				auto const start = std::chrono::steady_clock::now();
+				for (size_t i = 0; i != iterations; ++i)
+					for (size_t leaf = 0; leaf + leaf_size <= document.size(); leaf += leaf_size)
+						characters += kernel(document.data() + leaf, leaf_size).characters;
+				auto const elapsed = std::chrono::steady_clock::now() - start;
+
+				auto const leaves = iterations * (document.size() / leaf_size);
+				auto const nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+				MESSAGE(name << ": " << (double)nanoseconds / leaves << "ns per leaf");
+
+				CHECK(kernel(document.data(), leaf_size).characters == expected.characters);
+				CHECK(kernel(document.data(), leaf_size).line_breaks == expected.line_breaks);
+				CHECK(characters > 0);
+			}
+		}
+	}
+}
+
 SCENARIO("user constructs a rope")
 {
 	WHEN("a rope is default-constructed")
@@ -692,6 +843,72 @@ SCENARIO("user invokes operator == with arguments (rope, rope)")
 			}
 		}
 	}
+
+	GIVEN("a rope constructed from a known passage")
+	AND_GIVEN("a second rope of the same passage, concatenated a couple of characters at a time")
+	{
+		// each of the first rope's leaves spans several of the second's
+		test_rope_t rope1{passage, passage_size};
+		test_rope_t rope2;
+		for (size_t i = 0; i < passage_size; i += 2)
+			rope2.append(test_rope_t{passage + i, std::min<size_t>(2, passage_size - i)});
+
+		REQUIRE(rope2.stats().leaf_count > rope1.stats().leaf_count * 2);
+
+		WHEN("the two ropes are compared with the equality operator, either way around")
+		THEN("they evaluate as equal")
+		{
+			CHECK(rope1 == rope2);
+			CHECK(rope2 == rope1);
+		}
+
+		WHEN("the second rope has one character changed, anywhere")
+		THEN("they evaluate as *not* equal")
+		{
+			for (size_t i = 0; i != passage_size; ++i)
+			{
+				CAPTURE(i);
+
+				auto changed = rope2;
+				changed.erase(i, 1);
+				changed.insert(i, "~", 1);
+
+				CHECK_FALSE(rope1 == changed);
+				CHECK_FALSE(changed == rope1);
+			}
+		}
+	}
+
+	GIVEN("a rope, and copies of it sharing all but the nodes around one edit")
+	{
+		std::string document;
+		for (size_t i = 0; i != 8; ++i)
+			document.append(passage, passage_size);
+
+		test_rope_t const rope{document.data(), document.size()};
+
+		WHEN("the edit is a character changed, anywhere")
+		THEN("they evaluate as *not* equal, but equal once it's changed back")
+		{
+			for (size_t i = 0; i < document.size(); i += 7)
+			{
+				CAPTURE(i);
+
+				auto changed = rope;
+				changed.erase(i, 1);
+				changed.insert(i, "~", 1);
+
+				CHECK_FALSE(rope == changed);
+				CHECK_FALSE(changed == rope);
+
+				changed.erase(i, 1);
+				changed.insert(i, document.data() + i, 1);
+
+				CHECK(rope == changed);
+				CHECK(changed == rope);
+			}
+		}
+	}
 }
 
 //
@@ -796,6 +1013,309 @@ SCENARIO("user erases some of the rope")
 	}
 }
 
+SCENARIO("user erases ranges of the rope")
+{
+	// naive line-break count, treating CRLF as one line-break
+	auto line_breaks_of = [](std::string_view text)
+	{
+		size_t result = 0;
+		for (size_t i = 0; i != text.size(); ++i)
+		{
+			if (text[i] == '\n' && i != 0 && text[i - 1] == '\r')
+				continue;
+
+			if (text[i] == '\r' || text[i] == '\n')
+				++result;
+		}
+		return result;
+	};
+
+	GIVEN("a rope of traits <4, 9> constructed from a passage")
+	{
+		WHEN("we erase any range")
+		THEN("the rope is valid and equivalent to the erased passage")
+		{
+			for (size_t e : {1, 3, 8, 9, 10, 30, 100, 300})
+			{
+				for (size_t i = 0; i + e <= passage_size; i += 3)
+				{
+					CAPTURE(e);
+					CAPTURE(i);
+
+					test_rope_t rope{passage, passage_size};
+					rope.erase(i, e);
+
+					std::string comp_passage{passage, passage_size};
+					comp_passage.erase(i, e);
+
+					CHECK(atma::_rope_::validate_rope_(rope.root()));
+					CHECK(rope.size() == comp_passage.size());
+					CHECK(rope.root().info().line_breaks == line_breaks_of(comp_passage));
+					CHECK(rope == comp_passage);
+				}
+			}
+		}
+
+		WHEN("we erase the whole rope")
+		{
+			test_rope_t rope{passage, passage_size};
+			rope.erase(0, passage_size);
+
+			THEN("the rope is empty")
+			{
+				CHECK(rope.size() == 0);
+				CHECK(rope.size_bytes() == 0);
+			}
+		}
+	}
+
+	GIVEN("a rope of traits <4, 9> with a CR and LF separated by other text")
+	{
+		char const* text = "abcdefgh\rXYZ\nijklmnop\rqrstuvwx\ryz";
+
+		WHEN("we erase the text between the CR and LF")
+		THEN("they are joined into one line-break")
+		{
+			for (size_t i = 0; i != strlen(text); ++i)
+			{
+				for (size_t e = 1; i + e <= strlen(text); ++e)
+				{
+					CAPTURE(i);
+					CAPTURE(e);
+
+					test_rope_t rope{text, strlen(text)};
+					rope.erase(i, e);
+
+					std::string comp_text{text};
+					comp_text.erase(i, e);
+
+					CHECK(atma::_rope_::validate_rope_(rope.root()));
+					CHECK(rope.root().info().line_breaks == line_breaks_of(comp_text));
+					CHECK(rope == comp_text);
+				}
+			}
+		}
+	}
+
+	GIVEN("a rope of default traits constructed from a large document")
+	{
+		std::string document;
+		for (size_t i = 0; i != 10'000; ++i)
+			document.append(passage, passage_size);
+
+		atma::rope_t rope{document.data(), document.size()};
+		atma::rope_t const original = rope;
+
+		WHEN("we erase a few characters from the middle")
+		{
+			rope.erase(document.size() / 2, 5);
+			document.erase(document.size() / 2, 5);
+
+			THEN("all but one leaf is shared with the original rope")
+			{
+				CHECK(rope == document);
+
+				size_t leaf_count = 0;
+				size_t shared_leaf_count = 0;
+				atma::_rope_::basic_leaf_iterator_t<atma::rope_default_traits> i{rope}, j{original}, end;
+				for ( ; i != end && j != end; ++i, ++j, ++leaf_count)
+				{
+					if (i->node_pointer() == j->node_pointer())
+						++shared_leaf_count;
+				}
+
+				CHECK(leaf_count - shared_leaf_count <= 1);
+			}
+		}
+
+		WHEN("we erase a large range spanning many leaves")
+		{
+			rope.erase(1'000, 200'000);
+			document.erase(1'000, 200'000);
+
+			THEN("the rope is valid and equivalent to the erased document")
+			{
+				CHECK(atma::_rope_::validate_rope_(rope.root()));
+				CHECK(rope.root().info().line_breaks == line_breaks_of(document));
+				CHECK(rope == document);
+			}
+		}
+	}
+}
+
+SCENARIO("user concatenates two ropes")
+{
+	GIVEN("a passage split at any index into two ropes of traits <4, 9>")
+	{
+		WHEN("the two ropes are concatenated")
+		THEN("the result is valid and equivalent to the passage")
+		{
+			for (size_t i = 0; i != passage_size + 1; ++i)
+			{
+				CAPTURE(i);
+
+				test_rope_t lhs{passage, i};
+				test_rope_t rhs{passage + i, passage_size - i};
+
+				auto r = lhs + rhs;
+
+				CHECK(atma::_rope_::validate_rope_(r.root()));
+				CHECK(r.size() == passage_size);
+				CHECK(r.root().info().line_breaks == passage_line_breaks);
+				CHECK(r == passage);
+
+				// operands are untouched
+				CHECK(lhs == std::string_view{passage, i});
+				CHECK(rhs == std::string_view{passage + i, passage_size - i});
+			}
+		}
+	}
+
+	GIVEN("a rope ending with CR and a rope starting with LF")
+	{
+		test_rope_t lhs{"abcdef\r", 7};
+		test_rope_t rhs{"\nghijkl", 7};
+
+		WHEN("the ropes are appended")
+		{
+			lhs.append(rhs);
+
+			THEN("the CRLF pair counts as one line-break")
+			{
+				CHECK(lhs == "abcdef\r\nghijkl");
+				CHECK(lhs.root().info().line_breaks == 1);
+				CHECK(lhs.line_count() == 2);
+			}
+		}
+	}
+
+	GIVEN("two large ropes of default traits")
+	{
+		std::string document;
+		for (size_t i = 0; i != 10'000; ++i)
+			document.append(passage, passage_size);
+
+		atma::rope_t lhs{document.data(), document.size()};
+		atma::rope_t rhs{document.data(), document.size() / 3};
+
+		WHEN("the ropes are concatenated")
+		{
+			auto r = lhs + rhs;
+
+			THEN("every leaf of both ropes is shared by the result")
+			{
+				CHECK(atma::_rope_::validate_rope_(r.root()));
+				CHECK(r.size() == lhs.size() + rhs.size());
+				CHECK(r == document + document.substr(0, document.size() / 3));
+
+				using leaf_iterator_t = atma::_rope_::basic_leaf_iterator_t<atma::rope_default_traits>;
+
+				size_t operand_leaves = 0;
+				std::vector<void const*> operand_nodes;
+				for (auto const* x : {&lhs, &rhs})
+					for (leaf_iterator_t i{*x}, end; i != end; ++i, ++operand_leaves)
+						operand_nodes.push_back(&i->node());
+
+				size_t shared_leaves = 0;
+				size_t idx = 0;
+				for (leaf_iterator_t i{r}, end; i != end; ++i, ++idx)
+					if (idx < operand_nodes.size() && operand_nodes[idx] == &i->node())
+						++shared_leaves;
+
+				CHECK(idx == operand_leaves);
+				CHECK(shared_leaves == operand_leaves);
+			}
+		}
+	}
+}
+
+SCENARIO("user edits copies of a rope that share nodes")
+{
+	std::string document;
+	for (size_t i = 0; i != 4; ++i)
+		document.append(passage, passage_size);
+
+	auto text_of = [](test_rope_t const& rope) {
+		std::string result;
+		rope.for_all_text([&result](std::string_view str) { result.append(str); });
+		return result;
+	};
+
+	GIVEN("copies of a rope, each with a different amount erased from its end")
+	{
+		// erasing from the end keeps the nodes along the right edge, but
+		// addresses fewer of their children
+		test_rope_t const base{document.data(), document.size()};
+
+		std::vector<test_rope_t> copies;
+		for (size_t n = 1; n != 200; ++n)
+		{
+			auto& copy = copies.emplace_back(base);
+			copy.erase(copy.size() - n, n);
+		}
+
+		THEN("each copy's text stops where the copy does")
+		{
+			for (size_t n = 1; n != 200; ++n)
+				CHECK(text_of(copies[n - 1]) == document.substr(0, document.size() - n));
+
+			CHECK(text_of(base) == document);
+		}
+
+		WHEN("each copy is appended to")
+		{
+			for (auto& copy : copies)
+				copy.insert(copy.size(), "QQ\n", 3);
+
+			THEN("the new text follows the copy's own, and nothing it erased")
+			{
+				for (size_t n = 1; n != 200; ++n)
+					CHECK(text_of(copies[n - 1]) == document.substr(0, document.size() - n) + "QQ\n");
+
+				CHECK(text_of(base) == document);
+			}
+		}
+	}
+
+	GIVEN("a rope, and copies of it each edited differently in turn")
+	{
+		test_rope_t const base{document.data(), document.size()};
+
+		// each copy may append children to nodes it shares with the original,
+		// which outlive the copy. later copies mustn't see them
+		THEN("each copy has only its own edits, and the original is unchanged")
+		{
+			std::mt19937 rng{1};
+			for (size_t trial = 0; trial != 400; ++trial)
+			{
+				CAPTURE(trial);
+
+				auto copy = base;
+				auto copy_document = document;
+
+				for (size_t edit = 0; edit != 1 + trial % 6; ++edit)
+				{
+					size_t const char_idx = rng() % copy_document.size();
+					if (rng() % 2)
+					{
+						copy.insert(char_idx, "QQ\n", 3);
+						copy_document.insert(char_idx, "QQ\n");
+					}
+					else
+					{
+						size_t const size = std::min<size_t>(rng() % 20, copy_document.size() - char_idx);
+						copy.erase(char_idx, size);
+						copy_document.erase(char_idx, size);
+					}
+				}
+
+				REQUIRE(text_of(copy) == copy_document);
+				REQUIRE(text_of(base) == document);
+			}
+		}
+	}
+}
+
 SCENARIO("user calls rope_t::insert at a valid index")
 {
 	GIVEN("a rope of traits <4, 9> constructed from a passage")
@@ -845,6 +1365,34 @@ SCENARIO("user calls rope_t::insert at a valid index")
 			}
 		}
 	}
+
+	GIVEN("a rope constructed from a passage")
+	{
+		test_rope_t const rope{passage, passage_size};
+
+		// erasing the front of a leaf views its buffer from part-way in
+		WHEN("we erase a little, then insert just after it")
+		{
+			THEN("the inserted text is where we put it, and the rest is unchanged")
+			{
+				for (size_t i = 0; i + 3 < passage_size; ++i)
+				{
+					CAPTURE(i);
+
+					auto edited = rope;
+					edited.erase(i, 2);
+					edited.insert(i + 1, "zx", 2);
+
+					std::string expected{passage, passage_size};
+					expected.erase(i, 2);
+					expected.insert(i + 1, "zx");
+
+					CHECK(edited == expected.c_str());
+					CHECK(rope == passage);
+				}
+			}
+		}
+	}
 }
 
 SCENARIO("user calls rope_t::split at a valid index")
@@ -883,6 +1431,1918 @@ SCENARIO("user calls rope_t::split at a valid index")
 			}
 		}
 	}
+
+	GIVEN("a rope of several passages")
+	{
+		std::string document;
+		for (size_t i = 0; i != 4; ++i)
+			document.append(passage, passage_size);
+
+		test_rope_t rope{document.data(), document.size()};
+
+		WHEN("we split the rope at either end")
+		{
+			auto [front_left, front_right] = rope.split(0);
+			auto [back_left, back_right] = rope.split(rope.size());
+
+			THEN("one side is empty, and the other is the whole rope")
+			{
+				CHECK(front_left.size() == 0);
+				CHECK(front_right == std::string_view{document});
+				CHECK(back_left == std::string_view{document});
+				CHECK(back_right.size() == 0);
+
+				CHECK(atma::_rope_::validate_rope_(front_right.root()));
+				CHECK(atma::_rope_::validate_rope_(back_left.root()));
+			}
+		}
+	}
 }
 
 
+
+SCENARIO("user constructs a rope larger than 64k characters")
+{
+	GIVEN("a document of tens of millions of characters")
+	{
+		// ~20 million characters, made up of our passage repeated
+		size_t const repeats = 20'000'000 / passage_size;
+
+		std::string document;
+		document.reserve(repeats * passage_size);
+		for (size_t i = 0; i != repeats; ++i)
+			document.append(passage, passage_size);
+
+		AND_GIVEN("a rope of default traits constructed from that document")
+		{
+			atma::rope_t rope{document.data(), document.size()};
+
+			THEN("the aggregated metrics of the rope are correct")
+			{
+				CHECK(rope.size() == document.size());
+				CHECK(rope.size_bytes() == document.size());
+				CHECK(rope.root().info().line_breaks == repeats * passage_line_breaks);
+				CHECK(atma::_rope_::validate_rope_(rope.root()));
+				CHECK(rope == document);
+			}
+
+			WHEN("we insert text into the middle of the rope")
+			{
+				size_t const idx = document.size() / 2 + 3;
+				rope.insert(idx, insert_fragment, insert_fragment_size);
+				document.insert(idx, insert_fragment, insert_fragment_size);
+
+				THEN("the rope is equivalent to the modified document")
+				{
+					CHECK(rope.size() == document.size());
+					CHECK(rope.root().info().line_breaks == repeats * passage_line_breaks + 3);
+					CHECK(atma::_rope_::validate_rope_(rope.root()));
+					CHECK(rope == document);
+				}
+			}
+
+			WHEN("we split the rope far past the 64k mark")
+			{
+				size_t const idx = document.size() - 100'000;
+				auto [left, right] = rope.split(idx);
+
+				THEN("both halves are addressed correctly")
+				{
+					CHECK(left.size() == idx);
+					CHECK(right.size() == 100'000);
+					CHECK(atma::_rope_::validate_rope_(left.root()));
+					CHECK(atma::_rope_::validate_rope_(right.root()));
+					CHECK(left == atma::xfer_src(document.data(), document.size()).to(idx));
+					CHECK(right == atma::xfer_src(document.data(), document.size()).from(idx));
+				}
+			}
+		}
+
+		AND_GIVEN("a default-constructed rope")
+		{
+			atma::rope_t rope;
+
+			WHEN("we push_back the document in passage-sized pieces")
+			{
+				for (size_t i = 0; i != repeats; ++i)
+					rope.push_back(passage, passage_size);
+
+				THEN("the rope is equivalent to the document")
+				{
+					CHECK(rope.size() == document.size());
+					CHECK(rope.root().info().line_breaks == repeats * passage_line_breaks);
+					CHECK(rope == document);
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("user bulk-builds a rope across several threads")
+{
+	GIVEN("a document of several megabytes")
+	{
+		size_t const repeats = 4'000'000 / passage_size;
+
+		std::string document;
+		document.reserve(repeats * passage_size);
+		for (size_t i = 0; i != repeats; ++i)
+			document.append(passage, passage_size);
+
+		THEN("ropes built with any number of threads are equivalent to the document")
+		{
+			using leaf_iterator_t = atma::_rope_::basic_leaf_iterator_t<atma::rope_default_traits>;
+
+			for (size_t thread_count : {1, 2, 3, 8})
+			{
+				CAPTURE(thread_count);
+
+				atma::rope_t rope{atma::xfer_src(document.data(), document.size()), thread_count};
+
+				CHECK(atma::_rope_::validate_rope_(rope.root()));
+				CHECK(rope.size() == document.size());
+				CHECK(rope.root().info().line_breaks == repeats * passage_line_breaks);
+				CHECK(rope == document);
+
+				// leaves are filled to capacity, except the last of each partition. leaves
+				// may also fall a few bytes short so as to not split utf8 or crlf pairs
+				size_t underfull_leaves = 0;
+				for (leaf_iterator_t i{rope}, end; i != end; ++i)
+					if (i->info().bytes + 3 < atma::rope_default_traits::buf_edit_max_size)
+						++underfull_leaves;
+
+				CHECK(underfull_leaves <= thread_count);
+			}
+		}
+	}
+}
+
+SCENARIO("rope nodes are recycled through the node pool")
+{
+	GIVEN("a document of a few hundred kilobytes")
+	{
+		std::string document;
+		for (size_t i = 0; i != 200; ++i)
+			document.append(passage, passage_size);
+
+		auto edit_a_rope = [&]
+		{
+			atma::rope_t rope{document.data(), document.size()};
+
+			for (size_t i = 0; i != 500; ++i)
+			{
+				size_t const idx = (i * 7919) % rope.size();
+				rope.insert(idx, insert_fragment, insert_fragment_size);
+				rope.erase(idx / 2, insert_fragment_size);
+			}
+
+			return rope.size();
+		};
+
+		WHEN("a rope is built, edited, and destroyed")
+		{
+			auto const before = atma::_rope_::node_pool_stats<atma::rope_default_traits>();
+			edit_a_rope();
+			auto const after = atma::_rope_::node_pool_stats<atma::rope_default_traits>();
+
+			MESSAGE("node allocations: " << (after.allocations - before.allocations)
+				<< ", upstream slab allocations: " << (after.slab_allocations - before.slab_allocations));
+
+			THEN("every node is returned to the pool")
+			{
+				CHECK(after.allocations > before.allocations);
+				CHECK(after.live_blocks() == before.live_blocks());
+				CHECK(after.slab_allocations - before.slab_allocations < (after.allocations - before.allocations) / 100);
+			}
+
+			AND_WHEN("the same work is done again")
+			{
+				edit_a_rope();
+				auto const again = atma::_rope_::node_pool_stats<atma::rope_default_traits>();
+
+				MESSAGE("node allocations: " << (again.allocations - after.allocations)
+					<< ", upstream slab allocations: " << (again.slab_allocations - after.slab_allocations));
+
+				THEN("nodes are recycled without going upstream")
+				{
+					CHECK(again.live_blocks() == before.live_blocks());
+					CHECK(again.slab_allocations == after.slab_allocations);
+				}
+			}
+		}
+
+		WHEN("ropes are built and edited on many threads, and destroyed on others")
+		{
+			auto const before = atma::_rope_::node_pool_stats<atma::rope_default_traits>();
+
+			std::vector<std::optional<atma::rope_t>> ropes(8);
+			{
+				std::vector<std::thread> threads;
+				for (size_t i = 0; i != ropes.size(); ++i)
+					threads.emplace_back([&, i] {
+						ropes[i].emplace(document.data(), document.size());
+						ropes[i]->insert(i * 1000, insert_fragment, insert_fragment_size);
+					});
+
+				for (auto& t : threads)
+					t.join();
+			}
+
+			auto const during = atma::_rope_::node_pool_stats<atma::rope_default_traits>();
+
+			{
+				std::vector<std::thread> threads;
+				for (size_t i = 0; i != ropes.size(); ++i)
+					threads.emplace_back([&, i] { ropes[ropes.size() - 1 - i].reset(); });
+
+				for (auto& t : threads)
+					t.join();
+			}
+
+			auto const after = atma::_rope_::node_pool_stats<atma::rope_default_traits>();
+
+			THEN("every node is returned to the pool")
+			{
+				CHECK(during.live_blocks() > before.live_blocks());
+				CHECK(after.live_blocks() == before.live_blocks());
+			}
+		}
+	}
+}
+
+SCENARIO("user types into a rope nobody else is sharing")
+{
+	GIVEN("a rope of default traits, and a mirror of its text")
+	{
+		std::string document;
+		for (size_t i = 0; i != 40; ++i)
+			document.append(passage, passage_size);
+
+		atma::rope_t rope{document.data(), document.size()};
+
+		// leaves are built full, so the first keystroke splits the leaf
+		size_t idx = document.size() / 2 + 5;
+		rope.insert(idx, "x", 1);
+		document.insert(idx, "x");
+		++idx;
+
+		WHEN("we type and backspace in the same place")
+		{
+			auto const before = atma::_rope_::node_pool_stats<atma::rope_default_traits>();
+
+			for (char const* x = "hello,\r\nworld"; *x; ++x, ++idx)
+			{
+				rope.insert(idx, x, 1);
+				document.insert(idx, 1, *x);
+			}
+
+			for (size_t i = 0; i != 4; ++i)
+			{
+				--idx;
+				rope.erase(idx, 1);
+				document.erase(idx, 1);
+			}
+
+			auto const after = atma::_rope_::node_pool_stats<atma::rope_default_traits>();
+
+			THEN("no nodes are allocated, and the rope is still correct")
+			{
+				CHECK(after.allocations == before.allocations);
+				CHECK(atma::_rope_::validate_rope_(rope.root()));
+				CHECK(rope.root().info().line_breaks == 40 * passage_line_breaks + 1);
+				CHECK(rope == document);
+			}
+		}
+
+		WHEN("we type into the rope while a copy of it is alive")
+		{
+			atma::rope_t const copy = rope;
+			std::string const copy_document = document;
+
+			for (char const* x = "hello, world"; *x; ++x, ++idx)
+			{
+				rope.insert(idx, x, 1);
+				document.insert(idx, 1, *x);
+			}
+
+			rope.erase(idx - 3, 2);
+			document.erase(idx - 3, 2);
+
+			THEN("the copy is unaffected")
+			{
+				CHECK(atma::_rope_::validate_rope_(rope.root()));
+				CHECK(rope == document);
+
+				CHECK(atma::_rope_::validate_rope_(copy.root()));
+				CHECK(copy == copy_document);
+			}
+		}
+	}
+}
+
+namespace
+{
+	// the char-idx of each non-overlapping occurrence, as std::string finds them
+	auto occurrences_of(std::string const& text, std::string_view needle) -> std::vector<size_t>
+	{
+		auto is_leading = [](char x) { return (x & 0xc0) != 0x80; };
+
+		std::vector<size_t> result;
+		size_t byte_idx = 0, char_idx = 0;
+		for (size_t i = text.find(needle); i != std::string::npos; i = text.find(needle, i + needle.size()))
+		{
+			char_idx += std::count_if(text.begin() + byte_idx, text.begin() + i, is_leading);
+			byte_idx = i;
+			result.push_back(char_idx);
+		}
+
+		return result;
+	}
+}
+
+SCENARIO("user searches a rope")
+{
+	char const* needles[] = {
+		"the", "\n", "e", "captain", "petrol \nstation", "zebra",
+		"food court.\ngood evening", "\xe2\x82\xac\xc3\xa9", "\xc3\xa9!",
+	};
+
+	GIVEN("a rope of tiny leaves, so most matches straddle leaves")
+	{
+		std::string document;
+		for (size_t i = 0; i != 3; ++i)
+		{
+			document.append(passage, passage_size);
+			document.append("\xe2\x82\xac\xc3\xa9!");
+		}
+
+		// a needle longer than several leaves
+		std::string const long_needle = document.substr(40, 100);
+
+		test_rope_t rope{document.data(), document.size()};
+
+		auto char_idx_of = [&](size_t byte_idx) -> size_t
+			{ return byte_idx == std::string::npos ? test_rope_t::npos : std::count_if(document.begin(), document.begin() + byte_idx, [](char x) { return (x & 0xc0) != 0x80; }); };
+
+		auto byte_idx_of = [&](size_t char_idx) -> size_t
+			{ return atma::utf8_charseq_idx_to_byte_idx(document.data(), document.size(), char_idx); };
+
+		THEN("find and rfind agree with std::string from every position")
+		{
+			std::vector<std::string_view> all_needles{std::begin(needles), std::end(needles)};
+			all_needles.push_back(long_needle);
+
+			for (auto needle : all_needles)
+			{
+				CAPTURE(needle);
+
+				for (size_t i = 0; i <= rope.size(); ++i)
+				{
+					CHECK(rope.find(needle, i) == char_idx_of(document.find(needle, byte_idx_of(i))));
+					CHECK(rope.rfind(needle, i) == char_idx_of(document.rfind(needle, byte_idx_of(i))));
+				}
+
+				CHECK(rope.rfind(needle) == char_idx_of(document.rfind(needle)));
+			}
+		}
+
+		THEN("find_all visits every non-overlapping occurrence")
+		{
+			for (std::string_view needle : needles)
+			{
+				CAPTURE(needle);
+
+				std::vector<size_t> found;
+				for (auto const& match : rope.find_all(needle))
+					found.push_back(match.char_idx);
+
+				CHECK(found == occurrences_of(document, needle));
+			}
+		}
+	}
+
+	GIVEN("a rope of default traits constructed from a large document")
+	{
+		std::string document;
+		for (size_t i = 0; i != 20'000; ++i)
+			document.append(passage, passage_size);
+
+		atma::rope_t rope{document.data(), document.size()};
+
+		THEN("find_all visits every occurrence throughout the document")
+		{
+			for (std::string_view needle : {"captain", "push us", "food court.\ngood evening"})
+			{
+				CAPTURE(needle);
+
+				std::vector<size_t> found;
+				for (auto const& match : rope.find_all(needle))
+					found.push_back(match.char_idx);
+
+				CHECK(found.size() >= 19'999);
+				CHECK(found == occurrences_of(document, needle));
+			}
+		}
+	}
+}
+
+SCENARIO("user walks a rope with a cursor")
+{
+	std::string document;
+	for (size_t i = 0; i != 3; ++i)
+	{
+		document.append(passage, passage_size);
+		document.append("\xe2\x82\xac\xc3\xa9!");
+	}
+
+	// the characters of the document, by char-idx
+	std::vector<std::string_view> characters;
+	for (char const* i = document.data(), *ie = i + document.size(); i != ie; i += atma::utf8_char_size_bytes(i))
+		characters.emplace_back(i, atma::utf8_char_size_bytes(i));
+
+	auto as_view = [](atma::utf8_char_t const& x) { return std::string(x.data(), x.size_bytes()); };
+
+	GIVEN("a rope of tiny leaves")
+	{
+		test_rope_t rope{document.data(), document.size()};
+		REQUIRE(rope.size() == characters.size());
+
+		THEN("stepping forwards visits every character, then the end")
+		{
+			auto cursor = rope.cursor();
+			for (size_t i = 0; i != characters.size(); ++i)
+			{
+				CAPTURE(i);
+				REQUIRE(cursor.char_idx() == i);
+				CHECK(as_view(*cursor) == characters[i]);
+				REQUIRE(cursor.next_char());
+			}
+
+			CHECK(cursor.at_end());
+			CHECK_FALSE(cursor.next_char());
+			CHECK(cursor.char_idx() == rope.size());
+		}
+
+		THEN("stepping backwards from the end visits every character")
+		{
+			auto cursor = rope.cursor(rope.size());
+			for (size_t i = characters.size(); i-- != 0; )
+			{
+				CAPTURE(i);
+				REQUIRE(cursor.prev_char());
+				REQUIRE(cursor.char_idx() == i);
+				CHECK(as_view(*cursor) == characters[i]);
+			}
+
+			CHECK_FALSE(cursor.prev_char());
+			CHECK(cursor.char_idx() == 0);
+		}
+
+		THEN("leaf spans tile the document in both directions")
+		{
+			auto cursor = rope.cursor();
+
+			std::string forwards;
+			do
+			{
+				auto const span = cursor.leaf_span();
+				CHECK(cursor.leaf_char_idx() == cursor.char_idx());
+				forwards.append(span.data(), span.size());
+			} while (cursor.next_leaf() && !cursor.at_end());
+
+			CHECK(forwards == document);
+
+			std::string backwards;
+			while (cursor.prev_leaf())
+			{
+				auto const span = cursor.leaf_span();
+				backwards.insert(0, span.data(), span.size());
+			}
+
+			CHECK(backwards == document);
+			CHECK(cursor.char_idx() == 0);
+		}
+
+		THEN("seeking lands on the same character stepping does")
+		{
+			auto cursor = rope.cursor();
+			for (size_t i : {size_t(0), size_t(17), size_t(3), characters.size() - 1, size_t(200), characters.size(), size_t(1)})
+			{
+				CAPTURE(i);
+				cursor.seek(i);
+				CHECK(cursor.char_idx() == i);
+
+				if (i != characters.size())
+					CHECK(as_view(*cursor) == characters[i]);
+				else
+					CHECK(cursor.at_end());
+			}
+		}
+	}
+
+	GIVEN("an empty rope")
+	{
+		test_rope_t rope;
+
+		THEN("the cursor is at the end, and cannot move")
+		{
+			auto cursor = rope.cursor();
+			CHECK(cursor.at_end());
+			CHECK(cursor.leaf_span().empty());
+			CHECK_FALSE(cursor.next_char());
+			CHECK_FALSE(cursor.prev_char());
+			CHECK_FALSE(cursor.next_leaf());
+			CHECK_FALSE(cursor.prev_leaf());
+		}
+	}
+}
+
+namespace
+{
+	template <typename RT>
+	auto to_string(atma::basic_rope_t<RT> const& rope) -> std::string
+	{
+		std::string result;
+		rope.for_all_text([&result](std::string_view str) { result.append(str); });
+		return result;
+	}
+
+	// rebuilds rhs by splicing the changed ranges of rhs into lhs
+	auto apply_changes(std::string const& lhs, std::string const& rhs, std::vector<atma::rope_change_t> const& changes) -> std::string
+	{
+		auto byte_idx_of = [](std::string const& str, size_t char_idx)
+			{ return atma::utf8_charseq_idx_to_byte_idx(str.data(), str.size(), char_idx); };
+
+		std::string result;
+		size_t lhs_char_idx = 0;
+		for (auto const& change : changes)
+		{
+			REQUIRE(lhs_char_idx <= change.lhs_char_idx);
+
+			result.append(lhs, byte_idx_of(lhs, lhs_char_idx), byte_idx_of(lhs, change.lhs_char_idx) - byte_idx_of(lhs, lhs_char_idx));
+
+			size_t const rhs_begin = byte_idx_of(rhs, change.rhs_char_idx);
+			result.append(rhs, rhs_begin, byte_idx_of(rhs, change.rhs_char_idx + change.rhs_characters) - rhs_begin);
+
+			lhs_char_idx = change.lhs_char_idx + change.lhs_characters;
+		}
+
+		result.append(lhs, byte_idx_of(lhs, lhs_char_idx));
+		return result;
+	}
+}
+
+SCENARIO("user hashes and diffs ropes")
+{
+	std::string document;
+	for (size_t i = 0; i != 40; ++i)
+		document.append(passage, passage_size);
+
+	GIVEN("two ropes of the same text, structured differently")
+	{
+		test_rope_t whole{document.data(), document.size()};
+		test_rope_t halves = test_rope_t{document.data(), 1000} + test_rope_t{document.data() + 1000, document.size() - 1000};
+
+		THEN("their hashes are equal, and differ from that of any other text")
+		{
+			CHECK(whole.hash() == halves.hash());
+			CHECK(whole == halves);
+			CHECK(atma::diff(whole, halves).empty());
+
+			auto other_document = document;
+			other_document[2000] = '!';
+			test_rope_t other{other_document.data(), other_document.size()};
+
+			CHECK(other.hash() != whole.hash());
+			CHECK_FALSE(other == whole);
+		}
+	}
+
+	GIVEN("a rope, and a copy of it edited in several places")
+	{
+		test_rope_t original{document.data(), document.size()};
+
+		auto edited = original;
+		edited.insert(100, "xyz", 3);
+		edited.erase(5000, 30);
+		edited.insert(edited.size() - 50, "\xe2\x82\xac\r", 4);
+
+		auto const edited_document = to_string(edited);
+
+		THEN("the diff holds little more than the edits, and rebuilds the edited text")
+		{
+			auto const changes = atma::diff(original, edited);
+			CHECK(changes.size() == 3);
+
+			size_t changed_characters = 0;
+			for (auto const& change : changes)
+				changed_characters += change.lhs_characters + change.rhs_characters;
+			CHECK(changed_characters <= 3 + 30 + 2);
+
+			CHECK(apply_changes(document, edited_document, changes) == edited_document);
+			CHECK(apply_changes(to_string(edited), document, atma::diff(edited, original)) == document);
+		}
+
+		THEN("hashing both ropes only hashes the edited copy's new nodes")
+		{
+			auto const original_hash = original.hash();
+			CHECK(edited.hash() == test_rope_t{edited_document.data(), edited_document.size()}.hash());
+			CHECK(edited.hash() != original_hash);
+			CHECK(apply_changes(document, edited_document, atma::diff(original, edited)) == edited_document);
+		}
+
+		THEN("undoing an edit restores the hash")
+		{
+			auto const original_hash = original.hash();
+
+			auto reverted = original;
+			reverted.insert(700, "zebra", 5);
+			reverted.erase(700, 5);
+
+			CHECK(reverted.hash() == original_hash);
+			CHECK(reverted == original);
+			CHECK(atma::diff(original, reverted).empty());
+		}
+	}
+
+	GIVEN("a hashed rope nobody else is sharing")
+	{
+		test_rope_t rope{document.data(), document.size()};
+		rope.hash();
+
+		WHEN("it's edited in place")
+		{
+			rope.insert(300, "abc", 3);
+			rope.erase(900, 4);
+
+			THEN("its hash is of its new text")
+			{
+				auto const text = to_string(rope);
+				CHECK(rope.hash() == test_rope_t{text.data(), text.size()}.hash());
+			}
+		}
+	}
+
+	GIVEN("many copies of one rope, each edited differently")
+	{
+		std::string const base_document = document.substr(0, 6000);
+		test_rope_t const base{base_document.data(), base_document.size()};
+
+		// copies share, and append to, the same nodes as each other
+		THEN("each copy has only its own edits, and diffs against the original")
+		{
+			std::mt19937 rng{1};
+			for (size_t trial = 0; trial != 400; ++trial)
+			{
+				CAPTURE(trial);
+
+				auto copy = base;
+				auto copy_document = base_document;
+
+				for (size_t edit = 0; edit != 1 + trial % 6; ++edit)
+				{
+					size_t const char_idx = rng() % copy_document.size();
+					if (rng() % 2)
+					{
+						copy.insert(char_idx, "QQ\n", 3);
+						copy_document.insert(char_idx, "QQ\n");
+					}
+					else
+					{
+						size_t const size = std::min<size_t>(rng() % 20, copy_document.size() - char_idx);
+						copy.erase(char_idx, size);
+						copy_document.erase(char_idx, size);
+					}
+				}
+
+				REQUIRE(to_string(copy) == copy_document);
+				REQUIRE(apply_changes(base_document, copy_document, atma::diff(base, copy)) == copy_document);
+			}
+
+			CHECK(to_string(base) == base_document);
+		}
+	}
+
+	GIVEN("two unrelated ropes")
+	{
+		std::string const lhs = "the quick brown \xe2\x82\xac fox jumps over the lazy dog";
+		std::string const rhs = "the quick red \xc3\xa9 fox leaps over the lazy cat!";
+
+		THEN("the diff still rebuilds one from the other")
+		{
+			auto const changes = atma::diff(test_rope_t{lhs.data(), lhs.size()}, test_rope_t{rhs.data(), rhs.size()});
+			CHECK(apply_changes(lhs, rhs, changes) == rhs);
+			CHECK(apply_changes(rhs, lhs, atma::diff(test_rope_t{rhs.data(), rhs.size()}, test_rope_t{lhs.data(), lhs.size()})) == lhs);
+		}
+	}
+}
+
+SCENARIO("user keeps a history of a rope")
+{
+	std::string document;
+	for (size_t i = 0; i != 40; ++i)
+		document.append(passage, passage_size);
+
+	test_rope_t rope{document.data(), document.size()};
+	atma::basic_rope_history_t<atma::rope_test_traits> history{rope};
+
+	// each version types a few characters somewhere new
+	std::vector<std::string> texts{document};
+	for (size_t i = 0; i != 200; ++i)
+	{
+		size_t const char_idx = (i * 7919) % rope.size();
+		rope.insert(char_idx, "ab", 2);
+		history.snapshot(rope);
+
+		texts.push_back(texts.back());
+		texts.back().insert(char_idx, "ab");
+	}
+
+	GIVEN("a history of many versions")
+	{
+		REQUIRE(history.version_count() == texts.size());
+
+		THEN("undo & redo step through every version")
+		{
+			for (size_t i = texts.size(); i-- != 0; )
+			{
+				CHECK(to_string(history.current()) == texts[i]);
+				CHECK(history.undo() == (i != 0));
+			}
+
+			for (size_t i = 0; i != texts.size(); ++i)
+			{
+				CHECK(to_string(history.current()) == texts[i]);
+				CHECK(history.redo() == (i + 1 != texts.size()));
+			}
+		}
+
+		THEN("a snapshot after undoing discards what could have been redone")
+		{
+			history.undo();
+			history.undo();
+			rope = history.current();
+			rope.erase(0, 10);
+			history.snapshot(rope);
+
+			CHECK(history.version_count() == texts.size() - 1);
+			CHECK_FALSE(history.can_redo());
+			CHECK(history.undo());
+			CHECK(to_string(history.current()) == texts[texts.size() - 3]);
+		}
+
+		THEN("versions cost little more than their edits")
+		{
+			size_t const one_version = atma::basic_rope_history_t<atma::rope_test_traits>{test_rope_t{document.data(), document.size()}}.memory_usage();
+
+			// the newest version is shared with our rope, and the others
+			// only own the few nodes along the path to their edit
+			CHECK(history.unique_bytes(history.current_version()) == 0);
+			for (size_t i = 1; i + 1 != history.version_count(); ++i)
+			{
+				CAPTURE(i);
+				CHECK(history.unique_bytes(i) > 0);
+				CHECK(history.unique_bytes(i) < one_version / 20);
+			}
+
+			CHECK(history.memory_usage() < one_version * 6);
+		}
+
+		THEN("compacting to a budget coalesces the oldest versions")
+		{
+			size_t const usage = history.memory_usage();
+			size_t const budget = usage * 3 / 4;
+
+			size_t const compacted_usage = history.compact(budget);
+			CHECK(compacted_usage <= budget);
+			CHECK(compacted_usage == history.memory_usage());
+			CHECK(history.version_count() < texts.size());
+
+			// the newest versions remain, and undo then returns to the first
+			size_t const kept = history.version_count() - 1;
+			for (size_t i = 0; i != kept; ++i)
+			{
+				CHECK(to_string(history.current()) == texts[texts.size() - 1 - i]);
+				history.undo();
+			}
+
+			CHECK_FALSE(history.can_undo());
+			CHECK(to_string(history.current()) == document);
+		}
+
+		THEN("a budget of nothing keeps only the first and current versions")
+		{
+			history.compact(0);
+			CHECK(history.version_count() == 2);
+			CHECK(to_string(history.current()) == texts.back());
+		}
+	}
+}
+
+namespace
+{
+	// the utf-16 offset of every character, and of the end
+	auto utf16_offsets_of(std::string const& str) -> std::vector<size_t>
+	{
+		std::vector<size_t> result{0};
+		for (size_t i = 0; i != str.size(); )
+		{
+			size_t const size = atma::utf8_char_size_bytes(str.data() + i);
+			result.push_back(result.back() + (size == 4 ? 2 : 1));
+			i += size;
+		}
+
+		return result;
+	}
+}
+
+SCENARIO("user addresses a rope in utf-16 code-units")
+{
+	using utf16_test_traits = atma::rope_basic_traits<4, 9, true, atma::rope_pool_allocator_t<std::byte>, atma::rope_utf16_summary_t>;
+	using utf16_rope_t = atma::basic_rope_t<utf16_test_traits>;
+
+	std::string document;
+	for (size_t i = 0; i != 30; ++i)
+		document += (i % 2)
+			? "caf\xc3\xa9 \xf0\x9f\x98\x80 costs 5\xe2\x82\xac, \xf0\x9f\x8d\xb0\xf0\x9f\x8d\xb0 extra\n"
+			: "caf\xc3\xa9 \xf0\x9f\x98\x80 costs 5\xe2\x82\xac, \xf0\x9f\x8d\xb0\xf0\x9f\x8d\xb0 extra\r\n";
+
+	auto check_against = [](utf16_rope_t const& rope, std::string const& text)
+	{
+		auto const offsets = utf16_offsets_of(text);
+		REQUIRE(offsets.size() == rope.size() + 1);
+
+		CHECK(rope.summary().code_units == offsets.back());
+
+		for (size_t i = 0; i != offsets.size(); ++i)
+			CHECK(rope.summary_before(i).code_units == offsets[i]);
+
+		// an offset within a surrogate-pair is the character it's part of
+		for (size_t i = 0; i != rope.size(); ++i)
+		{
+			for (size_t offset = offsets[i]; offset != offsets[i + 1]; ++offset)
+				CHECK(rope.char_idx_of_metric(&atma::rope_utf16_summary_t::code_units, offset) == i);
+		}
+
+		CHECK(rope.char_idx_of_metric(&atma::rope_utf16_summary_t::code_units, offsets.back()) == rope.size());
+		CHECK(rope.char_idx_of_metric(&atma::rope_utf16_summary_t::code_units, offsets.back() + 100) == rope.size());
+	};
+
+	GIVEN("a rope with a crlf")
+	{
+		utf16_rope_t rope{"a\r\nb", 4};
+
+		THEN("the cr and lf are a code-unit each")
+		{
+			CHECK(rope.char_idx_of_metric(&atma::rope_utf16_summary_t::code_units, 1) == 1);
+			CHECK(rope.char_idx_of_metric(&atma::rope_utf16_summary_t::code_units, 2) == 2);
+			CHECK(rope.char_idx_of_metric(&atma::rope_utf16_summary_t::code_units, 3) == 3);
+			CHECK(rope.summary_before(3).code_units == 3);
+		}
+	}
+
+	GIVEN("a rope of text with characters beyond the basic multilingual plane")
+	{
+		utf16_rope_t rope{document.data(), document.size()};
+
+		THEN("utf-16 offsets and char-indices convert both ways")
+		{
+			check_against(rope, document);
+		}
+
+		WHEN("copies of the rope are edited")
+		{
+			std::mt19937 rng{1234};
+
+			char const* insertions[] = {"\xf0\x9f\x98\x80", "x", "\xe2\x82\xac\xe2\x82\xac", "ab\n", "\r\n"};
+
+			for (size_t trial = 0; trial != 20; ++trial)
+			{
+				auto edited = rope;
+				auto text = document;
+
+				for (size_t i = 0; i != 8; ++i)
+				{
+					size_t const char_idx = rng() % (edited.size() + 1);
+					size_t const byte_idx = atma::utf8_charseq_idx_to_byte_idx(text.data(), text.size(), char_idx);
+
+					if (rng() % 2)
+					{
+						char const* str = insertions[rng() % std::size(insertions)];
+						edited.insert(char_idx, str, strlen(str));
+						text.insert(byte_idx, str);
+					}
+					else
+					{
+						size_t const characters = std::min<size_t>(rng() % 12, edited.size() - char_idx);
+						edited.erase(char_idx, characters);
+						text.erase(byte_idx, atma::utf8_charseq_idx_to_byte_idx(text.data(), text.size(), char_idx + characters) - byte_idx);
+					}
+				}
+
+				REQUIRE(to_string(edited) == text);
+				check_against(edited, text);
+			}
+
+			THEN("the original is unchanged")
+			{
+				check_against(rope, document);
+			}
+		}
+	}
+}
+
+namespace
+{
+	// a summary that counts the work done computing it: a unit for each
+	// byte of text, and for each pair of summaries added up
+	struct counted_summary_t
+	{
+		size_t bytes = 0;
+
+		inline static size_t work = 0;
+
+		static auto from_str(char const*, size_t size) -> counted_summary_t
+		{
+			work += size;
+			return {size};
+		}
+	};
+
+	inline auto operator + (counted_summary_t const& lhs, counted_summary_t const& rhs) -> counted_summary_t
+	{
+		++counted_summary_t::work;
+		return {lhs.bytes + rhs.bytes};
+	}
+
+	inline auto operator - (counted_summary_t const& lhs, counted_summary_t const& rhs) -> counted_summary_t
+	{
+		return {lhs.bytes - rhs.bytes};
+	}
+}
+
+SCENARIO("summaries of a node shared between views are cached for each")
+{
+	using T = atma::rope_basic_traits<4, 9, true, atma::rope_pool_allocator_t<std::byte>, counted_summary_t>;
+
+	GIVEN("a branch, viewed with different numbers of its children")
+	{
+
+		std::vector<atma::_rope_::tree_t<T>> leaves;
+		for (size_t i = 0; i != 4; ++i)
+			leaves.emplace_back(atma::_rope_::make_leaf_ptr<T>(atma::xfer_src(passage + i * 4, 4)));
+
+		auto const node = atma::_rope_::make_internal_ptr<T>(2u, leaves[0], leaves[1], leaves[2], leaves[3]);
+
+		// views of the first 2, 3, and 4 children
+		std::vector<atma::_rope_::tree_t<T>> views;
+		for (uint32_t n = 2; n <= 4; ++n)
+			views.emplace_back(atma::_rope_::text_info_t::from_str(passage, n * 4), n, node);
+
+		WHEN("each view is summarised")
+		{
+			for (auto const& view : views)
+				CHECK(atma::_rope_::tree_summary_(view).bytes == view.size_bytes());
+
+			THEN("summarising them again does no work, as every view was cached")
+			{
+				counted_summary_t::work = 0;
+
+				for (auto const& view : views)
+					CHECK(atma::_rope_::tree_summary_(view).bytes == view.size_bytes());
+
+				CHECK(counted_summary_t::work == 0);
+			}
+		}
+	}
+}
+
+namespace
+{
+	// every piece of work gets its own thread
+	struct test_work_provider_t
+	{
+		~test_work_provider_t()
+		{
+			for (auto& x : threads)
+				x.join();
+		}
+
+		auto enqueue(std::function<void()> f) -> void
+		{
+			++enqueued;
+			threads.emplace_back(std::move(f));
+		}
+
+		std::vector<std::thread> threads;
+		size_t enqueued = 0;
+	};
+}
+
+SCENARIO("user maps and reduces a rope in parallel")
+{
+	std::string document;
+	for (size_t i = 0; i != 2000; ++i)
+		document.append(passage, passage_size);
+
+	GIVEN("a rope of a large document")
+	{
+		test_rope_t rope{document.data(), document.size()};
+		test_work_provider_t provider;
+
+		THEN("parallel_for_all_text visits all the text exactly once")
+		{
+			std::atomic<size_t> bytes = 0;
+			std::atomic<size_t> line_breaks = 0;
+			rope.parallel_for_all_text(provider, [&](std::string_view str) {
+				bytes += str.size();
+				line_breaks += std::ranges::count(str, '\n');
+			});
+
+			CHECK(provider.enqueued > 0);
+			CHECK(bytes == document.size());
+			CHECK(line_breaks == size_t(std::ranges::count(document, '\n')));
+		}
+
+		THEN("parallel_reduce combines results in order")
+		{
+			auto text = rope.parallel_reduce(provider, std::string{},
+				[](std::string_view str) { return std::string{str}; },
+				[](std::string lhs, std::string const& rhs) { return lhs + rhs; });
+
+			CHECK(text == document);
+		}
+
+		THEN("parallel_reduce of an edited copy sees only that copy's text")
+		{
+			auto edited = rope;
+			edited.erase(100, 5000);
+			edited.insert(20000, "hello", 5);
+
+			auto expected = document;
+			expected.erase(100, 5000);
+			expected.insert(20000, "hello");
+
+			auto text = edited.parallel_reduce(provider, std::string{},
+				[](std::string_view str) { return std::string{str}; },
+				[](std::string lhs, std::string const& rhs) { return lhs + rhs; });
+
+			CHECK(text == expected);
+		}
+
+		THEN("an exception thrown by a task is rethrown once every task is done")
+		{
+			std::atomic<size_t> visits = 0;
+			auto run = [&] {
+				rope.parallel_for_all_text(provider, [&](std::string_view) {
+					if (visits++ == 10)
+						throw std::runtime_error{"nope"};
+				});
+			};
+
+			CHECK_THROWS_AS(run(), std::runtime_error);
+
+			// the rope is fine to use afterwards
+			CHECK(rope.parallel_reduce(provider, size_t(0), [](std::string_view str) { return str.size(); }, std::plus<>{}) == document.size());
+		}
+	}
+
+	GIVEN("a rope of a large document, and a thread-pool")
+	{
+		test_rope_t rope{document.data(), document.size()};
+		atma::thread_pool_t pool{4};
+
+		THEN("parallel_reduce runs on the pool")
+		{
+			auto text = rope.parallel_reduce(pool, std::string{},
+				[](std::string_view str) { return std::string{str}; },
+				[](std::string lhs, std::string const& rhs) { return lhs + rhs; });
+
+			CHECK(text == document);
+		}
+
+		THEN("an exception thrown by a task on the pool is rethrown here")
+		{
+			CHECK_THROWS_AS(rope.parallel_for_all_text(pool, [](std::string_view) { throw std::runtime_error{"nope"}; }), std::runtime_error);
+		}
+	}
+
+	GIVEN("an empty rope")
+	{
+		test_rope_t rope;
+		test_work_provider_t provider;
+
+		THEN("parallel_reduce is the identity")
+		{
+			CHECK(rope.parallel_reduce(provider, size_t(7), [](std::string_view str) { return str.size(); }, std::plus<>{}) == 7);
+			CHECK(provider.enqueued == 0);
+		}
+	}
+}
+
+SCENARIO("user rebalances a fragmented rope")
+{
+	std::string document;
+	for (size_t i = 0; i != 40; ++i)
+		document.append(passage, passage_size);
+
+	GIVEN("a freshly built rope")
+	{
+		test_rope_t rope{document.data(), document.size()};
+		auto const stats = rope.stats();
+
+		THEN("its leaves are (nearly) all full, and nothing is shared")
+		{
+			CHECK(stats.bytes == document.size());
+			CHECK(stats.height == rope.root().height());
+			CHECK(stats.leaf_fill_ratio() > 0.9);
+			CHECK(stats.shared_count == 0);
+
+			size_t leaves = 0;
+			for (auto x : stats.leaf_fill_histogram)
+				leaves += x;
+			CHECK(leaves == stats.leaf_count);
+		}
+
+		THEN("rebalancing does nothing")
+		{
+			CHECK(rope.rebalance(~size_t()) == rope.size());
+			CHECK(rope.stats().leaf_count == stats.leaf_count);
+		}
+	}
+
+	GIVEN("a rope, and a copy of it that's had a lot of small edits")
+	{
+		test_rope_t original{document.data(), document.size()};
+		auto rope = original;
+		auto text = document;
+
+		// a character here, a few there
+		for (size_t i = 0; i != 1500; ++i)
+		{
+			size_t const char_idx = (i * 7919) % (rope.size() - 4);
+			if (i % 4 == 0)
+			{
+				rope.insert(char_idx, "x", 1);
+				text.insert(char_idx, "x");
+			}
+			else
+			{
+				rope.erase(char_idx, 3);
+				text.erase(char_idx, 3);
+			}
+		}
+
+		auto const before = rope.stats();
+		REQUIRE(to_string(rope) == text);
+
+		THEN("the copy is fragmented, and shares nodes with the original")
+		{
+			CHECK(before.leaf_fill_ratio() < 0.8);
+			CHECK(before.shared_count > 0);
+			CHECK(before.shared_node_ratio() > 0.0);
+		}
+
+		WHEN("it's rebalanced a little at a time")
+		{
+			size_t calls = 0;
+			for (size_t char_idx = 0; char_idx != rope.size(); ++calls)
+			{
+				char_idx = rope.rebalance(200, char_idx);
+				REQUIRE(to_string(rope) == text);
+			}
+
+			auto const after = rope.stats();
+
+			THEN("it has the same text in fewer, fuller leaves")
+			{
+				CHECK(calls > 1);
+				CHECK(atma::_rope_::validate_rope_(rope.root()));
+				CHECK(after.leaf_count < before.leaf_count);
+				CHECK(after.leaf_fill_ratio() > before.leaf_fill_ratio() + 0.05);
+				CHECK(rope.line_count() == size_t(std::ranges::count(text, '\n')) + 1);
+			}
+
+			THEN("its internal nodes are fuller too")
+			{
+				CHECK(after.internal_count < before.internal_count);
+				CHECK(after.internal_fill_ratio() > before.internal_fill_ratio() + 0.03);
+			}
+
+			THEN("the original is untouched")
+			{
+				CHECK(to_string(original) == document);
+				CHECK(original.stats().leaf_fill_ratio() > 0.9);
+			}
+		}
+	}
+}
+
+SCENARIO("user navigates a rope by line")
+{
+	// naive line-starts of some text, treating CRLF as one line-break
+	auto line_starts_of = [](std::string_view text)
+	{
+		std::vector<size_t> result{0};
+		for (size_t i = 0; i != text.size(); ++i)
+		{
+			if (text[i] == '\r' && i + 1 != text.size() && text[i + 1] == '\n')
+				++i;
+
+			if (text[i] == '\r' || text[i] == '\n')
+				result.push_back(i + 1);
+		}
+		return result;
+	};
+
+	auto line_of_naive = [](std::vector<size_t> const& line_starts, size_t char_idx)
+	{
+		return size_t(std::upper_bound(line_starts.begin(), line_starts.end(), char_idx) - line_starts.begin() - 1);
+	};
+
+	GIVEN("a rope of traits <4, 9> constructed from a passage")
+	{
+		test_rope_t rope{passage, passage_size};
+		auto const line_starts = line_starts_of(passage);
+
+		THEN("the rope has one more line than line-breaks")
+		{
+			CHECK(rope.line_count() == passage_line_breaks + 1);
+			CHECK(rope.line_count() == line_starts.size());
+		}
+
+		WHEN("we ask for the character index of every line")
+		THEN("it is where that line begins")
+		{
+			for (size_t i = 0; i != rope.line_count(); ++i)
+				CHECK(rope.char_idx_of_line(i) == line_starts[i]);
+		}
+
+		WHEN("we ask for the line of every character")
+		THEN("it is the line the character resides upon")
+		{
+			for (size_t i = 0; i != passage_size + 1; ++i)
+				CHECK(rope.line_of_char_idx(i) == line_of_naive(line_starts, i));
+		}
+
+		WHEN("we iterate lines 2 through 5")
+		THEN("each line is addressed by its extents")
+		{
+			size_t expected_line = 2;
+			for (auto const& line : rope.lines(2, 5))
+			{
+				CHECK(line.line_idx == expected_line);
+				CHECK(line.char_idx == line_starts[expected_line]);
+				CHECK(line.characters == line_starts[expected_line + 1] - line_starts[expected_line]);
+				++expected_line;
+			}
+
+			CHECK(expected_line == 5);
+		}
+
+		WHEN("we iterate all lines")
+		THEN("the lines cover the whole rope")
+		{
+			size_t acc_chars = 0;
+			for (auto const& line : rope.lines(0, rope.line_count()))
+			{
+				CHECK(line.char_idx == acc_chars);
+				acc_chars += line.characters;
+			}
+
+			CHECK(acc_chars == rope.size());
+		}
+	}
+
+	GIVEN("a rope of traits <4, 9> constructed from text with CRLF line-breaks")
+	{
+		char const* text = "abc\r\ndefghijkl\r\n\r\nmnop\rq\nrstuvwxyz\r\n";
+		test_rope_t rope{text, strlen(text)};
+		auto const line_starts = line_starts_of(text);
+
+		THEN("CRLF pairs are one line-break")
+		{
+			CHECK(rope.line_count() == line_starts.size());
+
+			for (size_t i = 0; i != rope.line_count(); ++i)
+				CHECK(rope.char_idx_of_line(i) == line_starts[i]);
+
+			for (size_t i = 0; i != strlen(text) + 1; ++i)
+				CHECK(rope.line_of_char_idx(i) == line_of_naive(line_starts, i));
+		}
+	}
+
+	GIVEN("a rope of default traits constructed from a large document")
+	{
+		std::string document;
+		for (size_t i = 0; i != 20'000; ++i)
+			document.append(passage, passage_size);
+
+		atma::rope_t rope{document.data(), document.size()};
+		auto const line_starts = line_starts_of(document);
+
+		THEN("lines are found throughout the document")
+		{
+			CHECK(rope.line_count() == line_starts.size());
+
+			for (size_t i = 0; i < rope.line_count(); i += 997)
+			{
+				CHECK(rope.char_idx_of_line(i) == line_starts[i]);
+				CHECK(rope.line_of_char_idx(line_starts[i]) == i);
+			}
+
+			CHECK(rope.line_of_char_idx(rope.size()) == rope.line_count() - 1);
+		}
+	}
+}
+
+namespace
+{
+	// views a std::string as though it were mapped, and tells us when the
+	// last rope lets go of it
+	struct test_mapped_text_t : atma::rope_mapped_text_t
+	{
+		test_mapped_text_t(std::string const& text, bool& released)
+			: atma::rope_mapped_text_t{text.data(), text.size()}
+			, released{released}
+		{}
+
+		~test_mapped_text_t() override { released = true; }
+
+		bool& released;
+	};
+}
+
+SCENARIO("user builds a rope over mapped text")
+{
+	std::string document;
+	for (size_t i = 0; i != 40; ++i)
+		document.append(passage, passage_size);
+
+	std::string const pristine = document;
+
+	GIVEN("a rope built over mapped text, and a rope built from a copy of it")
+	{
+		bool released = false;
+		auto source = atma::rope_mapped_text_ptr{new test_mapped_text_t{document, released}};
+
+		auto rope = std::make_optional<test_rope_t>(source);
+		test_rope_t copied{document.data(), document.size()};
+
+		THEN("they have the same text, but the mapped rope views it in far fewer leaves")
+		{
+			CHECK(*rope == copied);
+			CHECK(*rope == pristine.c_str());
+			CHECK(rope->hash() == copied.hash());
+			CHECK(rope->line_count() == copied.line_count());
+			CHECK(rope->stats().leaf_count * 100 < copied.stats().leaf_count);
+		}
+
+		THEN("building it over several threads gives the same rope")
+		{
+			test_rope_t const threaded{source, 4};
+			CHECK(threaded == *rope);
+			CHECK(threaded.hash() == rope->hash());
+		}
+
+		WHEN("it's edited once")
+		{
+			size_t const leaves_before = rope->stats().leaf_count;
+			rope->insert(rope->size() / 2, "x", 1);
+			copied.insert(copied.size() / 2, "x", 1);
+
+			THEN("only the text around the edit is copied out of the mapping")
+			{
+				CHECK(*rope == copied);
+				CHECK(rope->stats().leaf_count <= leaves_before + 4);
+			}
+		}
+
+		WHEN("it's split, and appended to a plain rope, and they're edited once")
+		{
+			auto [left, right] = rope->split(rope->size() / 2);
+			size_t const right_leaves_before = right.stats().leaf_count;
+			right.insert(right.size() / 2, "x", 1);
+
+			test_rope_t plain{"ab", 2};
+			plain.append(*rope);
+			size_t const plain_leaves_before = plain.stats().leaf_count;
+			plain.insert(2 + rope->size() / 2, "x", 1);
+			copied.insert(rope->size() / 2, "x", 1);
+
+			THEN("each still copies only the text around the edit")
+			{
+				CHECK(right.stats().leaf_count <= right_leaves_before + 4);
+				CHECK(plain.stats().leaf_count <= plain_leaves_before + 4);
+				CHECK(plain == (test_rope_t{"ab", 2} + copied));
+			}
+		}
+
+		WHEN("it's written as a tree, and read back")
+		{
+			std::vector<char> storage(document.size() * 2);
+			atma::memory_bytestream_t out{storage.data(), storage.size()};
+			auto const wr = rope->write_to(out, atma::rope_stream_format_t::tree);
+			REQUIRE(wr.status == atma::stream_status_t::good);
+
+			atma::memory_bytestream_t in{storage.data(), wr.bytes_written};
+			test_rope_t result;
+			auto const rr = result.read_from(in, atma::rope_stream_format_t::tree);
+
+			THEN("the large leaves come back as they were, and don't need the mapping")
+			{
+				CHECK(rr.status == atma::stream_status_t::good);
+				CHECK(result == *rope);
+				CHECK(result.stats().leaf_count == rope->stats().leaf_count);
+
+				source.reset();
+				rope.reset();
+				CHECK(released);
+				CHECK(result == pristine.c_str());
+			}
+
+			THEN("they're still only copied around an edit")
+			{
+				result.insert(result.size() / 2, "x", 1);
+				CHECK(result.stats().leaf_count <= rope->stats().leaf_count + 4);
+			}
+		}
+
+		THEN("at the default buf_size, the mapped rope costs a fraction of the copied rope")
+		{
+			using history_t = atma::basic_rope_history_t<atma::rope_default_traits>;
+
+			size_t const mapped_usage = history_t{atma::rope_t{source}}.memory_usage();
+			size_t const copied_usage = history_t{atma::rope_t{document.data(), document.size()}}.memory_usage();
+			CHECK(mapped_usage * 4 < copied_usage);
+		}
+
+		WHEN("both ropes are edited")
+		{
+			auto text = pristine;
+			for (size_t i = 0; i != 200; ++i)
+			{
+				size_t const char_idx = (i * 7919) % (rope->size() - 4);
+				if (i % 4 == 0)
+				{
+					rope->insert(char_idx, "x", 1);
+					copied.insert(char_idx, "x", 1);
+					text.insert(char_idx, "x");
+				}
+				else
+				{
+					rope->erase(char_idx, 3);
+					copied.erase(char_idx, 3);
+					text.erase(char_idx, 3);
+				}
+			}
+
+			THEN("the edits are made to copies, and the mapped text is untouched")
+			{
+				CHECK(*rope == text.c_str());
+				CHECK(*rope == copied);
+				CHECK(document == pristine);
+			}
+
+			THEN("the mapped rope can still be rebalanced")
+			{
+				for (size_t c = 0; c != rope->size(); )
+					c = rope->rebalance(64, c);
+
+				CHECK(*rope == text.c_str());
+			}
+		}
+
+		WHEN("the last reference is dropped")
+		{
+			auto halves = std::make_optional(rope->split(rope->size() / 2));
+			source.reset();
+			rope.reset();
+			CHECK(!released);
+
+			halves.reset();
+			THEN("the mapped text is released")
+			{
+				CHECK(released);
+			}
+		}
+	}
+
+	GIVEN("empty mapped text")
+	{
+		bool released = false;
+		std::string const empty;
+		auto source = atma::rope_mapped_text_ptr{new test_mapped_text_t{empty, released}};
+		test_rope_t rope{source};
+
+		THEN("the rope is empty")
+		{
+			CHECK(rope.size() == 0);
+			CHECK(rope == std::string_view{});
+		}
+	}
+}
+
+SCENARIO("user writes a rope to a bytestream, and reads it back")
+{
+	std::string document;
+	for (size_t i = 0; i != 40; ++i)
+		document.append(passage, passage_size);
+
+	// edit a copy, so that leaves view only parts of their buffers
+	test_rope_t rope{document.data(), document.size()};
+	auto text = document;
+	for (size_t i = 0; i != 300; ++i)
+	{
+		size_t const char_idx = (i * 7919) % (rope.size() - 4);
+		if (i % 3 == 0)
+		{
+			rope.insert(char_idx, "\r\n", 2);
+			text.insert(char_idx, "\r\n");
+		}
+		else
+		{
+			rope.erase(char_idx, 2);
+			text.erase(char_idx, 2);
+		}
+	}
+
+	REQUIRE(rope == std::string_view{text});
+
+	std::vector<char> storage(text.size() * 8);
+
+	GIVEN("a rope written as text")
+	{
+		atma::memory_bytestream_t out{storage.data(), storage.size()};
+		auto const wr = rope.write_to(out);
+
+		THEN("the stream holds exactly the text")
+		{
+			CHECK(wr.status == atma::stream_status_t::good);
+			CHECK(wr.bytes_written == text.size());
+			CHECK(std::string_view{storage.data(), wr.bytes_written} == text);
+		}
+
+		WHEN("it's read back, in chunks")
+		{
+			atma::memory_bytestream_t in{storage.data(), wr.bytes_written};
+
+			test_rope_t result;
+			auto const rr = result.read_from(in);
+
+			THEN("the rope is as though it were built from the text in one go")
+			{
+				test_rope_t const built{text.data(), text.size()};
+
+				CHECK(rr.status == atma::stream_status_t::good);
+				CHECK(rr.bytes_read == text.size());
+				CHECK(result == std::string_view{text});
+				CHECK(result.line_count() == built.line_count());
+				CHECK(result.stats().leaf_count == built.stats().leaf_count);
+			}
+		}
+
+		WHEN("the stream is too small")
+		{
+			std::vector<char> small(text.size() / 2);
+			atma::memory_bytestream_t small_out{small.data(), small.size()};
+			auto const small_wr = rope.write_to(small_out);
+
+			THEN("writing stops with an error")
+			{
+				CHECK(small_wr.status == atma::stream_status_t::error);
+				CHECK(small_wr.bytes_written == small.size());
+			}
+		}
+	}
+
+	GIVEN("a rope written as a tree")
+	{
+		atma::memory_bytestream_t out{storage.data(), storage.size()};
+		auto const wr = rope.write_to(out, atma::rope_stream_format_t::tree);
+		REQUIRE(wr.status == atma::stream_status_t::good);
+
+		WHEN("it's read back")
+		{
+			atma::memory_bytestream_t in{storage.data(), wr.bytes_written};
+
+			test_rope_t result;
+			auto const rr = result.read_from(in, atma::rope_stream_format_t::tree);
+
+			THEN("the tree has the same shape, and the same text")
+			{
+				auto const lhs = rope.stats();
+				auto const rhs = result.stats();
+
+				CHECK(rr.status == atma::stream_status_t::good);
+				CHECK(rr.bytes_read == wr.bytes_written);
+				CHECK(result == rope);
+				CHECK(result.hash() == rope.hash());
+				CHECK(result.line_count() == rope.line_count());
+				CHECK(rhs.height == lhs.height);
+				CHECK(rhs.leaf_count == lhs.leaf_count);
+				CHECK(rhs.internal_count == lhs.internal_count);
+			}
+
+			THEN("the rope can be edited as usual")
+			{
+				result.insert(5, "hello", 5);
+				result.erase(100, 50);
+				text.insert(5, "hello");
+				text.erase(100, 50);
+
+				CHECK(result == std::string_view{text});
+			}
+		}
+
+		WHEN("it's read back by a rope of different traits")
+		{
+			atma::memory_bytestream_t in{storage.data(), wr.bytes_written};
+
+			atma::rope_t result{"untouched", 9};
+			auto const rr = result.read_from(in, atma::rope_stream_format_t::tree);
+
+			THEN("reading fails, and the rope is untouched")
+			{
+				CHECK(rr.status == atma::stream_status_t::error);
+				CHECK(result == std::string_view{"untouched"});
+			}
+		}
+
+		WHEN("it's truncated")
+		{
+			atma::memory_bytestream_t in{storage.data(), wr.bytes_written - 10};
+
+			test_rope_t result{"untouched", 9};
+			auto const rr = result.read_from(in, atma::rope_stream_format_t::tree);
+
+			THEN("reading fails, and the rope is untouched")
+			{
+				CHECK(rr.status == atma::stream_status_t::error);
+				CHECK(result == std::string_view{"untouched"});
+			}
+		}
+
+		// the header, followed by a tree built by hand. internal nodes are
+		// given their child-count and the text-info they sum up to
+		auto rejected = [&](auto&& build, atma::rope_stream_checks_t checks = atma::rope_stream_checks_t::structure) {
+			std::vector<char> forged{storage.data(), storage.data() + 16};
+			auto branch = [&](uint32_t child_count, uint32_t bytes, uint32_t characters, uint32_t line_breaks) {
+				uint32_t const xs[] = {0, child_count, bytes, characters, line_breaks};
+				forged.insert(forged.end(), (char const*)xs, (char const*)(xs + 5));
+			};
+			auto leaf = [&](std::string_view text, uint32_t characters, uint32_t line_breaks) {
+				uint32_t const xs[] = {1, (uint32_t)text.size(), characters, line_breaks};
+				forged.insert(forged.end(), (char const*)xs, (char const*)(xs + 4));
+				forged.insert(forged.end(), text.begin(), text.end());
+			};
+			build(branch, leaf);
+
+			atma::memory_bytestream_t in{forged.data(), forged.size()};
+			test_rope_t result{"untouched", 9};
+			auto const rr = result.read_from(in, atma::rope_stream_format_t::tree, checks);
+			return rr.status == atma::stream_status_t::error && result == std::string_view{"untouched"};
+		};
+
+		auto const text_checks = atma::rope_stream_checks_t::text;
+
+		THEN("a forged tree that's well-formed reads fine")
+		{
+			CHECK(!rejected([](auto branch, auto leaf) { branch(2, 6, 6, 0); leaf("abc", 3, 0); leaf("def", 3, 0); }));
+			CHECK(!rejected([](auto branch, auto leaf) { branch(2, 6, 6, 0); leaf("abc", 3, 0); leaf("def", 3, 0); }, text_checks));
+		}
+
+		THEN("trees we couldn't have built ourselves are rejected")
+		{
+			// an internal node with too few children
+			CHECK(rejected([](auto branch, auto leaf) { branch(2, 6, 6, 0); branch(2, 4, 4, 0); leaf("ab", 2, 0); leaf("cd", 2, 0); branch(1, 2, 2, 0); leaf("ef", 2, 0); }));
+
+			// an empty leaf that isn't the root
+			CHECK(rejected([](auto branch, auto leaf) { branch(2, 3, 3, 0); leaf("abc", 3, 0); leaf("", 0, 0); }));
+
+			// a crlf split between leaves
+			CHECK(rejected([](auto branch, auto leaf) { branch(2, 6, 6, 2); leaf("ab\r", 3, 1); leaf("\ncd", 3, 1); }));
+
+			// a character split between leaves
+			CHECK(rejected([](auto branch, auto leaf) { branch(2, 6, 4, 0); leaf("ab\xc3", 3, 2); leaf("\xa9" "cd", 3, 2); }));
+
+			// text-info that no text of that size could have
+			CHECK(rejected([](auto branch, auto leaf) { branch(2, 6, 7, 0); leaf("abc", 4, 0); leaf("def", 3, 0); }));
+			CHECK(rejected([](auto branch, auto leaf) { branch(2, 6, 6, 4); leaf("abc", 3, 4); leaf("def", 3, 0); }));
+
+			// an internal node that doesn't sum up its children
+			CHECK(rejected([](auto branch, auto leaf) { branch(2, 6, 6, 1); leaf("abc", 3, 0); leaf("def", 3, 0); }));
+			CHECK(rejected([](auto branch, auto leaf) { branch(2, 7, 6, 0); leaf("abc", 3, 0); leaf("def", 3, 0); }));
+		}
+
+		THEN("text-info that doesn't match the text is only rejected when the text is checked")
+		{
+			auto miscounted = [](auto branch, auto leaf) { branch(2, 6, 5, 0); leaf("abc", 2, 0); leaf("def", 3, 0); };
+			auto misbroken = [](auto branch, auto leaf) { branch(2, 6, 6, 0); leaf("a\nc", 3, 0); leaf("def", 3, 0); };
+
+			CHECK(!rejected(miscounted));
+			CHECK(!rejected(misbroken));
+			CHECK(rejected(miscounted, text_checks));
+			CHECK(rejected(misbroken, text_checks));
+		}
+
+		THEN("the stream of an earlier version of the format is rejected")
+		{
+			std::vector<char> old{storage.data(), storage.data() + wr.bytes_written};
+			uint32_t const version = 1;
+			memcpy(old.data() + 4, &version, sizeof(version));
+
+			atma::memory_bytestream_t in{old.data(), old.size()};
+			test_rope_t result{"untouched", 9};
+			CHECK(result.read_from(in, atma::rope_stream_format_t::tree).status == atma::stream_status_t::error);
+			CHECK(result == std::string_view{"untouched"});
+		}
+	}
+}
+
+namespace
+{
+	// makes the edits one at a time, back to front, which is what
+	// apply_edits should be equivalent to
+	template <typename RT>
+	auto apply_edits_sequentially(atma::basic_rope_t<RT> rope, std::vector<atma::rope_edit_t> edits) -> atma::basic_rope_t<RT>
+	{
+		// the last of several edits at one char_idx goes first, so that they
+		// end up in the order given
+		std::ranges::stable_sort(edits, std::greater<>{}, &atma::rope_edit_t::char_idx);
+		for (size_t i = 0; i != edits.size(); )
+		{
+			size_t j = i;
+			while (j != edits.size() && edits[j].char_idx == edits[i].char_idx)
+				++j;
+
+			for (size_t k = j; k-- != i; )
+			{
+				if (edits[k].erase_characters)
+					rope.erase(edits[k].char_idx, edits[k].erase_characters);
+				if (!edits[k].text.empty())
+					rope.insert(edits[k].char_idx, edits[k].text.data(), edits[k].text.size());
+			}
+
+			i = j;
+		}
+
+		return rope;
+	}
+
+	// non-overlapping edits spread through size characters
+	auto random_edits(std::mt19937& rng, size_t size, size_t count, std::vector<std::string> const& texts) -> std::vector<atma::rope_edit_t>
+	{
+		std::vector<atma::rope_edit_t> result;
+
+		size_t const gap = std::max<size_t>(size / count, 1);
+		for (size_t char_idx = 0; char_idx <= size && result.size() != count; )
+		{
+			char_idx += rng() % gap;
+			if (char_idx > size)
+				break;
+
+			size_t const erase = std::min<size_t>(rng() % (gap * 2), size - char_idx);
+			result.push_back({char_idx, rng() % 3 == 0 ? 0 : erase, texts[rng() % texts.size()]});
+			char_idx += result.back().erase_characters;
+		}
+
+		std::ranges::shuffle(result, rng);
+		return result;
+	}
+}
+
+SCENARIO("user applies many edits at once")
+{
+	std::string document;
+	for (size_t i = 0; i != 40; ++i)
+		document.append(passage, passage_size);
+
+	std::vector<std::string> const texts = {
+		"", "x", "\r", "\n", "\r\n", "abc\r", "\ndef",
+		"a much longer insertion, spanning several leaves\r\n",
+		std::string(200, 'y')};
+
+	GIVEN("a rope")
+	{
+		test_rope_t const original{document.data(), document.size()};
+
+		WHEN("many random edits are applied")
+		THEN("the result is as though they were made one at a time")
+		{
+			std::mt19937 rng{1234};
+
+			for (size_t count : {1, 2, 10, 100, 400})
+			{
+				auto const edits = random_edits(rng, original.size(), count, texts);
+
+				auto rope = original;
+				rope.apply_edits(edits);
+
+				auto const expected = apply_edits_sequentially(original, edits);
+				CHECK(rope == expected);
+				CHECK(rope.size() == expected.size());
+				CHECK(rope.line_count() == expected.line_count());
+			}
+
+			CHECK(original == std::string_view{document});
+		}
+
+		WHEN("edits are applied at the same char_idx")
+		THEN("they're made in the order given")
+		{
+			auto rope = original;
+			std::vector<atma::rope_edit_t> edits = {{4, 0, "one "}, {4, 0, "two "}, {4, 2, "three "}};
+			rope.apply_edits(edits);
+
+			std::string_view const expected = "goodone two three vening, this";
+			CHECK(std::get<0>(rope.split(expected.size())) == expected);
+		}
+
+		WHEN("edits split and mend crlf pairs")
+		THEN("line-breaks are counted correctly")
+		{
+			std::string crlf_document;
+			for (size_t i = 0; i != 60; ++i)
+				crlf_document += "line\r\n";
+
+			test_rope_t crlf_rope{crlf_document.data(), crlf_document.size()};
+
+			// append a cr to every line, before the crlf, and an lf after it
+			std::vector<atma::rope_edit_t> edits;
+			for (size_t i = 0; i != 60; ++i)
+			{
+				edits.push_back({i * 5 + 4, 0, "\r"});
+				edits.push_back({i * 5 + 5, 0, "\n"});
+			}
+
+			auto const expected = apply_edits_sequentially(crlf_rope, edits);
+			crlf_rope.apply_edits(edits);
+
+			CHECK(crlf_rope == expected);
+			CHECK(crlf_rope.line_count() == expected.line_count());
+		}
+
+		WHEN("everything is erased")
+		THEN("the rope is empty, or whatever was inserted")
+		{
+			auto rope = original;
+			rope.apply_edits(std::vector<atma::rope_edit_t>{{0, rope.size(), ""}});
+			CHECK(rope.size() == 0);
+
+			rope = original;
+			rope.apply_edits(std::vector<atma::rope_edit_t>{{0, 10, "front"}, {10, rope.size() - 10, ""}, {rope.size(), 0, "back"}});
+			CHECK(rope == std::string_view{"frontback"});
+		}
+
+		WHEN("there are no edits, or edits that do nothing")
+		THEN("nothing changes")
+		{
+			auto rope = original;
+			rope.apply_edits({});
+			rope.apply_edits(std::vector<atma::rope_edit_t>{{7, 0, ""}});
+			CHECK(rope.root() == original.root());
+		}
+	}
+}
+
+SCENARIO("batched edits are benchmarked against sequential edits")
+{
+	GIVEN("a large document, with an edit at the front of every 20th line")
+	{
+		std::string document;
+		for (size_t i = 0; i != 4'000; ++i)
+			document.append(passage, passage_size);
+
+		atma::rope_t const original{document.data(), document.size()};
+
+		std::vector<atma::rope_edit_t> edits;
+		for (size_t line = 0; line + 1 < original.line_count(); line += 20)
+			edits.push_back({original.char_idx_of_line(line), 4, "// "});
+
+		THEN("both give the same result, and we report how long each took")
+		{
+			auto time = [](auto&& f) {
+				auto const start = std::chrono::steady_clock::now();
+				f();
+				return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+			};
+
+			// sequential edits copy the spine for every edit when the rope's
+			// shared (with an undo-history, say), and edit in place when it isn't
+			auto shared = original;
+			auto const shared_us = time([&] { shared = apply_edits_sequentially(shared, edits); });
+
+			auto unshared = atma::rope_t{document.data(), document.size()};
+			auto const unshared_us = time([&] { unshared = apply_edits_sequentially(std::move(unshared), edits); });
+
+			auto batched = original;
+			auto const batched_us = time([&] { batched.apply_edits(edits); });
+
+			MESSAGE(edits.size() << " edits. sequential, shared: " << shared_us << "us, sequential, unshared: " << unshared_us << "us, batched: " << batched_us << "us");
+
+			CHECK(batched == shared);
+			CHECK(batched == unshared);
+		}
+	}
+}
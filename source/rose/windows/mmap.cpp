@@ -2,6 +2,7 @@
 
 using namespace rose;
 using rose::mmap_t;
+using rose::mmap_view_t;
 
 
 mmap_t::mmap_t(stdfs::path const& path, file_access_mask_t fam)
@@ -52,4 +53,38 @@ auto mmap_t::operator = (mmap_t&& rhs) -> mmap_t&
 auto mmap_t::valid() const -> bool
 {
 	return handle_ != INVALID_HANDLE_VALUE;
-}
\ No newline at end of file
+}
+
+
+mmap_view_t::mmap_view_t(mmap_t const& mmap)
+{
+	// an empty file can't be mapped, but then there's nothing to view
+	if (!mmap.valid() || mmap.size() == 0)
+		return;
+
+	data_ = MapViewOfFile(mmap.handle(), FILE_MAP_READ, 0, 0, 0);
+	if (data_)
+		size_ = mmap.size();
+}
+
+mmap_view_t::mmap_view_t(mmap_view_t&& rhs)
+	: data_{rhs.data_}
+	, size_{rhs.size_}
+{
+	rhs.data_ = nullptr;
+	rhs.size_ = 0;
+}
+
+mmap_view_t::~mmap_view_t()
+{
+	if (data_)
+		UnmapViewOfFile(data_);
+}
+
+auto mmap_view_t::operator = (mmap_view_t&& rhs) -> mmap_view_t&
+{
+	std::swap(data_, rhs.data_);
+	std::swap(size_, rhs.size_);
+
+	return *this;
+}